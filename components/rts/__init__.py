@@ -1,27 +1,213 @@
 import esphome.codegen as cg
 import esphome.config_validation as cv
-from esphome.components import remote_transmitter
-from esphome.components.remote_base import CONF_TRANSMITTER_ID
-from esphome.const import CONF_ID
+from esphome.components import remote_receiver, remote_transmitter, uart
+from esphome.components.remote_base import CONF_RECEIVER_ID, CONF_TRANSMITTER_ID
+from esphome.const import CONF_ID, PLATFORM_ESP32, PLATFORM_HOST
+from esphome.core import CORE
 
 rts_ns = cg.esphome_ns.namespace("rts")
 RTS = rts_ns.class_("RTS", cg.Component)
+RTSControlCode = RTS.enum("RTSControlCode")
+RTSUartInterface = rts_ns.class_("RTSUartInterface", cg.Component, uart.UARTDevice)
+
+QueueOverflowPolicy = RTS.enum("QueueOverflowPolicy")
+QUEUE_OVERFLOW_POLICIES = {
+    "REJECT_NEW": QueueOverflowPolicy.OVERFLOW_REJECT_NEW,
+    "DROP_OLDEST": QueueOverflowPolicy.OVERFLOW_DROP_OLDEST,
+    "COALESCE": QueueOverflowPolicy.OVERFLOW_COALESCE,
+}
+
+CONTROL_CODES = {
+    "STOP": RTSControlCode.STOP,
+    "OPEN": RTSControlCode.OPEN,
+    "CLOSE": RTSControlCode.CLOSE,
+    "PROGRAM": RTSControlCode.PROGRAM,
+}
+
+# Key with which covers refer to their RTS component.
+CONF_RTS_ID = "rts_id"
 
 CONFIG_COMMAND_REPETITIONS = "command_repetitions"
+CONFIG_MIN_COMMAND_REPETITIONS = "min_command_repetitions"
+CONFIG_MAX_COMMAND_REPETITIONS = "max_command_repetitions"
+CONFIG_AIRTIME_BUDGET_PERCENT = "airtime_budget_percent"
+CONFIG_AIRTIME_BUDGET_WINDOW = "airtime_budget_window"
+CONFIG_ROLLING_CODE_LEASE_SIZE = "rolling_code_lease_size"
+CONFIG_URGENT_CONTROL_CODES = "urgent_control_codes"
+CONFIG_QUEUE_CAPACITY = "queue_capacity"
+CONFIG_QUEUE_OVERFLOW_POLICY = "queue_overflow_policy"
+CONFIG_BURST_TRANSMIT = "burst_transmit"
+CONFIG_BURST_MAX_ITEMS = "burst_max_items"
+CONFIG_TRANSMIT_TASK = "transmit_task"
+CONFIG_CHANNEL_TABLE = "channel_table"
+CONFIG_TRANSMIT_TASK_CORE = "transmit_task_core"
+CONFIG_MAX_COMMAND_RETRIES = "max_command_retries"
+CONFIG_RETRY_BACKOFF = "retry_backoff"
+CONFIG_BOOT_RESTORE_DELAY = "boot_restore_delay"
+CONFIG_BOOT_RESTORE_BATCH_SIZE = "boot_restore_batch_size"
+CONFIG_BOOT_RESTORE_INTERVAL = "boot_restore_interval"
+CONFIG_TRACE_SIZE = "trace_size"
+CONFIG_PREDICTIVE_WAKEUP = "predictive_wakeup"
+CONFIG_PREWAKE_HOLD = "prewake_hold"
+CONFIG_PREWAKE_AIRTIME_PERCENT = "prewake_airtime_percent"
+CONFIG_TIMING_PROFILE = "timing_profile"
+CONFIG_CALIBRATION = "calibration"
+CONFIG_MARK_OVERHEAD = "mark_overhead"
+CONFIG_UART = "uart"
+CONFIG_MAX_PENDING_COMMANDS = "max_pending_commands"
+
+TIMING_PROFILES = ["SPEC", "ROUNDED"]
+
+def _validate_repetition_range(config):
+    repetitions = config[CONFIG_COMMAND_REPETITIONS]
+    if config.get(CONFIG_MIN_COMMAND_REPETITIONS, repetitions) > repetitions:
+        raise cv.Invalid(f"{CONFIG_MIN_COMMAND_REPETITIONS} must not exceed {CONFIG_COMMAND_REPETITIONS}")
+    if config.get(CONFIG_MAX_COMMAND_REPETITIONS, repetitions) < repetitions:
+        raise cv.Invalid(f"{CONFIG_MAX_COMMAND_REPETITIONS} must not be less than {CONFIG_COMMAND_REPETITIONS}")
+    return config
+
+def _validate_calibration(config):
+    transmitter_ids = [str(transmitter_id) for transmitter_id in config[CONF_TRANSMITTER_ID]]
+    calibrated = set()
+    for calibration in config[CONFIG_CALIBRATION]:
+        transmitter_id = str(calibration[CONF_TRANSMITTER_ID])
+        if transmitter_id not in transmitter_ids:
+            raise cv.Invalid(f"{CONFIG_CALIBRATION} refers to transmitter {transmitter_id} that RTS does not use")
+        if transmitter_id in calibrated:
+            raise cv.Invalid(f"{CONFIG_CALIBRATION} lists transmitter {transmitter_id} more than once")
+        calibrated.add(transmitter_id)
+    return config
+
+
+def _validate_transmit_task(config):
+    # Only checked when enabled, so that the default passes on every platform.
+    if config[CONFIG_TRANSMIT_TASK] and CORE.target_platform not in (PLATFORM_ESP32, PLATFORM_HOST):
+        raise cv.Invalid(f"{CONFIG_TRANSMIT_TASK} is only available on {PLATFORM_ESP32} and {PLATFORM_HOST}")
+    return config
 
-CONFIG_SCHEMA = cv.Schema(
+CONFIG_SCHEMA = cv.All(cv.Schema(
     {
         cv.GenerateID(): cv.declare_id(RTS),
-        cv.Required(CONF_TRANSMITTER_ID): cv.use_id(remote_transmitter.RemoteTransmitterComponent),
-        cv.Optional(CONFIG_COMMAND_REPETITIONS, default=2): cv.int_range(min=1,max=16)
+        cv.Required(CONF_TRANSMITTER_ID): cv.All(
+            cv.ensure_list(cv.use_id(remote_transmitter.RemoteTransmitterComponent)), cv.Length(min=1, max=8)
+        ),
+        cv.Optional(CONF_RECEIVER_ID): cv.use_id(remote_receiver.RemoteReceiverComponent),
+        cv.Optional(CONFIG_COMMAND_REPETITIONS, default=2): cv.int_range(min=1,max=16),
+        cv.Optional(CONFIG_MIN_COMMAND_REPETITIONS): cv.int_range(min=1, max=16),
+        cv.Optional(CONFIG_MAX_COMMAND_REPETITIONS): cv.int_range(min=1, max=16),
+        cv.Optional(CONFIG_AIRTIME_BUDGET_PERCENT): cv.All(cv.percentage_int, cv.Range(min=1, max=100)),
+        cv.Optional(CONFIG_AIRTIME_BUDGET_WINDOW, default="1h"): cv.All(
+            cv.positive_time_period_milliseconds, cv.Range(min=cv.TimePeriod(seconds=16))
+        ),
+        cv.Optional(CONFIG_ROLLING_CODE_LEASE_SIZE, default=1): cv.int_range(min=1,max=64),
+        cv.Optional(CONFIG_URGENT_CONTROL_CODES, default=["STOP"]): cv.ensure_list(
+            cv.enum(CONTROL_CODES, upper=True)
+        ),
+        cv.Optional(CONFIG_QUEUE_CAPACITY, default=32): cv.int_range(min=1, max=255),
+        cv.Optional(CONFIG_QUEUE_OVERFLOW_POLICY, default="REJECT_NEW"): cv.enum(
+            QUEUE_OVERFLOW_POLICIES, upper=True
+        ),
+        cv.Optional(CONFIG_BURST_TRANSMIT, default=False): cv.boolean,
+        cv.Optional(CONFIG_BURST_MAX_ITEMS, default=1024): cv.int_range(min=256, max=4096),
+        cv.Optional(CONFIG_MAX_COMMAND_RETRIES, default=3): cv.int_range(min=0, max=8),
+        cv.Optional(CONFIG_RETRY_BACKOFF, default="100ms"): cv.All(
+            cv.positive_time_period_milliseconds, cv.Range(min=cv.TimePeriod(milliseconds=10))
+        ),
+        cv.Optional(CONFIG_TRANSMIT_TASK, default=False): cv.boolean,
+        cv.Optional(CONFIG_TRANSMIT_TASK_CORE, default=1): cv.int_range(min=0, max=1),
+        cv.Optional(CONFIG_CHANNEL_TABLE, default=False): cv.boolean,
+        cv.Optional(CONFIG_BOOT_RESTORE_DELAY, default="5s"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONFIG_BOOT_RESTORE_BATCH_SIZE, default=8): cv.int_range(min=1, max=64),
+        cv.Optional(CONFIG_BOOT_RESTORE_INTERVAL, default="2s"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONFIG_TRACE_SIZE, default=32): cv.int_range(min=0, max=1024),
+        cv.Optional(CONFIG_PREDICTIVE_WAKEUP, default=False): cv.boolean,
+        cv.Optional(CONFIG_PREWAKE_HOLD, default="30s"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONFIG_PREWAKE_AIRTIME_PERCENT, default="1%"): cv.All(
+            cv.percentage_int, cv.Range(min=1, max=100)
+        ),
+        cv.Optional(CONFIG_TIMING_PROFILE, default="SPEC"): cv.one_of(*TIMING_PROFILES, upper=True),
+        cv.Optional(CONFIG_CALIBRATION, default=[]): cv.ensure_list(
+            cv.Schema(
+                {
+                    cv.Required(CONF_TRANSMITTER_ID): cv.use_id(remote_transmitter.RemoteTransmitterComponent),
+                    cv.Required(CONFIG_MARK_OVERHEAD): cv.int_range(min=-200, max=200),
+                }
+            )
+        ),
+        cv.Optional(CONFIG_UART): cv.Schema(
+            {
+                cv.GenerateID(): cv.declare_id(RTSUartInterface),
+                cv.Optional(CONFIG_MAX_PENDING_COMMANDS, default=64): cv.int_range(min=1, max=255),
+            }
+        ).extend(uart.UART_DEVICE_SCHEMA).extend(cv.COMPONENT_SCHEMA),
     }
-).extend(cv.COMPONENT_SCHEMA)
+).extend(cv.COMPONENT_SCHEMA), _validate_repetition_range, _validate_calibration, _validate_transmit_task)
 
 async def to_code(config):
     var = cg.new_Pvariable(config[CONF_ID])
     await cg.register_component(var, config)
 
-    transmitter = await cg.get_variable(config[CONF_TRANSMITTER_ID])
-    cg.add(var.set_transmitter(transmitter))
+    # Each cover adds its channel to the registry during setup, which gets allocated once for all
+    # of them.
+    num_covers = sum(
+        1
+        for cover_config in CORE.config.get("cover", [])
+        if cover_config.get("platform") == "rts" and cover_config[CONF_RTS_ID].id == config[CONF_ID].id
+    )
+    cg.add(var.reserve_channels(num_covers))
+
+    for transmitter_id in config[CONF_TRANSMITTER_ID]:
+        transmitter = await cg.get_variable(transmitter_id)
+        cg.add(var.add_transmitter(transmitter))
+    for calibration in config[CONFIG_CALIBRATION]:
+        transmitter = await cg.get_variable(calibration[CONF_TRANSMITTER_ID])
+        cg.add(var.set_mark_overhead(transmitter, calibration[CONFIG_MARK_OVERHEAD]))
+
+    if CONF_RECEIVER_ID in config:
+        receiver = await cg.get_variable(config[CONF_RECEIVER_ID])
+        cg.add(var.set_receiver(receiver))
+
+    repetitions = config[CONFIG_COMMAND_REPETITIONS]
+    cg.add(var.set_command_repetitions(repetitions))
+    cg.add(var.set_min_command_repetitions(config.get(CONFIG_MIN_COMMAND_REPETITIONS, repetitions)))
+    cg.add(var.set_max_command_repetitions(config.get(CONFIG_MAX_COMMAND_REPETITIONS, repetitions)))
+    if CONFIG_AIRTIME_BUDGET_PERCENT in config:
+        cg.add(var.set_airtime_budget(
+            config[CONFIG_AIRTIME_BUDGET_PERCENT],
+            config[CONFIG_AIRTIME_BUDGET_WINDOW].total_milliseconds,
+        ))
+    cg.add(var.set_rolling_code_lease_size(config[CONFIG_ROLLING_CODE_LEASE_SIZE]))
+    cg.add(var.set_urgent_control_codes(config[CONFIG_URGENT_CONTROL_CODES]))
+    cg.add(var.set_queue_capacity(config[CONFIG_QUEUE_CAPACITY]))
+    cg.add(var.set_queue_overflow_policy(config[CONFIG_QUEUE_OVERFLOW_POLICY]))
+    cg.add(var.set_burst_transmit(config[CONFIG_BURST_TRANSMIT]))
+    cg.add(var.set_burst_max_items(config[CONFIG_BURST_MAX_ITEMS]))
+    cg.add(var.set_max_command_retries(config[CONFIG_MAX_COMMAND_RETRIES]))
+    cg.add(var.set_retry_backoff(config[CONFIG_RETRY_BACKOFF].total_milliseconds))
+    cg.add(var.set_trace_size(config[CONFIG_TRACE_SIZE]))
+    cg.add(var.set_predictive_wakeup(config[CONFIG_PREDICTIVE_WAKEUP]))
+    cg.add(var.set_prewake_hold(config[CONFIG_PREWAKE_HOLD].total_milliseconds))
+    cg.add(var.set_prewake_airtime_percent(config[CONFIG_PREWAKE_AIRTIME_PERCENT]))
+
+    if config[CONFIG_CHANNEL_TABLE]:
+        cg.add(var.enable_channel_table())
+
+    cg.add(var.set_boot_restore_delay(config[CONFIG_BOOT_RESTORE_DELAY].total_milliseconds))
+    cg.add(var.set_boot_restore_batch_size(config[CONFIG_BOOT_RESTORE_BATCH_SIZE]))
+    cg.add(var.set_boot_restore_interval(config[CONFIG_BOOT_RESTORE_INTERVAL].total_milliseconds))
+
+    if config[CONFIG_TIMING_PROFILE] == "ROUNDED":
+        cg.add_define("USE_RTS_ROUNDED_TIMING")
+
+    if CONFIG_UART in config:
+        uart_config = config[CONFIG_UART]
+        cg.add_define("USE_RTS_UART")
+        interface = cg.new_Pvariable(uart_config[CONF_ID])
+        await cg.register_component(interface, uart_config)
+        await uart.register_uart_device(interface, uart_config)
+        cg.add(interface.set_rts_parent(var))
+        cg.add(interface.set_max_pending_commands(uart_config[CONFIG_MAX_PENDING_COMMANDS]))
 
-    cg.add(var.set_command_repetitions(config[CONFIG_COMMAND_REPETITIONS]))
+    if config[CONFIG_TRANSMIT_TASK]:
+        cg.add_define("USE_RTS_TRANSMIT_TASK")
+        cg.add(var.set_transmit_task_core(config[CONFIG_TRANSMIT_TASK_CORE]))
@@ -2,15 +2,29 @@ import esphome.codegen as cg
 import esphome.config_validation as cv
 from esphome import automation
 from esphome.automation import maybe_simple_id
-from esphome.components import cover
-from esphome.const import (CONF_ID, CONF_RESTORE_MODE)
-from .. import RTS, rts_ns
+from esphome.components import cover, remote_transmitter
+from esphome.components.remote_base import CONF_TRANSMITTER_ID
+from esphome.const import (
+    CONF_CLOSE_DURATION,
+    CONF_DURATION,
+    CONF_ID,
+    CONF_OPEN_DURATION,
+    CONF_RESTORE_MODE,
+    CONF_TRIGGER_ID,
+)
+from .. import CONF_RTS_ID, CONTROL_CODES, RTS, rts_ns
 
 DEPENDENCIES = ["rts"]
 
 RTSCover = rts_ns.class_("RTSCover", cover.Cover, cg.Component)
 ProgramAction = rts_ns.class_("ProgramAction", automation.Action)
 ConfigAction = rts_ns.class_("ConfigAction", automation.Action)
+HoldAction = rts_ns.class_("HoldAction", automation.Action)
+GroupCommandAction = rts_ns.class_("GroupCommandAction", automation.Action)
+DumpTraceAction = rts_ns.class_("DumpTraceAction", automation.Action)
+PrewakeAction = rts_ns.class_("PrewakeAction", automation.Action)
+TransmittedTrigger = rts_ns.class_("TransmittedTrigger", automation.Trigger.template())
+TransmitFailedTrigger = rts_ns.class_("TransmitFailedTrigger", automation.Trigger.template())
 
 RTSRestoreMode = rts_ns.enum("RTSRestoreMode")
 RESTORE_MODES = {
@@ -21,7 +35,13 @@ RESTORE_MODES = {
 
 CONF_CHANNEL_ID = "channel_id"
 CONF_ROLLING_CODE = "rolling_code"
-CONF_RTS_ID = "rts_id"
+CONF_COVERS = "covers"
+CONF_REMOTE_CHANNEL_IDS = "remote_channel_ids"
+CONF_CONTROL_CODE = "control_code"
+CONF_ON_TRANSMITTED = "on_transmitted"
+CONF_ON_TRANSMIT_FAILED = "on_transmit_failed"
+CONF_TILT_DURATION = "tilt_duration"
+CONF_FRAMES = "frames"
 
 CONFIG_SCHEMA = cover.COVER_SCHEMA.extend(
     {
@@ -30,6 +50,25 @@ CONFIG_SCHEMA = cover.COVER_SCHEMA.extend(
         cv.Optional(CONF_RESTORE_MODE, default="NO_RESTORE"): cv.enum(
             RESTORE_MODES, upper=True
         ),
+        cv.Optional(CONF_REMOTE_CHANNEL_IDS): cv.ensure_list(cv.hex_int_range(min=0, max=0xffffff)),
+        cv.Optional(CONF_TRANSMITTER_ID): cv.ensure_list(
+            cv.use_id(remote_transmitter.RemoteTransmitterComponent)
+        ),
+        cv.Inclusive(CONF_OPEN_DURATION, "travel_durations"): cv.All(
+            cv.positive_time_period_milliseconds, cv.Range(min=cv.TimePeriod(seconds=1))
+        ),
+        cv.Inclusive(CONF_CLOSE_DURATION, "travel_durations"): cv.All(
+            cv.positive_time_period_milliseconds, cv.Range(min=cv.TimePeriod(seconds=1))
+        ),
+        cv.Optional(CONF_TILT_DURATION): cv.All(
+            cv.positive_time_period_milliseconds, cv.Range(min=cv.TimePeriod(milliseconds=100))
+        ),
+        cv.Optional(CONF_ON_TRANSMITTED): automation.validate_automation(
+            {cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(TransmittedTrigger)}
+        ),
+        cv.Optional(CONF_ON_TRANSMIT_FAILED): automation.validate_automation(
+            {cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(TransmitFailedTrigger)}
+        ),
     }
 ).extend(cv.COMPONENT_SCHEMA)
 
@@ -41,6 +80,22 @@ async def to_code(config):
     paren = await cg.get_variable(config[CONF_RTS_ID])
     cg.add(var.set_rts_parent(paren))
     cg.add(var.set_restore_mode(config[CONF_RESTORE_MODE]))
+    for channel_id in config.get(CONF_REMOTE_CHANNEL_IDS, []):
+        cg.add(var.add_remote_channel_id(channel_id))
+    for transmitter_id in config.get(CONF_TRANSMITTER_ID, []):
+        transmitter = await cg.get_variable(transmitter_id)
+        cg.add(var.add_transmitter(transmitter))
+    if CONF_OPEN_DURATION in config:
+        cg.add(var.set_open_duration(config[CONF_OPEN_DURATION].total_milliseconds))
+        cg.add(var.set_close_duration(config[CONF_CLOSE_DURATION].total_milliseconds))
+    if CONF_TILT_DURATION in config:
+        cg.add(var.set_tilt_duration(config[CONF_TILT_DURATION].total_milliseconds))
+    for conf in config.get(CONF_ON_TRANSMITTED, []):
+        trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID], var)
+        await automation.build_automation(trigger, [], conf)
+    for conf in config.get(CONF_ON_TRANSMIT_FAILED, []):
+        trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID], var)
+        await automation.build_automation(trigger, [], conf)
 
 @automation.register_action(
     "rts.program",
@@ -56,6 +111,35 @@ async def rts_program_to_code(config, action_id, template_arg, args):
     var = cg.new_Pvariable(action_id, template_arg, paren)
     return var
 
+@automation.register_action(
+    "rts.hold",
+    HoldAction,
+    cv.All(
+        cv.Schema(
+            {
+                cv.Required(CONF_ID): cv.use_id(RTSCover),
+                cv.Required(CONF_CONTROL_CODE): cv.enum(
+                    {k: v for k, v in CONTROL_CODES.items() if k != "PROGRAM"}, upper=True
+                ),
+                cv.Optional(CONF_DURATION): cv.templatable(cv.positive_time_period_milliseconds),
+                cv.Optional(CONF_FRAMES): cv.templatable(cv.int_range(min=1, max=255)),
+            }
+        ),
+        cv.has_exactly_one_key(CONF_DURATION, CONF_FRAMES),
+    )
+)
+async def rts_hold_to_code(config, action_id, template_arg, args):
+    paren = await cg.get_variable(config[CONF_ID])
+    var = cg.new_Pvariable(action_id, template_arg, paren)
+    cg.add(var.set_control_code(config[CONF_CONTROL_CODE]))
+    if CONF_DURATION in config:
+        template_ = await cg.templatable(config[CONF_DURATION], args, cg.uint32)
+        cg.add(var.set_duration(template_))
+    if CONF_FRAMES in config:
+        template_ = await cg.templatable(config[CONF_FRAMES], args, int)
+        cg.add(var.set_frames(template_))
+    return var
+
 @automation.register_action(
     "rts.config_channel",
     ConfigAction,
@@ -77,3 +161,52 @@ async def rts_config_channel_to_code(config, action_id, template_arg, args):
         template_ = await cg.templatable(config[CONF_ROLLING_CODE], args, int)
         cg.add(var.set_rolling_code(template_))
     return var
+
+@automation.register_action(
+    "rts.group_command",
+    GroupCommandAction,
+    cv.Schema(
+        {
+            cv.GenerateID(CONF_RTS_ID): cv.use_id(RTS),
+            cv.Required(CONF_COVERS): cv.ensure_list(cv.use_id(RTSCover)),
+            cv.Required(CONF_CONTROL_CODE): cv.enum(
+                {k: v for k, v in CONTROL_CODES.items() if k != "PROGRAM"}, upper=True
+            ),
+        }
+    )
+)
+async def rts_group_command_to_code(config, action_id, template_arg, args):
+    paren = await cg.get_variable(config[CONF_RTS_ID])
+    var = cg.new_Pvariable(action_id, template_arg, paren)
+    covers = [await cg.get_variable(cover_id) for cover_id in config[CONF_COVERS]]
+    cg.add(var.set_covers(covers))
+    cg.add(var.set_control_code(config[CONF_CONTROL_CODE]))
+    return var
+
+@automation.register_action(
+    "rts.dump_trace",
+    DumpTraceAction,
+    cv.Schema(
+        {
+            cv.GenerateID(CONF_RTS_ID): cv.use_id(RTS),
+        }
+    )
+)
+async def rts_dump_trace_to_code(config, action_id, template_arg, args):
+    paren = await cg.get_variable(config[CONF_RTS_ID])
+    var = cg.new_Pvariable(action_id, template_arg, paren)
+    return var
+
+@automation.register_action(
+    "rts.prewake",
+    PrewakeAction,
+    cv.Schema(
+        {
+            cv.GenerateID(CONF_RTS_ID): cv.use_id(RTS),
+        }
+    )
+)
+async def rts_prewake_to_code(config, action_id, template_arg, args):
+    paren = await cg.get_variable(config[CONF_RTS_ID])
+    var = cg.new_Pvariable(action_id, template_arg, paren)
+    return var
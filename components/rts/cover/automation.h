@@ -1,5 +1,7 @@
 #pragma once
 
+#include <vector>
+
 #include "esphome/core/automation.h"
 #include "esphome/core/component.h"
 #include "esphome/core/optional.h"
@@ -18,6 +20,30 @@ template<typename... Ts> class ProgramAction : public Action<Ts...> {
   RTSCover *cover_;
 };
 
+template<typename... Ts> class HoldAction : public Action<Ts...> {
+ public:
+  explicit HoldAction(RTSCover *cover) : cover_(cover) {}
+
+  TEMPLATABLE_VALUE(uint32_t, duration)
+  TEMPLATABLE_VALUE(int, frames)
+
+  void set_control_code(RTS::RTSControlCode control_code) { control_code_ = control_code; }
+
+  void play(Ts... x) override {
+    uint8_t num_frames;
+    if (this->frames_.has_value()) {
+      num_frames = clamp(this->frames_.value(x...), 1, 255);
+    } else {
+      num_frames = RTS::hold_frames_for(this->duration_.value(x...));
+    }
+    cover_->send_hold_command(control_code_, num_frames);
+  }
+
+ protected:
+  RTSCover *cover_;
+  RTS::RTSControlCode control_code_{RTS::STOP};
+};
+
 template<typename... Ts> class ConfigAction : public Action<Ts...> {
  public:
   explicit ConfigAction(RTSCover *cover) : cover_(cover) {}
@@ -43,5 +69,75 @@ template<typename... Ts> class ConfigAction : public Action<Ts...> {
   RTSCover *cover_;
 };
 
+template<typename... Ts> class GroupCommandAction : public Action<Ts...> {
+ public:
+  explicit GroupCommandAction(RTS *rts) : rts_(rts) {}
+
+  void set_covers(const std::vector<RTSCover *> &covers) { covers_ = covers; }
+  void set_control_code(RTS::RTSControlCode control_code) { control_code_ = control_code; }
+
+  void play(Ts... x) override {
+    std::vector<RTSChannel *> rts_channels;
+    rts_channels.reserve(covers_.size());
+    for (auto *cover : covers_) {
+      rts_channels.push_back(&cover->rts_channel());
+    }
+
+    rts_->schedule_group_command(control_code_, rts_channels);
+
+    for (auto *cover : covers_) {
+      cover->publish_control_code_state(control_code_);
+    }
+  }
+
+ protected:
+  RTS *rts_;
+  std::vector<RTSCover *> covers_;
+  RTS::RTSControlCode control_code_{RTS::STOP};
+};
+
+template<typename... Ts> class DumpTraceAction : public Action<Ts...> {
+ public:
+  explicit DumpTraceAction(RTS *rts) : rts_(rts) {}
+
+  void play(Ts... x) override { rts_->dump_trace(); }
+
+ protected:
+  RTS *rts_;
+};
+
+template<typename... Ts> class PrewakeAction : public Action<Ts...> {
+ public:
+  explicit PrewakeAction(RTS *rts) : rts_(rts) {}
+
+  void play(Ts... x) override { rts_->prewake(); }
+
+ protected:
+  RTS *rts_;
+};
+
+class TransmittedTrigger : public Trigger<> {
+ public:
+  explicit TransmittedTrigger(RTSCover *cover) {
+    cover->add_on_command_done_callback([this](RTS::RTSControlCode control_code, RTS::CommandResult result) {
+      if (result == RTS::COMMAND_TRANSMITTED) {
+        this->trigger();
+      }
+    });
+  }
+};
+
+class TransmitFailedTrigger : public Trigger<> {
+ public:
+  explicit TransmitFailedTrigger(RTSCover *cover) {
+    // A superseded command is neither: the command that replaced it reports its own result.
+    cover->add_on_command_done_callback([this](RTS::RTSControlCode control_code, RTS::CommandResult result) {
+      if (result != RTS::COMMAND_TRANSMITTED && result != RTS::COMMAND_SUPERSEDED) {
+        this->trigger();
+      }
+    });
+  }
+};
+
 }  // namespace rts
 }  // namespace esphome
\ No newline at end of file
@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <cmath>
+
 #include "rts_cover.h"
 #include "esphome/core/log.h"
 
@@ -9,7 +12,18 @@ static const char *const TAG = "rts.cover";
 void RTSCover::setup() {
   ESP_LOGCONFIG(TAG, "Setting up RTS cover '%s'...", this->name_.c_str());
 
-  this->rts_channel_.init(this->get_object_id_hash(), this->name_);
+  this->rts_channel_.init(this->get_object_id_hash(), this->name_.c_str());
+  if (!this->transmitters_.empty()) {
+    this->rts_channel_.set_transmitter_mask(this->rts_parent_->transmitter_mask(this->transmitters_));
+
+    // The channel keeps the mask; the list is not needed after setup.
+    std::vector<remote_transmitter::RemoteTransmitterComponent *>().swap(this->transmitters_);
+  }
+
+  if (this->rts_parent_->has_receiver()) {
+    this->rts_parent_->add_on_frame_received_callback(
+        [this](const RTS::ReceivedFrame &frame) { this->on_frame_received(frame); });
+  }
 
   switch (this->restore_mode_) {
     case COVER_NO_RESTORE:
@@ -21,25 +35,110 @@ void RTSCover::setup() {
       break;
     }
     case COVER_RESTORE_AND_CALL: {
+      // The state is published right away, but the command that restores it is sent later, in a
+      // batch with those of the other covers.
       auto restore = this->restore_state_();
       if (restore.has_value()) {
-        restore->to_call(this).perform();
+        restore->apply(this);
+        if (this->position == cover::COVER_OPEN) {
+          this->rts_parent_->queue_boot_restore(RTS::OPEN, &this->rts_channel_);
+        } else if (this->position == cover::COVER_CLOSED) {
+          this->rts_parent_->queue_boot_restore(RTS::CLOSE, &this->rts_channel_);
+        } else {
+          // Reaching an intermediate position takes a movement from a known one, so the device is
+          // assumed to still be where it was.
+          ESP_LOGI(TAG, "RTS cover '%s' restored position %.0f%% without sending a command", this->name_.c_str(),
+                   this->position * 100.0f);
+        }
+        if (this->tilt_duration_millis_ != 0) {
+          ESP_LOGI(TAG, "RTS cover '%s' restored tilt %.0f%% without sending a command", this->name_.c_str(),
+                   this->tilt * 100.0f);
+        }
       }
       break;
     }
   }
+
+  // The loop only tracks movements, and runs while one is in progress.
+  this->disable_loop();
+}
+
+void RTSCover::loop() {
+  if (this->current_operation == cover::COVER_OPERATION_IDLE) {
+    this->disable_loop();
+    return;
+  }
+
+  uint32_t now = millis();
+  float position = this->estimated_position_(now);
+  bool reached_end = (this->current_operation == cover::COVER_OPERATION_OPENING && position >= cover::COVER_OPEN) ||
+                     (this->current_operation == cover::COVER_OPERATION_CLOSING && position <= cover::COVER_CLOSED);
+  if (reached_end) {
+    this->end_movement_(now);
+    this->publish_state();
+  } else if (now - this->last_publish_millis_ >= 1000) {
+    this->position = position;
+    this->publish_state();
+    this->last_publish_millis_ = now;
+  }
+}
+
+void RTSCover::on_safe_shutdown() {
+  this->rts_channel_.release_rolling_code_lease();
+
+  // Shutdown hooks of other components may sync preferences before RTS gets to flush.
+  this->rts_parent_->flush_channel_table();
 }
 
 void RTSCover::dump_config() {
   LOG_COVER("", "RTS Cover", this);
   ESP_LOGCONFIG(TAG, "  RTS Cover:");
+  for (uint32_t channel_id : this->remote_channel_ids_) {
+    ESP_LOGCONFIG(TAG, "    Following remote on channel 0x%x", channel_id);
+  }
+  if (this->rts_channel_.transmitter_mask() != 0) {
+    ESP_LOGCONFIG(TAG, "    Transmitter mask: 0x%02x", this->rts_channel_.transmitter_mask());
+  }
+  if (this->has_position_model_()) {
+    ESP_LOGCONFIG(TAG, "    Open duration: %ums", this->open_duration_millis_);
+    ESP_LOGCONFIG(TAG, "    Close duration: %ums", this->close_duration_millis_);
+  }
+  if (this->tilt_duration_millis_ != 0) {
+    ESP_LOGCONFIG(TAG, "    Tilt duration: %ums", this->tilt_duration_millis_);
+  }
+  ESP_LOGCONFIG(TAG, "    Memory: %zu bytes, plus %zu bytes of channel state", sizeof(RTSCover),
+                RTSChannelRegistry::bytes_per_channel());
+}
+
+void RTSCover::on_frame_received(const RTS::ReceivedFrame &frame) {
+  if (frame.channel_id == this->rts_channel_.id()) {
+    // Frames from this cover's own transmissions always carry a rolling code below the next value.
+    // Anything else comes from another remote using the same channel id, which pushes the device's
+    // rolling code ahead of this cover's.
+    if (static_cast<uint16_t>(frame.rolling_code - this->rts_channel_.rolling_code()) < 0x8000) {
+      ESP_LOGW(TAG, "Another remote is transmitting on the channel of RTS cover '%s' with rolling code %u",
+               this->name_.c_str(), frame.rolling_code);
+      ESP_LOGW(TAG, "  Commands from this cover will be ignored until its rolling code passes %u; see the "
+                    "rts.config_channel action",
+               frame.rolling_code);
+    }
+    return;
+  }
+
+  for (uint32_t channel_id : this->remote_channel_ids_) {
+    if (frame.channel_id == channel_id) {
+      ESP_LOGD(TAG, "RTS cover '%s' following remote command 0x%x", this->name_.c_str(), frame.control_code);
+      this->publish_control_code_state(frame.control_code);
+      return;
+    }
+  }
 }
 
 cover::CoverTraits RTSCover::get_traits() {
   cover::CoverTraits traits;
   traits.set_is_assumed_state(true);
-  traits.set_supports_position(false);
-  traits.set_supports_tilt(false);
+  traits.set_supports_position(this->has_position_model_());
+  traits.set_supports_tilt(this->tilt_duration_millis_ != 0);
   traits.set_supports_toggle(false);
   traits.set_supports_stop(true);
   return traits;
@@ -54,8 +153,28 @@ void RTSCover::send_program_command() {
   this->rts_parent_->schedule_rts_command(RTS::PROGRAM, &this->rts_channel_, 2 /* Max repetitions */);
 }
 
+void RTSCover::send_hold_command(RTS::RTSControlCode control_code, uint8_t num_frames) {
+  ESP_LOGD(TAG, "RTS cover '%s' holding control code 0x%x for %u frames (%ums)", this->name_.c_str(), control_code,
+           num_frames, RTS::hold_duration_millis(num_frames));
+  this->rts_parent_->schedule_hold_command(control_code, &this->rts_channel_, num_frames);
+}
+
 void RTSCover::control(const cover::CoverCall &call) {
+  auto tilt = call.get_tilt();
+  if (tilt.has_value() && this->tilt_duration_millis_ != 0) {
+    this->tilt_to_(*tilt);
+    if (!call.get_position().has_value() && !call.get_stop()) {
+      this->publish_state();
+      return;
+    }
+  }
+
   auto position = call.get_position();
+  if (position.has_value() && this->has_position_model_()) {
+    this->start_movement_(*position, true);
+    return;
+  }
+
   RTS::RTSControlCode control_code;
   if (position && *position == cover::COVER_OPEN) {
     control_code = RTS::OPEN;
@@ -65,6 +184,10 @@ void RTSCover::control(const cover::CoverCall &call) {
     this->position = cover::COVER_CLOSED;
   } else if (call.get_stop()) {
     control_code = RTS::STOP;
+    if (this->current_operation != cover::COVER_OPERATION_IDLE) {
+      // The device keeps moving until the STOP frame reaches it.
+      this->end_movement_(millis() + this->rts_parent_->urgent_reaction_millis());
+    }
   } else {
     ESP_LOGE(TAG, "Invalid call to RTS cover component: 0x%x", control_code);
     return;
@@ -75,5 +198,167 @@ void RTSCover::control(const cover::CoverCall &call) {
   this->publish_state();
 }
 
+void RTSCover::publish_control_code_state(RTS::RTSControlCode control_code) {
+  if (this->has_position_model_()) {
+    if (control_code == RTS::OPEN) {
+      this->start_movement_(cover::COVER_OPEN, false);
+    } else if (control_code == RTS::CLOSE) {
+      this->start_movement_(cover::COVER_CLOSED, false);
+    } else if (control_code == RTS::STOP && this->current_operation != cover::COVER_OPERATION_IDLE) {
+      this->end_movement_(millis());
+      this->publish_state();
+    }
+    return;
+  }
+
+  if (control_code == RTS::OPEN) {
+    this->position = cover::COVER_OPEN;
+  } else if (control_code == RTS::CLOSE) {
+    this->position = cover::COVER_CLOSED;
+  }
+
+  this->publish_state();
+}
+
+void RTSCover::tilt_to_(float target) {
+  float delta = target - this->tilt;
+  if (std::fabs(delta) < 0.01f) {
+    return;
+  }
+
+  // Streams are whole frames long, so the reported tilt is the one that the stream actually reaches.
+  uint8_t num_frames = RTS::hold_frames_for(std::fabs(delta) * this->tilt_duration_millis_);
+  float step = static_cast<float>(RTS::hold_duration_millis(num_frames)) / this->tilt_duration_millis_;
+  this->rts_parent_->schedule_hold_command(delta > 0 ? RTS::OPEN : RTS::CLOSE, &this->rts_channel_, num_frames);
+  this->tilt = clamp(this->tilt + (delta > 0 ? step : -step), cover::COVER_CLOSED, cover::COVER_OPEN);
+}
+
+void RTSCover::start_movement_(float target, bool send_command) {
+  uint32_t now = millis();
+  float current = this->estimated_position_(now);
+  this->cancel_timeout("stop_movement");
+
+  bool is_end_position = target == cover::COVER_OPEN || target == cover::COVER_CLOSED;
+  if (!is_end_position && std::fabs(target - current) < 0.01f) {
+    this->end_movement_(now);
+    this->publish_state();
+    return;
+  }
+
+  bool opening = target == cover::COVER_OPEN || (target != cover::COVER_CLOSED && target > current);
+  auto operation = opening ? cover::COVER_OPERATION_OPENING : cover::COVER_OPERATION_CLOSING;
+  if (this->current_operation != operation) {
+    // A device that is idle starts, and one that moves the other way reverses, once it receives the
+    // new command. Until the command reports when its first frame actually went out, that time is
+    // estimated from the recent queueing latency for the reported position, while the STOP for an
+    // intermediate target waits for the report.
+    this->movement_start_position_ = current;
+    this->current_operation = operation;
+    this->enable_loop();
+    if (send_command) {
+      RTS::CommandHandle handle = this->rts_parent_->schedule_rts_command(opening ? RTS::OPEN : RTS::CLOSE,
+                                                                          &this->rts_channel_);
+      this->movement_handle_ = handle;
+      this->movement_start_millis_ =
+          now + this->rts_parent_->command_latency_millis(50) + RTS::frame_duration_millis();
+      auto callback = [](void *context, RTS::CommandHandle handle, RTS::CommandResult result, uint32_t start_millis) {
+        static_cast<RTSCover *>(context)->on_movement_command_done_(handle, result, start_millis);
+      };
+      if (!this->rts_parent_->on_command_done(handle, callback, this)) {
+        // The command was rejected without a result to wait for.
+        this->on_movement_command_done_(handle, RTS::COMMAND_REJECTED, 0);
+        return;
+      }
+    } else {
+      this->movement_handle_ = 0;
+      this->movement_start_millis_ = now;
+    }
+  }
+
+  this->movement_target_position_ = target;
+  this->position = current;
+  this->schedule_stop_();
+  this->publish_state();
+  this->last_publish_millis_ = now;
+}
+
+void RTSCover::on_movement_command_done_(RTS::CommandHandle handle, RTS::CommandResult result,
+                                         uint32_t start_millis) {
+  if (handle != this->movement_handle_) {
+    return;
+  }
+
+  if (start_millis == 0) {
+    // No frame went out, so the device never started moving.
+    ESP_LOGW(TAG, "RTS cover '%s' did not start moving", this->name_.c_str());
+    this->cancel_timeout("stop_movement");
+    this->position = this->movement_start_position_;
+    this->current_operation = cover::COVER_OPERATION_IDLE;
+    this->movement_handle_ = 0;
+    this->publish_state();
+    return;
+  }
+
+  this->movement_start_millis_ = start_millis + RTS::frame_duration_millis();
+  this->movement_handle_ = 0;
+  this->schedule_stop_();
+}
+
+void RTSCover::schedule_stop_() {
+  float target = this->movement_target_position_;
+  if (target == cover::COVER_OPEN || target == cover::COVER_CLOSED) {
+    // The device stops by itself at the end of its travel.
+    return;
+  }
+  if (this->movement_handle_ != 0) {
+    // The movement command has not reported when it went out yet. A STOP sent before it would take
+    // its place in the queue, and the device would never move.
+    return;
+  }
+
+  uint32_t duration_millis = this->current_operation == cover::COVER_OPERATION_OPENING ? this->open_duration_millis_
+                                                                                        : this->close_duration_millis_;
+  uint32_t arrival_millis =
+      this->movement_start_millis_ + std::fabs(target - this->movement_start_position_) * duration_millis;
+
+  // The STOP command is scheduled early by the time that urgent commands currently take to reach
+  // devices, so that it lands when the cover arrives even while the transmitter is busy.
+  int32_t stop_in_millis =
+      static_cast<int32_t>(arrival_millis - this->rts_parent_->urgent_reaction_millis() - millis());
+  this->set_timeout("stop_movement", std::max<int32_t>(stop_in_millis, 0), [this]() {
+    this->rts_parent_->schedule_rts_command(RTS::STOP, &this->rts_channel_);
+    this->position = this->movement_target_position_;
+    this->current_operation = cover::COVER_OPERATION_IDLE;
+    this->movement_handle_ = 0;
+    this->publish_state();
+  });
+}
+
+void RTSCover::end_movement_(uint32_t at_millis) {
+  this->cancel_timeout("stop_movement");
+  this->position = this->estimated_position_(at_millis);
+  this->current_operation = cover::COVER_OPERATION_IDLE;
+  this->movement_handle_ = 0;
+}
+
+float RTSCover::estimated_position_(uint32_t now) const {
+  if (this->current_operation == cover::COVER_OPERATION_IDLE) {
+    return this->position;
+  }
+
+  int32_t elapsed_millis = static_cast<int32_t>(now - this->movement_start_millis_);
+  if (elapsed_millis <= 0) {
+    return this->movement_start_position_;
+  }
+
+  float position;
+  if (this->current_operation == cover::COVER_OPERATION_OPENING) {
+    position = this->movement_start_position_ + static_cast<float>(elapsed_millis) / this->open_duration_millis_;
+  } else {
+    position = this->movement_start_position_ - static_cast<float>(elapsed_millis) / this->close_duration_millis_;
+  }
+  return clamp(position, cover::COVER_CLOSED, cover::COVER_OPEN);
+}
+
 }  // namespace rts
 }  // namespace esphome
@@ -7,6 +7,7 @@
 #include "esphome/core/helpers.h"
 #include "esphome/core/optional.h"
 #include "esphome/core/preferences.h"
+#include <vector>
 #include "../rts.h"
 #include "../rts_channel.h"
 
@@ -22,25 +23,103 @@ enum RTSRestoreMode {
 class RTSCover : public cover::Cover, public Component {
  public:
   void setup() override final;
+  void loop() override final;
   void dump_config() override final;
+  void on_safe_shutdown() override final;
   cover::CoverTraits get_traits() override final;
 
   void send_program_command();
 
-  void set_rts_parent(RTS *rts_parent) { rts_parent_ = rts_parent; }
+  // Holds the control code for the given number of frames, like a long press on a remote.
+  void send_hold_command(RTS::RTSControlCode control_code, uint8_t num_frames);
+
+  // Updates the assumed cover state for a command that was scheduled without going through
+  // control(), e.g. as part of a group command.
+  void publish_control_code_state(RTS::RTSControlCode control_code);
+
+  void set_rts_parent(RTS *rts_parent) {
+    rts_parent_ = rts_parent;
+    rts_channel_.set_registry(&rts_parent->channel_registry());
+  }
   void set_restore_mode(RTSRestoreMode restore_mode) { restore_mode_ = restore_mode; }
 
+  // Travel times from fully closed to fully open and back. With both set, the cover estimates its
+  // position from how long it has been moving, and moves to intermediate positions by sending STOP
+  // when the device is expected to reach them.
+  void set_open_duration(uint32_t open_duration_millis) { open_duration_millis_ = open_duration_millis; }
+  void set_close_duration(uint32_t close_duration_millis) { close_duration_millis_ = close_duration_millis; }
+
+  // Time that OPEN or CLOSE must be held to turn the slats of a venetian blind from fully closed to
+  // fully open. When set, the cover supports tilt, and tilts by holding OPEN or CLOSE for the
+  // corresponding fraction of this time.
+  void set_tilt_duration(uint32_t tilt_duration_millis) { tilt_duration_millis_ = tilt_duration_millis; }
+
+  // Commands that the RTS receiver decodes on any of these channels, e.g. from a wall remote paired
+  // with the same device, update this cover's state.
+  void add_remote_channel_id(uint32_t channel_id) { remote_channel_ids_.push_back(channel_id); }
+
+  // Restricts this cover's commands to the given RTS transmitters, e.g. the ones within range of
+  // its device. Without any, commands go out on every transmitter.
+  void add_transmitter(remote_transmitter::RemoteTransmitterComponent *transmitter) {
+    transmitters_.push_back(transmitter);
+  }
+
   RTSChannel &rts_channel() { return rts_channel_; }
 
+  // Called with the control code and result of each command sent on this cover's channel, once the
+  // last repetition is out or the command is given up.
+  void add_on_command_done_callback(std::function<void(RTS::RTSControlCode, RTS::CommandResult)> &&callback) {
+    rts_parent_->add_on_command_done_callback(
+        [this, callback = std::move(callback)](RTS::CommandHandle handle, uint32_t channel_id,
+                                               RTS::RTSControlCode control_code, RTS::CommandResult result) {
+          if (channel_id == this->rts_channel_.id()) {
+            callback(control_code, result);
+          }
+        });
+  }
+
  protected:
   void control(const cover::CoverCall &call) override final;
 
+  void on_frame_received(const RTS::ReceivedFrame &frame);
+
+  // Holds OPEN or CLOSE to turn the slats from the current tilt towards the target.
+  void tilt_to_(float target);
+
+  bool has_position_model_() const { return open_duration_millis_ != 0 && close_duration_millis_ != 0; }
+
+  // Starts tracking a movement towards the target position. If send_command is set, also sends the
+  // command that starts it; otherwise the device is assumed to have started already.
+  void start_movement_(float target, bool send_command);
+  void on_movement_command_done_(RTS::CommandHandle handle, RTS::CommandResult result, uint32_t start_millis);
+
+  // Schedules the STOP command that ends the movement at an intermediate target position, once the
+  // command that started the movement has gone out.
+  void schedule_stop_();
+
+  // Ends the movement in progress at the position it reaches at the given time.
+  void end_movement_(uint32_t at_millis);
+
+  // Position of the movement in progress at the given time.
+  float estimated_position_(uint32_t now) const;
+
   RTSRestoreMode restore_mode_{COVER_NO_RESTORE};
 
   RTS *rts_parent_;
   RTSChannel rts_channel_;
+  std::vector<uint32_t> remote_channel_ids_;
+  std::vector<remote_transmitter::RemoteTransmitterComponent *> transmitters_;
+
+  uint32_t open_duration_millis_{0};
+  uint32_t close_duration_millis_{0};
+  uint32_t tilt_duration_millis_{0};
 
-  CallbackManager<void(uint32_t, uint16_t)> channel_update_callback_{};
+  // The movement in progress, which devices are expected to have started at movement_start_millis.
+  float movement_start_position_{0.0f};
+  float movement_target_position_{0.0f};
+  uint32_t movement_start_millis_{0};
+  uint32_t last_publish_millis_{0};
+  RTS::CommandHandle movement_handle_{0};
 };
 
 }  // namespace rts
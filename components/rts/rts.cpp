@@ -1,8 +1,8 @@
 #include <array>
-#include <iomanip>
-#include <sstream>
-
+#include <cinttypes>
+#include <cstdio>
 #include "rts.h"
+#include "esphome/core/hal.h"
 #include "esphome/core/log.h"
 
 /**
@@ -51,8 +51,6 @@ class RTSPacketBody {
 
   const Data &encoded_data() const { return encoded_data_; }
   const Data &obfuscated_data() const { return obfuscated_data_; }
-  std::string encoded_data_as_string_() const { return data_to_string(encoded_data_); }
-  std::string obfuscated_data_as_string_() const { return data_to_string(obfuscated_data_); }
 
  private:
   // Each RTS packet begins with an "encryption key" whose purpose is unclear. Tested devices work
@@ -61,39 +59,452 @@ class RTSPacketBody {
   // the obfuscation encoding.
   static constexpr uint8_t default_nonce = 0xa7;
 
-  static std::string data_to_string(const Data &data) {
-    std::ostringstream stream;
-    stream << std::hex << std::setfill('0') << std::setw(2) << static_cast<int>(data[0]);
-    for (size_t i = 1; i < data.size(); i++) {
-      stream << " " << std::setfill('0') << std::setw(2) << static_cast<int>(data[i]);
-    }
-    return stream.str();
-  }
-
   Data encoded_data_;
   Data obfuscated_data_;
 };
 
 }  // namespace
 
+#if defined(USE_RTS_TRANSMIT_TASK) && !defined(USE_ESP32)
+RTS::~RTS() {
+  for (auto &tx : this->transmitters_) {
+    {
+      std::lock_guard<std::mutex> lock(tx->task_mutex);
+      tx->task_stopping = true;
+    }
+    tx->task_condition.notify_one();
+    if (tx->task_thread.joinable()) {
+      tx->task_thread.join();
+    }
+  }
+}
+#endif
+
+void RTS::setup() {
+#ifdef USE_RTS_TRANSMIT_TASK
+  for (auto &tx : this->transmitters_) {
+    tx->rts = this;
+#ifdef USE_ESP32
+    xTaskCreatePinnedToCore(
+        [](void *transmitter) {
+          auto *tx = static_cast<Transmitter *>(transmitter);
+          tx->rts->run_transmit_task(*tx);
+        },
+        "rts_transmit", transmit_task_stack_size, tx.get(), transmit_task_priority, &tx->task_handle,
+        this->transmit_task_core_);
+#else
+    Transmitter *transmitter = tx.get();
+    tx->task_thread = std::thread([this, transmitter]() { this->run_transmit_task(*transmitter); });
+#endif
+  }
+#endif
+}
+
+void RTS::loop() {
+  this->flush_channel_table();
+  this->report_done_commands();
+}
+
+void RTS::on_shutdown() { this->flush_channel_table(); }
+
 void RTS::dump_config() {
   ESP_LOGCONFIG(TAG, "RTS:");
   ESP_LOGCONFIG(TAG, "  Number of times to repeat commands: %d", this->command_repetitions_);
+  if (this->min_command_repetitions_ != this->command_repetitions_ ||
+      this->max_command_repetitions_ != this->command_repetitions_) {
+    ESP_LOGCONFIG(TAG, "  Adapting repetitions to load: %d to %d", this->min_command_repetitions_,
+                  this->max_command_repetitions_);
+  }
+  if (this->airtime_budget_percent_ != 0) {
+    ESP_LOGCONFIG(TAG, "  Airtime budget: %u%% of every %ums per transmitter", this->airtime_budget_percent_,
+                  this->airtime_budget_window_millis_);
+  }
+  ESP_LOGCONFIG(TAG, "  Rolling code lease size: %u", this->channel_registry_.rolling_code_lease_size());
+  ESP_LOGCONFIG(TAG, "  Channels: %zu, with %zu bytes of state each", this->channel_registry_.size(),
+                RTSChannelRegistry::bytes_per_channel());
+  if (this->channel_registry_.has_channel_table()) {
+    ESP_LOGCONFIG(TAG, "  Channel table: %zu blocks of %zu channels", this->channel_registry_.channel_table_blocks(),
+                  RTSChannelTable::entries_per_block);
+  }
+  ESP_LOGCONFIG(TAG, "  Urgent control codes: 0x%04x", this->urgent_control_codes_);
+  ESP_LOGCONFIG(TAG, "  Transmitters: %zu, each with a queue of %zu commands of %zu bytes", this->transmitters_.size(),
+                this->queue_capacity_, sizeof(ScheduledCommand));
+  ESP_LOGCONFIG(TAG, "  Retrying failed commands up to %u times, after %ums", this->max_command_retries_,
+                this->retry_backoff_millis_);
+  ESP_LOGCONFIG(TAG, "  Boot restore: after %ums, %zu channels every %ums", this->boot_restore_delay_millis_,
+                this->boot_restore_batch_size_, this->boot_restore_interval_millis_);
+  if (this->predictive_wakeup_) {
+    ESP_LOGCONFIG(TAG, "  Predictive wakeup: keeping devices awake for %ums, with up to %u%% of airtime",
+                  this->prewake_hold_millis_, this->prewake_airtime_percent_);
+  }
+  if (this->trace_size_ != 0) {
+    ESP_LOGCONFIG(TAG, "  Trace: last %zu frames per transmitter, %zu bytes each", this->trace_size_,
+                  sizeof(RTSTraceBuffer::Entry));
+  }
+#ifdef USE_RTS_ROUNDED_TIMING
+  ESP_LOGCONFIG(TAG, "  Timing profile: rounded");
+#else
+  ESP_LOGCONFIG(TAG, "  Timing profile: spec");
+#endif
+  for (size_t i = 0; i < this->transmitters_.size(); i++) {
+    if (this->transmitters_[i]->mark_overhead_micros != 0) {
+      ESP_LOGCONFIG(TAG, "  Transmitter %zu mark overhead: %" PRId32 "us", i,
+                    this->transmitters_[i]->mark_overhead_micros);
+    }
+  }
+  if (this->burst_transmit_) {
+    ESP_LOGCONFIG(TAG, "  Transmitting commands in single bursts of up to %zu items", this->burst_max_items_);
+  }
+#ifdef USE_RTS_TRANSMIT_TASK
+  ESP_LOGCONFIG(TAG, "  Transmitting from dedicated tasks on core %d", this->transmit_task_core_);
+#endif
+}
+
+void RTS::dump_trace() {
+  static const char *const frame_kinds[] = {"full sync", "short sync", "wakeup"};
+
+  for (size_t i = 0; i < this->transmitters_.size(); i++) {
+    const auto &trace = this->transmitters_[i]->trace;
+    ESP_LOGI(TAG, "RTS trace of transmitter %zu: %" PRIu32 " frames sent, last %zu kept", i, trace.num_recorded(),
+             trace.capacity());
+    trace.for_each([](const RTSTraceBuffer::Entry &entry) {
+      // Decoding happens here, so that recording a frame costs no more than copying a few bytes.
+      char frame[3 * std::tuple_size<Payload>::value] = "";
+      if (entry.kind != RTSTraceBuffer::FRAME_WAKEUP) {
+        Payload payload = encode_payload(static_cast<RTSControlCode>(entry.control_code), entry.channel_id,
+                                         entry.rolling_code);
+        for (size_t j = 0; j < payload.size(); j++) {
+          size_t offset = j == 0 ? 0 : 3 * j - 1;
+          snprintf(frame + offset, sizeof(frame) - offset, j == 0 ? "%02x" : " %02x", payload[j]);
+        }
+      }
+      ESP_LOGI(TAG, "  %10" PRIu32 "ms channel 0x%06x code 0x%x rolling code %5u repetition %u/%u %-10s %s",
+               entry.millis, entry.channel_id, entry.control_code, entry.rolling_code, entry.repetition + 1,
+               entry.num_repetitions, frame_kinds[entry.kind], frame);
+    });
+  }
+}
+
+void RTS::add_transmitter(remote_transmitter::RemoteTransmitterComponent *transmitter) {
+  if (this->transmitters_.size() >= max_transmitters) {
+    ESP_LOGE(TAG, "RTS supports at most %zu transmitters", max_transmitters);
+    return;
+  }
+
+  std::unique_ptr<Transmitter> tx(new Transmitter());
+  tx->transmitter = transmitter;
+  this->init_transmitter_(*tx);
+  this->transmitters_.push_back(std::move(tx));
+  this->init_pending_commands_();
+}
+
+void RTS::set_mark_overhead(remote_transmitter::RemoteTransmitterComponent *transmitter,
+                            int32_t mark_overhead_micros) {
+  for (auto &tx : this->transmitters_) {
+    if (tx->transmitter == transmitter) {
+      tx->mark_overhead_micros = mark_overhead_micros;
+      tx->frame_timings_valid = false;
+      return;
+    }
+  }
+  ESP_LOGE(TAG, "Cannot calibrate a transmitter that RTS does not use");
+}
+
+void RTS::init_transmitter_(Transmitter &tx) {
+  tx.scheduled_commands.init(this->queue_capacity_);
+  tx.airtime_window.set_window_millis(this->airtime_budget_window_millis_);
+  tx.prewake_airtime_window.set_window_millis(this->airtime_budget_window_millis_);
+  tx.trace.init(this->trace_size_);
+#ifdef USE_RTS_TRANSMIT_TASK
+  tx.inbox.init(this->queue_capacity_);
+#endif
+}
+
+uint8_t RTS::transmitter_mask(const std::vector<remote_transmitter::RemoteTransmitterComponent *> &transmitters) const {
+  uint8_t mask = 0;
+  for (auto *transmitter : transmitters) {
+    bool found = false;
+    for (size_t i = 0; i < this->transmitters_.size(); i++) {
+      if (this->transmitters_[i]->transmitter == transmitter) {
+        mask |= 1 << i;
+        found = true;
+      }
+    }
+    if (!found) {
+      ESP_LOGE(TAG, "Transmitter is not configured for the RTS component");
+    }
+  }
+  return mask;
+}
+
+RTS::CommandHandle RTS::schedule_command(RTSControlCode control_code, RTSChannel *rts_channel, int num_repetitions,
+                                         int max_repetitions, bool hold) {
+  CommandHandle handle = this->new_command_handle(control_code, rts_channel->id());
+  if (handle == 0) {
+    ESP_LOGW(TAG, "Too many pending RTS commands; rejecting command 0x%x on channel 0x%x", control_code,
+             rts_channel->id());
+    this->queue_overflow_count_++;
+    return 0;
+  }
+
+#ifdef USE_RTS_TRANSMIT_TASK
+  // The command gets its rolling code value before any task sees it, either taken over from a
+  // command that it supersedes or newly consumed, and goes to the tasks once the value is saved.
+  PendingCommand *withdrawn = nullptr;
+  if (!hold) {
+    withdrawn = this->withdraw_pending_command_(control_code, rts_channel->id(), handle);
+  }
+  if (withdrawn == nullptr || control_code != STOP) {
+    optional<uint16_t> rolling_code;
+    if (withdrawn != nullptr) {
+      rolling_code = withdrawn->rolling_code;
+    }
+    auto command =
+        this->make_command(control_code, rts_channel, num_repetitions, max_repetitions, handle, rolling_code);
+    command.hold = hold;
+    this->find_pending_command_(handle)->hold = hold;
+    this->flush_channel_table();
+    this->submit_to_transmit_tasks_(rts_channel, command);
+  }
+#else
+  // Each transmitter that reaches the channel gets its own copy of the command, all with the same
+  // rolling code value, which is consumed at most once.
+  optional<ScheduledCommand> command;
+  for (size_t i = 0; i < this->transmitters_.size(); i++) {
+    if (!this->channel_uses_transmitter_(*rts_channel, i)) {
+      continue;
+    }
+    auto &tx = *this->transmitters_[i];
+    this->add_command_copy(handle);
+
+    if (!hold && this->coalesce_pending_command(tx, control_code, rts_channel->id(), num_repetitions, max_repetitions,
+                                                handle)) {
+      continue;
+    }
+
+    if (!this->make_room_in_queue(tx, this->is_urgent_control_code(control_code))) {
+      ESP_LOGW(TAG, "RTS transmission queue is full; rejecting command 0x%x on channel 0x%x", control_code,
+               rts_channel->id());
+      this->note_command_done(tx, handle, COMMAND_REJECTED);
+      continue;
+    }
+
+    if (!command.has_value()) {
+      command = this->make_command(control_code, rts_channel, num_repetitions, max_repetitions, handle);
+      command->hold = hold;
+    }
+    this->enqueue_command(tx, *command);
+    this->schedule_transmit_task(tx);
+  }
+
+  // A new rolling code lease is saved before any frame that uses it goes out.
+  this->flush_channel_table();
+#endif
+  if (this->predictive_wakeup_) {
+    this->prewake();
+  }
+  return handle;
+}
+
+void RTS::schedule_group_command(RTSControlCode control_code, const std::vector<RTSChannel *> &rts_channels,
+                                 int max_repetitions) {
+  int num_repetitions = std::min(this->command_repetitions_, max_repetitions);
+
+  // Group id 0 is reserved for commands that are not part of a group.
+  if (++this->last_group_id_ == 0) {
+    this->last_group_id_ = 1;
+  }
+
+  uint32_t num_grouped = 0;
+  for (auto *rts_channel : rts_channels) {
+    CommandHandle handle = this->new_command_handle(control_code, rts_channel->id());
+    if (handle == 0) {
+      ESP_LOGW(TAG, "Too many pending RTS commands; rejecting group command 0x%x on channel 0x%x", control_code,
+               rts_channel->id());
+      this->queue_overflow_count_++;
+      continue;
+    }
+
+#ifdef USE_RTS_TRANSMIT_TASK
+    PendingCommand *withdrawn = this->withdraw_pending_command_(control_code, rts_channel->id(), handle);
+    if (withdrawn != nullptr && control_code == STOP) {
+      continue;
+    }
+    optional<uint16_t> rolling_code;
+    if (withdrawn != nullptr) {
+      rolling_code = withdrawn->rolling_code;
+    }
+    auto command = this->make_command(control_code, rts_channel, num_repetitions, max_repetitions, handle, rolling_code);
+    command.group_id = this->last_group_id_;
+    this->group_commands_.push_back({rts_channel, command});
+    num_grouped++;
+#else
+    optional<ScheduledCommand> command;
+    for (size_t i = 0; i < this->transmitters_.size(); i++) {
+      if (!this->channel_uses_transmitter_(*rts_channel, i)) {
+        continue;
+      }
+      auto &tx = *this->transmitters_[i];
+      this->add_command_copy(handle);
+
+      if (this->coalesce_pending_command(tx, control_code, rts_channel->id(), num_repetitions, max_repetitions,
+                                         handle)) {
+        continue;
+      }
+
+      if (!this->make_room_in_queue(tx, this->is_urgent_control_code(control_code))) {
+        ESP_LOGW(TAG, "RTS transmission queue is full; rejecting group command 0x%x on channel 0x%x", control_code,
+                 rts_channel->id());
+        this->note_command_done(tx, handle, COMMAND_REJECTED);
+        continue;
+      }
+
+      if (!command.has_value()) {
+        command = this->make_command(control_code, rts_channel, num_repetitions, max_repetitions, handle);
+        command->group_id = this->last_group_id_;
+        num_grouped++;
+      }
+      this->enqueue_command(tx, *command);
+    }
+#endif
+  }
+
+  ESP_LOGD(TAG, "Scheduled group command 0x%x on %u channels", control_code, num_grouped);
+  // The rolling code leases of the whole group are saved in one go, before any of its frames goes out.
+  this->flush_channel_table();
+#ifdef USE_RTS_TRANSMIT_TASK
+  for (auto &group_command : this->group_commands_) {
+    this->submit_to_transmit_tasks_(group_command.rts_channel, group_command.command);
+  }
+  this->group_commands_.clear();
+#else
+  for (auto &tx : this->transmitters_) {
+    this->schedule_transmit_task(*tx);
+  }
+#endif
+  if (this->predictive_wakeup_) {
+    this->prewake();
+  }
+}
+
+void RTS::prewake() {
+  this->prewake_until_millis_ = millis() + this->prewake_hold_millis_;
+  if (!this->is_prewake_active_) {
+    this->is_prewake_active_ = true;
+    this->request_prewake_();
+  }
+}
+
+void RTS::request_prewake_() {
+  if (static_cast<int32_t>(millis() - this->prewake_until_millis_) >= 0) {
+    this->is_prewake_active_ = false;
+    return;
+  }
+
+  for (auto &tx : this->transmitters_) {
+    tx->prewake_requested = true;
+#ifdef USE_RTS_TRANSMIT_TASK
+    this->notify_transmit_task(*tx);
+#else
+    this->schedule_transmit_task(*tx);
+#endif
+  }
+
+  // Devices that were woken up by a command in the meantime are left alone by the next request.
+  this->set_timeout("prewake", wakeup_cooldown_millis - prewake_lead_millis, [this]() { this->request_prewake_(); });
 }
 
-void RTS::schedule_rts_command(RTSControlCode control_code, RTSChannel *rts_channel, int max_repetitions) {
+void RTS::queue_boot_restore(RTSControlCode control_code, RTSChannel *rts_channel) {
+  if (this->boot_restore_commands_.empty()) {
+    this->set_timeout("boot_restore", this->boot_restore_delay_millis_, [this]() { this->send_boot_restore_batch_(); });
+  }
+  this->boot_restore_commands_.push_back({control_code, rts_channel});
+}
+
+void RTS::send_boot_restore_batch_() {
+  size_t end = std::min(this->next_boot_restore_command_ + this->boot_restore_batch_size_,
+                        this->boot_restore_commands_.size());
+
+  // Channels restoring to the same state share a group command. The rest of the batch follows in
+  // further group commands, which the transmitters send right after.
+  std::vector<RTSChannel *> rts_channels;
+  for (size_t i = this->next_boot_restore_command_; i < end; i++) {
+    RTSControlCode control_code = this->boot_restore_commands_[i].control_code;
+    bool is_sent = false;
+    for (size_t j = this->next_boot_restore_command_; j < i; j++) {
+      is_sent |= this->boot_restore_commands_[j].control_code == control_code;
+    }
+    if (is_sent) {
+      continue;
+    }
+
+    rts_channels.clear();
+    for (size_t j = i; j < end; j++) {
+      if (this->boot_restore_commands_[j].control_code == control_code) {
+        rts_channels.push_back(this->boot_restore_commands_[j].rts_channel);
+      }
+    }
+    this->schedule_group_command(control_code, rts_channels);
+  }
+
+  this->next_boot_restore_command_ = end;
+  size_t remaining = this->boot_restore_commands_.size() - end;
+  ESP_LOGD(TAG, "Sent boot restore batch; %zu channels remaining", remaining);
+  if (remaining > 0) {
+    this->set_timeout("boot_restore", this->boot_restore_interval_millis_,
+                      [this]() { this->send_boot_restore_batch_(); });
+  } else {
+    std::vector<BootRestoreCommand>().swap(this->boot_restore_commands_);
+    this->next_boot_restore_command_ = 0;
+  }
+}
+
+RTS::ScheduledCommand RTS::make_command(RTSControlCode control_code, RTSChannel *rts_channel, int num_repetitions,
+                                       int max_repetitions, CommandHandle handle, optional<uint16_t> rolling_code) {
   ScheduledCommand command;
   command.control_code = control_code;
   command.channel_id = rts_channel->id();
-  command.rolling_code = rts_channel->consume_rolling_code_value();
-  command.num_repetitions = std::min(this->command_repetitions_, max_repetitions);
+  command.rolling_code = rolling_code.has_value() ? *rolling_code : rts_channel->consume_rolling_code_value();
+  command.num_repetitions = num_repetitions;
   command.num_completed_repetitions = 0;
-  this->scheduled_commands_.push(command);
+  command.max_repetitions = std::min(max_repetitions, UINT8_MAX);
+  command.urgent = this->is_urgent_control_code(control_code);
+  command.hold = false;
+  command.group_id = 0;
+  command.enqueue_millis = millis();
+  command.airtime_micros = 0;
+  command.handle = handle;
+  command.start_millis = 0;
+  command.num_failures = 0;
+  command.retry_millis = 0;
+  command.queue_depth = 0;
+  command.payload = encode_payload(command.control_code, command.channel_id, command.rolling_code);
+
+  PendingCommand *pending = this->find_pending_command_(handle);
+  if (pending != nullptr) {
+    pending->rolling_code = command.rolling_code;
+  }
+  return command;
+}
+
+void RTS::schedule_transmit_task(Transmitter &tx) {
+  if (tx.scheduled_commands.empty() && !tx.prewake_requested) {
+    return;
+  }
 
-  if (!this->is_transmit_task_scheduled_) {
+  if (!tx.is_transmit_task_scheduled) {
     ESP_LOGD(TAG, "Scheduling RTS transmission handler");
-    this->defer([this]() { this->process_one_scheduled_command(); });
-    this->is_transmit_task_scheduled_ = true;
+    tx.drain_start_millis = millis();
+    tx.drain_airtime_micros = 0;
+    uint32_t run = tx.handler_run;
+    this->defer([this, &tx, run]() { this->process_one_scheduled_command(tx, run); });
+    tx.is_transmit_task_scheduled = true;
+  } else if (tx.last_run_waited && !tx.scheduled_commands.empty() && tx.scheduled_commands.front().urgent) {
+    // An urgent command does not sit out a wait for the airtime budget or a retry, which can last
+    // minutes. The handler starts over, and the run that is waiting returns without transmitting.
+    ESP_LOGV(TAG, "Restarting RTS transmission handler for urgent command");
+    uint32_t run = ++tx.handler_run;
+    this->defer([this, &tx, run]() { this->process_one_scheduled_command(tx, run); });
   } else {
     // The already scheduled transmission handler will reschedule itself to handle newly enqueued
     // commands.
@@ -101,114 +512,992 @@ void RTS::schedule_rts_command(RTSControlCode control_code, RTSChannel *rts_chan
   }
 }
 
-void RTS::process_one_scheduled_command(bool abbreviated_sync) {
-  if (this->scheduled_commands_.empty()) {
-    this->is_transmit_task_scheduled_ = false;
-    ESP_LOGD(TAG, "Completed all scheduled RTS commands");
+bool RTS::coalesce_pending_command(Transmitter &tx, RTSControlCode control_code, uint32_t channel_id,
+                                   int num_repetitions, int max_repetitions, CommandHandle handle) {
+  if (control_code != STOP && !is_coalescible_control_code(control_code)) {
+    return false;
+  }
+
+  // Only the newest pending command on the channel is a candidate. Merging into an older one would
+  // reorder the new command ahead of commands that must precede it.
+  for (size_t i = tx.scheduled_commands.size(); i-- > 0;) {
+    auto &pending = tx.scheduled_commands[i];
+    if (pending.channel_id != channel_id) {
+      continue;
+    }
+
+    if (pending.num_completed_repetitions > 0 || pending.hold || !is_coalescible_control_code(pending.control_code)) {
+      return false;
+    }
+#ifdef USE_RTS_TRANSMIT_TASK
+    // The main loop already decided, and the new command carries the pending one's rolling code.
+    if (this->command_claim_(pending.handle) != CLAIM_WITHDRAWN) {
+      return false;
+    }
+#endif
+
+    ESP_LOGD(TAG, "Coalescing RTS command on channel 0x%x: control code 0x%x superseded by 0x%x", channel_id,
+             pending.control_code, control_code);
+    this->note_command_done(tx, pending.handle, COMMAND_SUPERSEDED);
+    this->coalesced_command_count_++;
+
+    // The cover never started moving, so the STOP is done without using up a rolling code value.
+    if (control_code == STOP) {
+      this->note_command_done(tx, handle, COMMAND_TRANSMITTED);
+      tx.scheduled_commands.erase(i);
+      return true;
+    }
+
+    // The merged command leaves the queue while its repetitions get adapted like those of any new
+    // command.
+    ScheduledCommand merged = pending;
+    tx.scheduled_commands.erase(i);
+    merged.control_code = control_code;
+    merged.num_repetitions = num_repetitions;
+    merged.max_repetitions = std::min(max_repetitions, UINT8_MAX);
+    merged.payload = encode_payload(control_code, channel_id, merged.rolling_code);
+    merged.handle = handle;
+
+    // A pending command that becomes urgent moves forward. One that was already urgent keeps its
+    // place, even if the new control code is not urgent.
+    if (!merged.urgent && this->is_urgent_control_code(control_code)) {
+      merged.urgent = true;
+      this->enqueue_command(tx, merged);
+    } else {
+      merged.num_repetitions = this->adapt_repetitions(tx, merged);
+      tx.scheduled_commands.insert(i, merged);
+    }
+    return true;
+  }
+
+  return false;
+}
+
+void RTS::accept_command(Transmitter &tx, const ScheduledCommand &command) {
+  if (!command.hold && this->coalesce_pending_command(tx, command.control_code, command.channel_id,
+                                                      command.num_repetitions, command.max_repetitions,
+                                                      command.handle)) {
+    return;
+  }
+
+  if (!this->make_room_in_queue(tx, command.urgent)) {
+    ESP_LOGW(TAG, "RTS transmission queue is full; rejecting command 0x%x on channel 0x%x", command.control_code,
+             command.channel_id);
+    this->note_command_done(tx, command.handle, COMMAND_REJECTED);
     return;
-  } else if (this->failure_observed_) {
-    this->is_transmit_task_scheduled_ = false;
-    this->failure_observed_ = false;
-    ESP_LOGE(TAG, "Canceling scheduled RTS commands");
-    this->scheduled_commands_ = {};
+  }
+
+  if (tx.scheduled_commands.empty()) {
+    tx.drain_start_millis = millis();
+    tx.drain_airtime_micros = 0;
+  }
+  this->enqueue_command(tx, command);
+}
+
+void RTS::enqueue_command(Transmitter &tx, const ScheduledCommand &scheduled_command) {
+  ScheduledCommand command = scheduled_command;
+  command.num_repetitions = this->adapt_repetitions(tx, command);
+  if (command.num_repetitions != scheduled_command.num_repetitions) {
+    ESP_LOGV(TAG, "Adapted repetitions of RTS command on channel 0x%x from %d to %d", command.channel_id,
+             scheduled_command.num_repetitions, command.num_repetitions);
+  }
+
+  if (!command.urgent) {
+    tx.scheduled_commands.push_back(command);
     return;
   }
 
+  // Urgent commands wait for a streaming hold to end, so that its parts follow each other without a
+  // gap. One for the hold's own channel ends the stream instead.
+  size_t position = 0;
+  if (!tx.scheduled_commands.empty()) {
+    const auto &front = tx.scheduled_commands.front();
+    if (front.hold && front.num_completed_repetitions > 0 && front.channel_id == command.channel_id) {
+      ESP_LOGD(TAG, "Urgent RTS command ends hold on channel 0x%x after %u of %u frames", command.channel_id,
+               front.num_completed_repetitions, front.num_repetitions);
+      this->note_command_done(tx, front, COMMAND_SUPERSEDED);
+      tx.scheduled_commands.pop_front();
+    } else if (front.hold && front.num_completed_repetitions > 0) {
+      position = 1;
+    }
+  }
+
+  while (position < tx.scheduled_commands.size() && tx.scheduled_commands[position].urgent) {
+    position++;
+  }
+  if (position == 0 && !tx.scheduled_commands.empty() &&
+      tx.scheduled_commands.front().num_completed_repetitions > 0) {
+    ESP_LOGD(TAG, "Urgent RTS command on channel 0x%x preempts command on channel 0x%x", command.channel_id,
+             tx.scheduled_commands.front().channel_id);
+  }
+  tx.scheduled_commands.insert(position, command);
+}
+
+uint8_t RTS::adapt_repetitions(Transmitter &tx, const ScheduledCommand &command) {
+  int num_repetitions = command.num_repetitions;
+  if (command.control_code == PROGRAM || command.hold) {
+    return num_repetitions;
+  }
+
+  int floor = std::min(this->min_command_repetitions_, num_repetitions);
+  if (command.urgent) {
+    floor = num_repetitions;
+  }
+
+  // An idle transmitter spends more repetitions on the command, but never more than its caller
+  // allows.
+  size_t num_waiting = tx.scheduled_commands.size();
+  if (num_waiting == 0) {
+    num_repetitions = std::max(num_repetitions, std::min<int>(this->max_command_repetitions_, command.max_repetitions));
+  } else {
+    num_repetitions = std::max(num_repetitions - static_cast<int>(num_waiting), floor);
+  }
+
+  uint32_t remaining_micros = this->remaining_airtime_budget_micros(tx);
+  if (remaining_micros != UINT32_MAX) {
+    uint32_t queued_micros = 0;
+    for (size_t i = 0; i < tx.scheduled_commands.size(); i++) {
+      const auto &pending = tx.scheduled_commands[i];
+      queued_micros += (pending.num_repetitions - pending.num_completed_repetitions) * frame_airtime_upper_bound_micros;
+    }
+    uint32_t available_micros = remaining_micros > queued_micros ? remaining_micros - queued_micros : 0;
+    int affordable_repetitions = available_micros / frame_airtime_upper_bound_micros;
+    num_repetitions = std::max(std::min(num_repetitions, affordable_repetitions), floor);
+  }
+
+  return num_repetitions;
+}
+
+uint32_t RTS::remaining_airtime_budget_micros(Transmitter &tx) {
+  if (this->airtime_budget_percent_ == 0) {
+    return UINT32_MAX;
+  }
+
+  uint64_t budget_micros = uint64_t(tx.airtime_window.window_millis()) * 1000 * this->airtime_budget_percent_ / 100;
+  uint64_t used_micros = tx.airtime_window.used_micros(millis());
+  return used_micros < budget_micros ? std::min<uint64_t>(budget_micros - used_micros, UINT32_MAX - 1) : 0;
+}
+
+void RTS::record_airtime(Transmitter &tx, uint32_t micros) {
+  tx.drain_airtime_micros += micros;
+  if (this->airtime_budget_percent_ != 0) {
+    tx.airtime_window.add(millis(), micros);
+  }
+}
+
+bool RTS::make_room_in_queue(Transmitter &tx, bool urgent) {
+  if (!tx.scheduled_commands.full()) {
+    return true;
+  }
+
+  this->queue_overflow_count_++;
+
+  // An urgent command always gets in as long as there is a non-urgent command to displace, so the
+  // newest non-urgent command is a fallback victim under any policy.
+  optional<size_t> victim;
+  for (size_t i = 0; i < tx.scheduled_commands.size(); i++) {
+    const auto &pending = tx.scheduled_commands[i];
+    if (pending.urgent) {
+      continue;
+    }
+
+    if (this->queue_overflow_policy_ == OVERFLOW_DROP_OLDEST) {
+      victim = i;
+      break;
+    } else if (this->queue_overflow_policy_ == OVERFLOW_COALESCE && pending.num_completed_repetitions > 0) {
+      victim = i;
+      break;
+    } else if (urgent) {
+      victim = i;
+    }
+  }
+
+  if (!victim.has_value()) {
+    return false;
+  }
+
+  const auto &dropped = tx.scheduled_commands[*victim];
+  ESP_LOGW(TAG, "RTS transmission queue is full; dropping command 0x%x on channel 0x%x after %u of %u repetitions",
+           dropped.control_code, dropped.channel_id, dropped.num_completed_repetitions, dropped.num_repetitions);
+  this->note_command_done(tx, dropped, COMMAND_DROPPED);
+  tx.scheduled_commands.erase(*victim);
+  return true;
+}
+
+RTS::Payload RTS::encode_payload(RTSControlCode control_code, uint32_t channel_id, uint16_t rolling_code) {
+  // The transmitted bytes of each frame can be recovered from the trace; see dump_trace().
+  return RTSPacketBody(control_code, channel_id, rolling_code).obfuscated_data();
+}
+
+void RTS::process_one_scheduled_command(Transmitter &tx, uint32_t run, bool abbreviated_sync) {
+  if (run != tx.handler_run) {
+    return;
+  }
+
+  auto transmission_delay = this->transmit_next_frame(tx, abbreviated_sync);
+  if (!transmission_delay.has_value()) {
+    tx.is_transmit_task_scheduled = false;
+    return;
+  }
+
+  this->set_timeout(*transmission_delay,
+                    [this, &tx, run]() { this->process_one_scheduled_command(tx, run, true); });
+}
+
+optional<uint32_t> RTS::transmit_next_frame(Transmitter &tx, bool abbreviated_sync) {
+  // Abbreviated sync relies on a wakeup signal or frame right before, which a wait does not send.
+  abbreviated_sync = abbreviated_sync && !tx.last_run_waited;
+  tx.last_run_waited = false;
+
+  // Queued commands bring their own wakeup, if they need one.
+  if (tx.prewake_requested.exchange(false) && tx.scheduled_commands.empty()) {
+    auto transmission_delay = this->transmit_prewake(tx);
+    if (transmission_delay.has_value()) {
+      return transmission_delay;
+    }
+  }
+
+  if (tx.scheduled_commands.empty()) {
+    ESP_LOGD(TAG, "Completed all scheduled RTS commands in %ums (%uus of airtime)",
+             millis() - tx.drain_start_millis, tx.drain_airtime_micros);
+    return {};
+  }
+
+  uint32_t retry_wait_millis;
+  if (!this->select_ready_command(tx, &retry_wait_millis)) {
+    ESP_LOGV(TAG, "All RTS commands are waiting to be retried; waiting %ums", retry_wait_millis);
+    tx.last_run_waited = true;
+    return retry_wait_millis;
+  }
+
+  auto &next_command = tx.scheduled_commands.front();
+  bool is_streaming = next_command.hold && next_command.num_completed_repetitions > 0;
+  if (!next_command.urgent && !is_streaming && this->remaining_airtime_budget_micros(tx) == 0) {
+    uint32_t wait_millis = tx.airtime_window.millis_until_next_bucket(millis());
+    ESP_LOGD(TAG, "RTS airtime budget used up; waiting %ums", wait_millis);
+    tx.last_run_waited = true;
+    return wait_millis;
+  }
+
+  // The queue depth is sampled on every frame, and each command reports the deepest queue that its
+  // frames went out with.
+  next_command.queue_depth = std::max<size_t>(next_command.queue_depth, tx.scheduled_commands.size());
+
+  if (next_command.hold) {
+    if (!this->claim_front_command_(tx)) {
+      return 0;
+    }
+    return this->transmit_hold(tx, next_command, abbreviated_sync);
+  }
+
+  if (this->burst_transmit_ && next_command.num_completed_repetitions == 0 && next_command.group_id == 0) {
+    bool include_wakeup = this->needs_wakeup(tx);
+    size_t burst_items = burst_items_upper_bound(next_command.num_repetitions, include_wakeup);
+    if (burst_items <= this->burst_max_items_) {
+      if (!this->claim_front_command_(tx)) {
+        return 0;
+      }
+      if (next_command.num_failures == 0) {
+        this->note_command_started(tx, next_command, include_wakeup);
+      }
+      uint32_t transmission_delay =
+          this->transmit_burst(tx, next_command, next_command.num_repetitions, include_wakeup,
+                               abbreviated_sync || include_wakeup);
+      if (tx.failure_observed) {
+        this->handle_transmit_failure(tx);
+        return transmission_delay;
+      }
+      this->note_command_done(tx, next_command, COMMAND_TRANSMITTED);
+      tx.scheduled_commands.pop_front();
+      return transmission_delay;
+    }
+    ESP_LOGV(TAG, "Burst for channel 0x%x needs up to %zu items; transmitting frames separately",
+             next_command.channel_id, burst_items);
+  }
+
   uint32_t transmission_delay = 0;
-  if (this->needs_wakeup_) {
-    ESP_LOGD(TAG, "Transmitting wakeup signal");
-    transmission_delay = this->transmit_wakeup();
+  if (this->needs_wakeup(tx)) {
+    ESP_LOGV(TAG, "Transmitting wakeup signal");
+    transmission_delay = this->transmit_wakeup(tx);
+
+    // The wakeup signal belongs to the command that it precedes.
+    if (tx.failure_observed) {
+      this->handle_transmit_failure(tx);
+    }
   } else {
-    auto &command = this->scheduled_commands_.front();
+    if (!this->claim_front_command_(tx)) {
+      return 0;
+    }
+    auto &command = tx.scheduled_commands.front();
 
-    if (command.num_completed_repetitions == 0) {
-      ESP_LOGD(TAG, "Transmitting RTS command -- Control code: 0x%x, Channel id: 0x%x, Rolling code value: %d",
-               command.control_code, command.channel_id, command.rolling_code);
+    // A retried command was already counted when it first started.
+    if (command.num_completed_repetitions == 0 && command.num_failures == 0) {
+      this->note_command_started(tx, command, tx.last_transmission_was_wakeup);
     } else {
       ESP_LOGV(TAG, "Repeating RTS command on channel 0x%x", command.channel_id);
     }
 
-    transmission_delay =
-        this->transmit_command(command.control_code, command.channel_id, command.rolling_code, abbreviated_sync);
+    // The first frame of a group gets full sync unless a wakeup precedes it. The frames after it
+    // follow each other closely enough for abbreviated sync.
+    transmission_delay = this->transmit_command(tx, command, abbreviated_sync);
+
+    if (tx.failure_observed) {
+      this->handle_transmit_failure(tx);
+    } else if (++command.num_completed_repetitions >= command.num_repetitions) {
+      this->note_command_done(tx, command, COMMAND_TRANSMITTED);
+      tx.scheduled_commands.pop_front();
+    } else if (command.group_id != 0) {
+      // Rotate the command behind the rest of its group, so the next frame goes to the next channel.
+      size_t group_size = 1;
+      while (group_size < tx.scheduled_commands.size() &&
+             tx.scheduled_commands[group_size].group_id == command.group_id) {
+        group_size++;
+      }
+      tx.scheduled_commands.rotate_front(group_size);
+    }
+  }
+
+  return transmission_delay;
+}
+
+bool RTS::claim_front_command_(Transmitter &tx) {
+#ifdef USE_RTS_TRANSMIT_TASK
+  auto &command = tx.scheduled_commands.front();
+  uint8_t claim = CLAIM_OPEN;
+  if (this->command_claim_(command.handle).compare_exchange_strong(claim, CLAIM_STARTED) || claim == CLAIM_STARTED) {
+    return true;
+  }
+
+  // The command that took over the rolling code value, or the STOP that cancelled this one,
+  // supersedes it, even if that did not reach this queue. Nothing was sent, so the next frame does
+  // not count on abbreviated sync.
+  ESP_LOGD(TAG, "Dropping withdrawn RTS command 0x%x on channel 0x%x", command.control_code, command.channel_id);
+  this->note_command_done(tx, command, COMMAND_SUPERSEDED);
+  this->coalesced_command_count_++;
+  tx.scheduled_commands.pop_front();
+  tx.last_run_waited = true;
+  return false;
+#else
+  return true;
+#endif
+}
+
+uint32_t RTS::transmit_hold(Transmitter &tx, ScheduledCommand &command, bool abbreviated_sync) {
+  bool include_wakeup = command.num_completed_repetitions == 0 && this->needs_wakeup(tx);
+  int num_frames = std::min<int>(command.num_repetitions - command.num_completed_repetitions, hold_part_frames);
+  while (num_frames > 1 && burst_items_upper_bound(num_frames, include_wakeup) > this->burst_max_items_) {
+    num_frames--;
+  }
+
+  if (command.num_completed_repetitions == 0 && command.num_failures == 0) {
+    this->note_command_started(tx, command, include_wakeup);
+  }
+
+  // Consecutive parts of the stream directly follow each other, so they continue with abbreviated
+  // sync, as the frames within a part do.
+  abbreviated_sync = abbreviated_sync && command.num_completed_repetitions > 0;
+  uint32_t transmission_delay = this->transmit_burst(tx, command, num_frames, include_wakeup, abbreviated_sync);
+  if (tx.failure_observed) {
+    this->handle_transmit_failure(tx);
+    return transmission_delay;
+  }
+
+  command.num_completed_repetitions += num_frames;
+  if (command.num_completed_repetitions >= command.num_repetitions) {
+    this->note_command_done(tx, command, COMMAND_TRANSMITTED);
+    tx.scheduled_commands.pop_front();
+  }
+  return transmission_delay;
+}
+
+bool RTS::select_ready_command(Transmitter &tx, uint32_t *wait_millis) {
+  uint32_t now = millis();
+  optional<uint32_t> shortest_wait;
+  for (size_t i = 0; i < tx.scheduled_commands.size(); i++) {
+    const auto &command = tx.scheduled_commands[i];
+    int32_t remaining = static_cast<int32_t>(command.retry_millis - now);
+    if (command.num_failures == 0 || remaining <= 0) {
+      if (i > 0) {
+        ScheduledCommand ready = command;
+        tx.scheduled_commands.erase(i);
+        tx.scheduled_commands.insert(0, ready);
+      }
+      return true;
+    }
+    if (!shortest_wait.has_value() || static_cast<uint32_t>(remaining) < *shortest_wait) {
+      shortest_wait = remaining;
+    }
+  }
+
+  // The transmit task cannot take new commands while it waits, so it checks back at least once per
+  // base backoff.
+  *wait_millis = std::min(*shortest_wait, this->retry_backoff_millis_);
+  return false;
+}
+
+void RTS::handle_transmit_failure(Transmitter &tx) {
+  tx.failure_observed = false;
+  ScheduledCommand command = tx.scheduled_commands.front();
+  tx.scheduled_commands.pop_front();
+
+  if (++command.num_failures > this->max_command_retries_) {
+    ESP_LOGE(TAG, "Giving up RTS command 0x%x on channel 0x%x after %u failed transmissions", command.control_code,
+             command.channel_id, command.num_failures);
+    this->cancelled_command_count_++;
+    this->note_command_done(tx, command, COMMAND_CANCELLED);
+    return;
+  }
+
+  uint32_t backoff_millis = this->retry_backoff_millis_ << (command.num_failures - 1);
+  ESP_LOGW(TAG, "Failed to transmit RTS command 0x%x on channel 0x%x; retrying in %ums", command.control_code,
+           command.channel_id, backoff_millis);
+  command.retry_millis = millis() + backoff_millis;
+
+  // The retry goes out on its own, since the rest of its group has moved on.
+  command.group_id = 0;
+
+  // The command keeps its rolling code value, and goes behind the other commands of the same
+  // urgency.
+  size_t position = tx.scheduled_commands.size();
+  if (command.urgent) {
+    position = 0;
+    while (position < tx.scheduled_commands.size() && tx.scheduled_commands[position].urgent) {
+      position++;
+    }
+  }
+  tx.scheduled_commands.insert(position, command);
+}
+
+void RTS::note_command_started(Transmitter &tx, ScheduledCommand &command, bool after_wakeup) {
+  command.start_millis = millis();
+  uint32_t latency_millis = command.start_millis - command.enqueue_millis;
+  ESP_LOGV(TAG, "Transmitting RTS command 0x%x on channel 0x%x after %ums in queue", command.control_code,
+           command.channel_id, latency_millis);
+  if (after_wakeup) {
+    this->wakeups_sent_++;
+  } else {
+    this->wakeups_skipped_++;
+    // Without the prewake, only the first command after it would have needed a wakeup; the ones
+    // that follow would have skipped theirs anyway.
+    if (tx.last_wakeup_was_prewake) {
+      this->prewake_latency_saved_millis_ += wakeup_signal_high_micros / 1000 + wakeup_signal_low_millis;
+      tx.last_wakeup_was_prewake = false;
+    }
+  }
+}
+
+void RTS::init_pending_commands_() {
+  this->pending_commands_capacity_ = 2 * this->queue_capacity_ * std::max<size_t>(this->transmitters_.size(), 1);
+  this->pending_commands_.reset(new PendingCommand[this->pending_commands_capacity_]());
+  this->num_pending_commands_ = 0;
+#ifdef USE_RTS_TRANSMIT_TASK
+  // Each pending command has at most one copy on each transmitter, so the outbox has room for the
+  // result of every copy that has not been resolved yet.
+  for (auto &tx : this->transmitters_) {
+    tx->outbox.init(this->pending_commands_capacity_);
+  }
+  this->command_claims_.reset(new std::atomic<uint8_t>[this->pending_commands_capacity_]());
+#endif
+}
+
+RTS::CommandHandle RTS::new_command_handle(RTSControlCode control_code, uint32_t channel_id) {
+  PendingCommand *pending = this->find_pending_command_(0);
+  if (pending == nullptr) {
+    return 0;
+  }
+
+  // Handles stay below UINT32_MAX, so that the slot can be recovered from them, and skip 0.
+  size_t slot = pending - this->pending_commands_.get();
+  uint32_t num_sequences = UINT32_MAX / this->pending_commands_capacity_;
+  pending->sequence = ++this->last_command_sequence_;
+  pending->handle = (pending->sequence % num_sequences) * this->pending_commands_capacity_ + slot + 1;
+  pending->channel_id = channel_id;
+  pending->control_code = control_code;
+  pending->num_copies = 0;
+  pending->has_result = false;
+  pending->result = COMMAND_REJECTED;
+  pending->is_reporting = false;
+  pending->start_millis = 0;
+  pending->callback = nullptr;
+  pending->callback_context = nullptr;
+  pending->rolling_code = 0;
+  pending->hold = false;
+#ifdef USE_RTS_TRANSMIT_TASK
+  this->command_claims_[slot] = CLAIM_OPEN;
+#endif
+  this->num_pending_commands_++;
+  return pending->handle;
+}
+
+RTS::PendingCommand *RTS::find_pending_command_(CommandHandle handle) {
+  if (handle != 0) {
+    if (this->pending_commands_capacity_ == 0) {
+      return nullptr;
+    }
+    auto &pending = this->pending_commands_[this->pending_command_slot_(handle)];
+    return pending.handle == handle ? &pending : nullptr;
+  }
+
+  for (size_t i = 0; i < this->pending_commands_capacity_; i++) {
+    if (this->pending_commands_[i].handle == 0) {
+      return &this->pending_commands_[i];
+    }
+  }
+  return nullptr;
+}
+
+void RTS::add_command_copy(CommandHandle handle) {
+  PendingCommand *pending = this->find_pending_command_(handle);
+  if (pending != nullptr) {
+    pending->num_copies++;
+  }
+}
+
+bool RTS::on_command_done(CommandHandle handle, CommandDoneCallback callback, void *context) {
+  PendingCommand *pending = handle != 0 ? this->find_pending_command_(handle) : nullptr;
+  if (pending == nullptr) {
+    return false;
+  }
+  pending->callback = callback;
+  pending->callback_context = context;
+  return true;
+}
+
+void RTS::note_command_done(Transmitter &tx, CommandHandle handle, CommandResult result) {
+  CommandOutcome outcome{};
+  outcome.handle = handle;
+  outcome.result = result;
+#ifdef USE_RTS_TRANSMIT_TASK
+  // Results from the dedicated task get resolved by the main loop. The outbox has room for a result
+  // of every pending command, so none gets lost.
+  tx.outbox.push(outcome);
+#else
+  this->resolve_command_copy(outcome);
+#endif
+}
+
+void RTS::note_command_done(Transmitter &tx, const ScheduledCommand &command, CommandResult result) {
+  CommandOutcome outcome;
+  outcome.handle = command.handle;
+  outcome.result = result;
+  outcome.urgent = command.urgent;
+  outcome.queue_depth = command.queue_depth;
+  outcome.start_millis = command.start_millis;
+  outcome.latency_millis = command.start_millis - command.enqueue_millis;
+  outcome.airtime_micros = command.airtime_micros;
+#ifdef USE_RTS_TRANSMIT_TASK
+  tx.outbox.push(outcome);
+#else
+  this->resolve_command_copy(outcome);
+#endif
+}
+
+void RTS::resolve_command_copy(const CommandOutcome &outcome) {
+  if (outcome.start_millis != 0) {
+    this->command_latency_millis_.add(outcome.latency_millis);
+    if (outcome.urgent) {
+      this->last_urgent_latency_millis_ = outcome.latency_millis;
+    }
+  }
+  // A STOP that cancelled a command is done without airtime.
+  if (outcome.result == COMMAND_TRANSMITTED && outcome.start_millis != 0) {
+    this->command_airtime_micros_.add(outcome.airtime_micros);
+  }
+  if (outcome.queue_depth != 0) {
+    this->queue_depth_.add(outcome.queue_depth);
+  }
+
+  PendingCommand *pending = outcome.handle != 0 ? this->find_pending_command_(outcome.handle) : nullptr;
+  if (pending == nullptr) {
+    return;
+  }
+
+  if (pending->num_copies > 0) {
+    pending->num_copies--;
+  }
+
+  // A command counts as transmitted if any of its copies was, and otherwise keeps the mildest
+  // failure of its copies.
+  if (!pending->has_result || outcome.result < pending->result) {
+    pending->result = outcome.result;
+  }
+  pending->has_result = true;
+  uint32_t start_millis = outcome.start_millis;
+  bool is_earlier_start = pending->start_millis == 0 || static_cast<int32_t>(start_millis - pending->start_millis) < 0;
+  if (start_millis != 0 && is_earlier_start) {
+    pending->start_millis = start_millis;
+  }
+}
+
+void RTS::report_done_commands() {
+#ifdef USE_RTS_TRANSMIT_TASK
+  for (auto &tx : this->transmitters_) {
+    CommandOutcome outcome;
+    while (tx->outbox.pop(outcome)) {
+      this->resolve_command_copy(outcome);
+    }
+  }
+#endif
+
+  if (this->num_pending_commands_ == 0) {
+    return;
+  }
+
+  // Done commands are marked before any callback runs, since callbacks may schedule new commands,
+  // which get reported in a later round.
+  for (size_t i = 0; i < this->pending_commands_capacity_; i++) {
+    auto &pending = this->pending_commands_[i];
+    pending.is_reporting = pending.handle != 0 && pending.num_copies == 0;
+  }
+
+  for (size_t i = 0; i < this->pending_commands_capacity_; i++) {
+    if (!this->pending_commands_[i].is_reporting) {
+      continue;
+    }
+
+    // The slot is freed first, so that callbacks can reuse it.
+    PendingCommand pending = this->pending_commands_[i];
+    this->pending_commands_[i].handle = 0;
+    this->pending_commands_[i].is_reporting = false;
+    this->num_pending_commands_--;
+
+    ESP_LOGV(TAG, "RTS command %u on channel 0x%x is done with result %u", pending.handle, pending.channel_id,
+             pending.result);
+    if (pending.callback != nullptr) {
+      pending.callback(pending.callback_context, pending.handle, pending.result, pending.start_millis);
+    }
+    this->command_done_callback_.call(pending.handle, pending.channel_id, pending.control_code, pending.result);
+  }
+}
+
+#ifdef USE_RTS_TRANSMIT_TASK
+void RTS::submit_to_transmit_task(Transmitter &tx, const ScheduledCommand &command) {
+  if (!tx.inbox.push(command)) {
+    this->transmit_task_inbox_overflow_count_++;
+    ESP_LOGW(TAG, "RTS transmit task is not keeping up; rejecting command 0x%x on channel 0x%x", command.control_code,
+             command.channel_id);
+    CommandOutcome outcome{};
+    outcome.handle = command.handle;
+    outcome.result = COMMAND_REJECTED;
+    this->resolve_command_copy(outcome);
+    return;
+  }
+  this->notify_transmit_task(tx);
+}
+
+void RTS::submit_to_transmit_tasks_(RTSChannel *rts_channel, const ScheduledCommand &command) {
+  for (size_t i = 0; i < this->transmitters_.size(); i++) {
+    if (this->channel_uses_transmitter_(*rts_channel, i)) {
+      this->add_command_copy(command.handle);
+      this->submit_to_transmit_task(*this->transmitters_[i], command);
+    }
+  }
+}
+
+RTS::PendingCommand *RTS::withdraw_pending_command_(RTSControlCode control_code, uint32_t channel_id,
+                                                    CommandHandle handle) {
+  if (control_code != STOP && !is_coalescible_control_code(control_code)) {
+    return nullptr;
+  }
 
-    if (++command.num_completed_repetitions >= command.num_repetitions) {
-      this->scheduled_commands_.pop();
+  // As in coalesce_pending_command(), only the newest pending command on the channel is a
+  // candidate.
+  PendingCommand *newest = nullptr;
+  for (size_t i = 0; i < this->pending_commands_capacity_; i++) {
+    auto &pending = this->pending_commands_[i];
+    if (pending.handle == 0 || pending.handle == handle || pending.channel_id != channel_id) {
+      continue;
     }
+    if (newest == nullptr || static_cast<int32_t>(pending.sequence - newest->sequence) > 0) {
+      newest = &pending;
+    }
+  }
+  if (newest == nullptr || newest->num_copies == 0 || newest->hold ||
+      !is_coalescible_control_code(newest->control_code)) {
+    return nullptr;
+  }
+
+  uint8_t claim = CLAIM_OPEN;
+  if (!this->command_claim_(newest->handle)
+           .compare_exchange_strong(claim, control_code == STOP ? CLAIM_CANCELLED : CLAIM_WITHDRAWN)) {
+    return nullptr;
   }
+  ESP_LOGV(TAG, "Withdrawing RTS command 0x%x on channel 0x%x in favor of 0x%x", newest->control_code, channel_id,
+           control_code);
 
-  this->set_timeout(transmission_delay, [this]() { this->process_one_scheduled_command(true); });
+  // The tasks drop the cancelled command once it reaches the front of their queues, and the STOP
+  // counts as sent right away.
+  if (control_code == STOP) {
+    PendingCommand *pending = this->find_pending_command_(handle);
+    pending->has_result = true;
+    pending->result = COMMAND_TRANSMITTED;
+  }
+  return newest;
 }
 
-uint32_t RTS::transmit_wakeup() {
-  auto transmit_call = this->transmitter_->transmit();
+void RTS::run_transmit_task(Transmitter &tx) {
+  bool abbreviated_sync = false;
+  while (true) {
+    ScheduledCommand command;
+    while (tx.inbox.pop(command)) {
+      this->accept_command(tx, command);
+    }
+
+    auto transmission_delay = this->transmit_next_frame(tx, abbreviated_sync);
+    if (!transmission_delay.has_value()) {
+      abbreviated_sync = false;
+      if (!this->wait_for_transmit_task_work(tx)) {
+        return;
+      }
+      continue;
+    }
+
+    // A wait for the airtime budget or a retry ends early when new commands arrive, since an urgent
+    // one goes out right away.
+    abbreviated_sync = true;
+    if (tx.last_run_waited) {
+      if (!this->wait_for_transmit_task_work(tx, *transmission_delay)) {
+        return;
+      }
+      continue;
+    }
+
+    // The task paces frames itself, so other components' loop latency has no effect on the gaps.
+    delay(*transmission_delay);
+  }
+}
+
+void RTS::notify_transmit_task(Transmitter &tx) {
+#ifdef USE_ESP32
+  xTaskNotifyGive(tx.task_handle);
+#else
+  {
+    std::lock_guard<std::mutex> lock(tx.task_mutex);
+    tx.task_notified = true;
+  }
+  tx.task_condition.notify_one();
+#endif
+}
+
+bool RTS::wait_for_transmit_task_work(Transmitter &tx, optional<uint32_t> timeout_millis) {
+#ifdef USE_ESP32
+  ulTaskNotifyTake(pdTRUE, timeout_millis.has_value() ? pdMS_TO_TICKS(*timeout_millis) : portMAX_DELAY);
+  return true;
+#else
+  std::unique_lock<std::mutex> lock(tx.task_mutex);
+  if (timeout_millis.has_value()) {
+    // Waits in steps of delay(), so that the timeout follows the same clock as millis().
+    uint32_t start_millis = millis();
+    while (!tx.task_notified && !tx.task_stopping && millis() - start_millis < *timeout_millis) {
+      lock.unlock();
+      delay(1);
+      lock.lock();
+    }
+  } else {
+    tx.task_waiting = true;
+    tx.task_condition.wait(lock, [&tx]() { return tx.task_notified || tx.task_stopping; });
+    tx.task_waiting = false;
+  }
+  tx.task_notified = false;
+  return !tx.task_stopping;
+#endif
+}
+#endif
+
+optional<uint32_t> RTS::transmit_prewake(Transmitter &tx) {
+  uint32_t now = millis();
+  if (tx.has_sent_wakeup && now - tx.last_wakeup_millis < wakeup_cooldown_millis - prewake_lead_millis) {
+    return {};
+  }
+
+  uint64_t prewake_budget_micros =
+      uint64_t(tx.prewake_airtime_window.window_millis()) * 1000 * this->prewake_airtime_percent_ / 100;
+  if (tx.prewake_airtime_window.used_micros(now) + wakeup_signal_high_micros > prewake_budget_micros ||
+      this->remaining_airtime_budget_micros(tx) < wakeup_signal_high_micros) {
+    ESP_LOGV(TAG, "No airtime left for RTS prewake");
+    return {};
+  }
+
+  ESP_LOGV(TAG, "Transmitting prewake signal");
+  uint32_t transmission_delay = this->transmit_wakeup(tx);
+  if (tx.failure_observed) {
+    // Commands retry their own wakeups, so a failed prewake is not retried.
+    tx.failure_observed = false;
+    return {};
+  }
+
+  tx.prewake_airtime_window.add(now, wakeup_signal_high_micros);
+  tx.last_wakeup_was_prewake = true;
+
+  // The next command still counts as not needing its own wakeup.
+  tx.last_transmission_was_wakeup = false;
+  this->prewakes_sent_++;
+  return transmission_delay;
+}
+
+uint32_t RTS::transmit_wakeup(Transmitter &tx) {
+  auto transmit_call = tx.transmitter->transmit();
   auto transmit_data = transmit_call.get_data();
 
   if (transmit_data->get_carrier_frequency() != 0) {
     ESP_LOGE(TAG, "Cannot transmit RTS commands over radio configured with a carrier frequency");
+    tx.failure_observed = true;
 
     // Return control to the transmission loop without delay.
     return 0;
   }
 
-  transmit_data->mark(wakeup_signal_high_micros);
+  transmit_data->mark(compensated_mark_micros(wakeup_signal_high_micros, tx.mark_overhead_micros));
+  uint32_t start_millis = millis();
   transmit_call.perform();
+  this->record_airtime(tx, airtime_micros(transmit_data->get_data()));
+  tx.last_transmission_was_wakeup = true;
+  tx.last_wakeup_was_prewake = false;
 
-  // Begin the 10 second cooldown period for sending wakeup signals.
-  this->set_timeout(wakeup_cooldown_millis, [this]() { this->needs_wakeup_ = true; });
-  this->needs_wakeup_ = false;
+  // A prewake precedes no particular command, and is traced without a channel.
+  static const ScheduledCommand no_command{};
+  const auto &command = tx.scheduled_commands.empty() ? no_command : tx.scheduled_commands.front();
+  trace_frame(tx, command, start_millis, 0, RTSTraceBuffer::FRAME_WAKEUP);
 
-  // Delay further transmission for 90ms.
+  // Begin the 10 second cooldown period for sending wakeup signals. It runs from the start of the
+  // wakeup, which is what the prewake renewal is timed against.
+  tx.last_wakeup_millis = start_millis;
+  tx.has_sent_wakeup = true;
+
+  // Delay further transmission for the wakeup silence.
   return wakeup_signal_low_millis;
 }
 
-uint32_t RTS::transmit_command(RTSControlCode control_code, uint32_t channel_id, uint16_t rolling_code,
-                               bool abbreviated_sync) {
-  RTSPacketBody packet(control_code, channel_id, rolling_code);
+uint32_t RTS::transmit_command(Transmitter &tx, ScheduledCommand &command, bool abbreviated_sync) {
+  auto transmit_call = tx.transmitter->transmit();
+  auto transmit_data = transmit_call.get_data();
 
-  ESP_LOGVV(TAG, "Cleartext RTS packet:  %s", packet.encoded_data_as_string_().c_str());
-  ESP_LOGVV(TAG, "Obfuscated RTS packet: %s", packet.obfuscated_data_as_string_().c_str());
+  if (transmit_data->get_carrier_frequency() != 0) {
+    ESP_LOGE(TAG, "Cannot transmit RTS commands over radio configured with a carrier frequency");
+    tx.failure_observed = true;
 
-  auto transmit_call = this->transmitter_->transmit();
+    // Return control to the transmission loop without delay.
+    return 0;
+  }
+
+  // Repetitions of a command replay the frame that was encoded for the first transmission.
+  transmit_data->set_data(this->frame_timings(tx, command.payload, abbreviated_sync));
+
+  uint32_t start_millis = millis();
+  transmit_call.perform();
+  trace_frame(tx, command, start_millis, command.num_completed_repetitions,
+              abbreviated_sync ? RTSTraceBuffer::FRAME_ABBREVIATED_SYNC : RTSTraceBuffer::FRAME_FULL_SYNC);
+  uint32_t airtime = airtime_micros(transmit_data->get_data());
+  this->record_airtime(tx, airtime);
+  command.airtime_micros += airtime;
+  tx.last_transmission_was_wakeup = false;
+
+  // Delay further transmission for the inter-frame gap.
+  return inter_frame_gap_millis;
+}
+
+uint32_t RTS::transmit_burst(Transmitter &tx, ScheduledCommand &command, int num_frames, bool include_wakeup,
+                             bool abbreviated_sync) {
+  auto transmit_call = tx.transmitter->transmit();
   auto transmit_data = transmit_call.get_data();
 
   if (transmit_data->get_carrier_frequency() != 0) {
     ESP_LOGE(TAG, "Cannot transmit RTS commands over radio configured with a carrier frequency");
+    tx.failure_observed = true;
 
     // Return control to the transmission loop without delay.
     return 0;
   }
 
-  transmit_data->reserve(transmit_items_per_command_upper_bound);
+  transmit_data->reserve(burst_items_upper_bound(num_frames, include_wakeup));
+
+  // Frames are traced at the offsets within the burst where they go out.
+  uint32_t start_millis = millis();
+  uint32_t offset_micros = 0;
 
-  // Hardware sync: sent twice immediately after a wakeup signal or 7 times otherwise.
-  for (int j = 0; j < (abbreviated_sync ? 2 : 7); j++) {
-    transmit_data->item(hardware_sync_high_micros, hardware_sync_low_micros);
+  uint32_t command_airtime = 0;
+  if (include_wakeup) {
+    trace_frame(tx, command, start_millis, 0, RTSTraceBuffer::FRAME_WAKEUP);
+    transmit_data->mark(compensated_mark_micros(wakeup_signal_high_micros, tx.mark_overhead_micros));
+    transmit_data->space(compensated_space_micros(wakeup_signal_low_micros, tx.mark_overhead_micros));
+    offset_micros += wakeup_signal_high_micros + wakeup_signal_low_micros;
   }
 
-  // One last sync signal.
-  transmit_data->item(software_sync_high_micros, software_sync_low_micros);
+  for (int frame_index = 0; frame_index < num_frames; frame_index++) {
+    if (frame_index > 0) {
+      transmit_data->space(compensated_space_micros(inter_frame_gap_micros, tx.mark_overhead_micros));
+      offset_micros += inter_frame_gap_micros;
+      abbreviated_sync = true;
+    }
 
-  // Transmit the data with Manchester encoding.
-  for (auto byte_to_transmit : packet.obfuscated_data()) {
-    for (int bit_index = 0; bit_index < 8; bit_index++) {
-      if ((byte_to_transmit & 0x80) == 0) {
-        // A 0 bit is transmitted as a falling edge.
-        transmit_data->mark(symbol_micros / 2);
-        transmit_data->space(symbol_micros / 2);
+    trace_frame(tx, command, start_millis + offset_micros / 1000, command.num_completed_repetitions + frame_index,
+                abbreviated_sync ? RTSTraceBuffer::FRAME_ABBREVIATED_SYNC : RTSTraceBuffer::FRAME_FULL_SYNC);
+    const auto &frame = this->frame_timings(tx, command.payload, abbreviated_sync);
+    for (int32_t item : frame) {
+      if (item >= 0) {
+        transmit_data->mark(item);
       } else {
-        // A 1 bit is transmitted as a rising edge.
-        transmit_data->space(symbol_micros / 2);
-        transmit_data->mark(symbol_micros / 2);
+        transmit_data->space(-item);
       }
-      byte_to_transmit <<= 1;
     }
+    uint32_t frame_airtime = airtime_micros(frame);
+    command_airtime += frame_airtime;
+    offset_micros += frame_airtime;
   }
 
+  ESP_LOGV(TAG, "Transmitting %zu items in a single burst", transmit_data->get_data().size());
   transmit_call.perform();
+  this->record_airtime(tx, command_airtime + (include_wakeup ? wakeup_signal_high_micros : 0));
+  command.airtime_micros += command_airtime;
+  tx.last_transmission_was_wakeup = false;
+
+  if (include_wakeup) {
+    tx.last_wakeup_millis = start_millis;
+    tx.has_sent_wakeup = true;
+    tx.last_wakeup_was_prewake = false;
+  }
 
-  // Delay further transmission for 30ms.
+  // The gap after the last frame is left to the transmission loop.
   return inter_frame_gap_millis;
 }
 
+void RTS::trace_frame(Transmitter &tx, const ScheduledCommand &command, uint32_t frame_millis, uint8_t repetition,
+                      RTSTraceBuffer::FrameKind kind) {
+  RTSTraceBuffer::Entry entry;
+  entry.millis = frame_millis;
+  entry.channel_id = command.channel_id;
+  entry.control_code = command.control_code;
+  entry.kind = kind;
+  entry.rolling_code = command.rolling_code;
+  entry.repetition = repetition;
+  entry.num_repetitions = command.num_repetitions;
+  tx.trace.record(entry);
+}
+
+const remote_base::RawTimings &RTS::frame_timings(Transmitter &tx, const Payload &payload, bool abbreviated_sync) {
+  if (!tx.frame_timings_valid || tx.frame_timings_abbreviated_sync != abbreviated_sync ||
+      tx.frame_timings_payload != payload) {
+    this->encode_frame(tx, payload, abbreviated_sync);
+  }
+  return tx.frame_timings;
+}
+
+void RTS::encode_frame(Transmitter &tx, const Payload &payload, bool abbreviated_sync) {
+  tx.frame_timings.reserve(frame_items_upper_bound);
+  Timing::encode_frame(payload, abbreviated_sync, tx.mark_overhead_micros, &tx.frame_timings);
+
+  tx.frame_timings_payload = payload;
+  tx.frame_timings_abbreviated_sync = abbreviated_sync;
+  tx.frame_timings_valid = true;
+}
+
+uint32_t RTS::airtime_micros(const remote_base::RawTimings &timings) {
+  uint32_t total = 0;
+  for (int32_t item : timings) {
+    total += item < 0 ? -item : item;
+  }
+  return total;
+}
+
 }  // namespace rts
 }  // namespace esphome
@@ -1,17 +1,52 @@
 #pragma once
 
-#include <queue>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
 
 #include "esphome/components/remote_base/remote_base.h"
 #include "esphome/components/remote_transmitter/remote_transmitter.h"
 #include "esphome/core/component.h"
+#include "esphome/core/defines.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+#include "rts_airtime_window.h"
 #include "rts_channel.h"
+#include "rts_command_queue.h"
+#include "rts_sample_window.h"
+#include "rts_timing.h"
+#include "rts_trace.h"
+
+#ifdef USE_RTS_TRANSMIT_TASK
+#include "rts_spsc_queue.h"
+#ifdef USE_ESP32
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#else
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+#endif
 
 namespace esphome {
 namespace rts {
 
-class RTS : public Component {
+class RTS : public Component, public remote_base::RemoteReceiverListener {
  public:
+  // What to do with a newly scheduled command when the transmission queue is full.
+  enum QueueOverflowPolicy {
+    // Reject the new command.
+    OVERFLOW_REJECT_NEW,
+    // Drop the oldest queued non-urgent command to make room.
+    OVERFLOW_DROP_OLDEST,
+    // Make room by skipping the remaining repetitions of a command that has already been
+    // transmitted at least once, rejecting the new command if there is no such command.
+    OVERFLOW_COALESCE,
+  };
+
   enum RTSControlCode {
     STOP = 0x1,
     OPEN = 0x2,
@@ -25,69 +60,785 @@ class RTS : public Component {
     // DISABLE_SUN_DETECTOR = 0xa,
   };
 
+  // Contents of an RTS frame decoded by the receiver.
+  struct ReceivedFrame {
+    RTSControlCode control_code;
+    uint32_t channel_id;
+    uint16_t rolling_code;
+  };
+
+  // Outcome of a scheduled command, reported once all of its copies are done.
+  enum CommandResult : uint8_t {
+    // At least one transmitter sent every repetition.
+    COMMAND_TRANSMITTED,
+    // A newer command on the same channel took the command's place before it was sent.
+    COMMAND_SUPERSEDED,
+    // The command did not fit into the transmission queue.
+    COMMAND_REJECTED,
+    // The command was dropped from a full queue to make room for another.
+    COMMAND_DROPPED,
+    // The command was given up after failing to transmit more than max_command_retries times.
+    COMMAND_CANCELLED,
+  };
+
+  // Identifies a scheduled command. 0 is never a valid handle.
+  using CommandHandle = uint32_t;
+
+  // Called with the context that was registered along with it, and the command's handle, result and
+  // the time when its first frame started, or 0 if none did.
+  using CommandDoneCallback = void (*)(void *context, CommandHandle handle, CommandResult result,
+                                       uint32_t start_millis);
+
+#if defined(USE_RTS_TRANSMIT_TASK) && !defined(USE_ESP32)
+  // Stops and joins the transmit task threads, which use the component.
+  ~RTS();
+#endif
+
+  void setup() override final;
+  void loop() override final;
   void dump_config() override final;
+  void on_shutdown() override final;
+
+  // Decodes RTS frames from a remote receiver, so that commands sent by physical remotes can be
+  // observed. Each frame is reported once, regardless of how many times the remote repeats it.
+  bool on_receive(remote_base::RemoteReceiveData data) override;
+
+  void set_receiver(remote_base::RemoteReceiverBase *receiver) {
+    this->has_receiver_ = true;
+    receiver->register_listener(this);
+  }
+  bool has_receiver() const { return this->has_receiver_; }
+
+  void add_on_frame_received_callback(std::function<void(const ReceivedFrame &)> &&callback) {
+    this->frame_received_callback_.add(std::move(callback));
+  }
+
+  // Returns a handle for the command, whose result is reported to on_command_done() callbacks, or 0
+  // if too many commands are pending to track another one, in which case the command is rejected
+  // without a result being reported.
+  CommandHandle schedule_rts_command(RTSControlCode control_code, RTSChannel *rts_channel, int max_repetitions = 16) {
+    return this->schedule_command(control_code, rts_channel, std::min(this->command_repetitions_, max_repetitions),
+                                  max_repetitions, false);
+  }
+
+  // Holds the control code like a long press on a remote, as used for tilting venetian blinds or
+  // saving the "My" position with STOP: num_frames repetitions of one frame, with the same rolling
+  // code, each following the previous one after exactly the inter-frame gap. Hold commands are never
+  // coalesced or shortened, and keep going once started even if the airtime budget runs out.
+  CommandHandle schedule_hold_command(RTSControlCode control_code, RTSChannel *rts_channel, uint8_t num_frames) {
+    uint8_t num_repetitions = std::max<uint8_t>(num_frames, 1);
+    return this->schedule_command(control_code, rts_channel, num_repetitions, num_repetitions, true);
+  }
 
-  void schedule_rts_command(RTSControlCode control_code, RTSChannel *rts_channel, int max_repetitions = 16);
+  // Time that a hold command of num_frames frames lasts, from its first frame to the end of its last
+  // inter-frame gap.
+  static constexpr uint32_t hold_duration_millis(uint8_t num_frames) {
+    return num_frames == 0 ? 0 : (hold_first_frame_period_micros + (num_frames - 1) * hold_frame_period_micros) / 1000;
+  }
 
-  void set_transmitter(remote_transmitter::RemoteTransmitterComponent *transmitter) { transmitter_ = transmitter; }
+  // Number of frames that a hold command needs to last for the given time.
+  static uint8_t hold_frames_for(uint32_t duration_millis) {
+    uint32_t duration_micros = duration_millis * 1000;
+    if (duration_micros <= hold_first_frame_period_micros) {
+      return 1;
+    }
+    uint32_t num_frames =
+        1 + (duration_micros - hold_first_frame_period_micros + hold_frame_period_micros / 2) / hold_frame_period_micros;
+    return std::min<uint32_t>(num_frames, UINT8_MAX);
+  }
+
+  // Schedules the same control code on several channels at once. The frames for the channels are
+  // interleaved, so that each device receives its first frame before any channel's repetitions get
+  // sent, and all of them use abbreviated sync.
+  void schedule_group_command(RTSControlCode control_code, const std::vector<RTSChannel *> &rts_channels,
+                              int max_repetitions = 16);
+
+  // Calls the callback once the command is done. Results are reported from the main loop, after the
+  // last repetition is sent or the command is given up. Returns false if the handle's result was
+  // already reported, or the handle is 0.
+  bool on_command_done(CommandHandle handle, CommandDoneCallback callback, void *context);
+
+  // Called with the handle, channel id, control code and result of every command once it is done,
+  // including the commands of group commands.
+  void add_on_command_done_callback(
+      std::function<void(CommandHandle, uint32_t, RTSControlCode, CommandResult)> &&callback) {
+    this->command_done_callback_.add(std::move(callback));
+  }
+
+  // Collects commands that restore covers' states at boot, and sends them as group commands once
+  // startup has settled: the first batch after boot_restore_delay_millis, then one batch of at most
+  // boot_restore_batch_size channels every boot_restore_interval_millis. Each batch shares one
+  // wakeup and consumes rolling codes, and saves them, only when it gets sent.
+  void queue_boot_restore(RTSControlCode control_code, RTSChannel *rts_channel);
+  void set_boot_restore_delay(uint32_t boot_restore_delay_millis) {
+    this->boot_restore_delay_millis_ = boot_restore_delay_millis;
+  }
+  void set_boot_restore_batch_size(size_t boot_restore_batch_size) {
+    this->boot_restore_batch_size_ = boot_restore_batch_size;
+  }
+  void set_boot_restore_interval(uint32_t boot_restore_interval_millis) {
+    this->boot_restore_interval_millis_ = boot_restore_interval_millis;
+  }
+
+  // Each transmitter has its own queue, wakeup state and pacing, so transmitters on separate pins
+  // send independently of each other. At most max_transmitters are supported.
+  void add_transmitter(remote_transmitter::RemoteTransmitterComponent *transmitter);
+
+  // Bitmask of the given transmitters' positions, for use with RTSChannel::set_transmitter_mask().
+  uint8_t transmitter_mask(const std::vector<remote_transmitter::RemoteTransmitterComponent *> &transmitters) const;
+
+  // Compensates the timings sent on a transmitter for a measured mark overhead, the time that it
+  // keeps each mark on beyond the requested duration. A negative overhead lengthens marks instead.
+  void set_mark_overhead(remote_transmitter::RemoteTransmitterComponent *transmitter, int32_t mark_overhead_micros);
 
   void set_command_repetitions(int command_repetitions) { this->command_repetitions_ = command_repetitions; }
 
+  // Range for adapting the number of repetitions to the load on the transmitter. A command that
+  // has to wait behind others in the queue gets one repetition fewer for each command ahead of it,
+  // down to the minimum. A command that finds the transmitter idle gets the maximum, as long as
+  // the airtime budget and the max_repetitions that it was scheduled with allow. Urgent commands
+  // never go below command_repetitions, and programming commands are not adapted.
+  void set_min_command_repetitions(int min_command_repetitions) {
+    this->min_command_repetitions_ = min_command_repetitions;
+  }
+  void set_max_command_repetitions(int max_command_repetitions) {
+    this->max_command_repetitions_ = max_command_repetitions;
+  }
+
+  // Limits transmissions to a share of the airtime in a sliding window. While the budget is used
+  // up, non-urgent commands wait for airtime to expire from the window, and new commands get fewer
+  // repetitions so that the queued work fits within the remaining budget. A percentage of 0
+  // disables the limit.
+  void set_airtime_budget(uint8_t percent, uint32_t window_millis) {
+    this->airtime_budget_percent_ = percent;
+    this->airtime_budget_window_millis_ = window_millis;
+    for (auto &tx : this->transmitters_) {
+      tx->airtime_window.set_window_millis(window_millis);
+      tx->prewake_airtime_window.set_window_millis(window_millis);
+    }
+  }
+
+  // Keeps the state of all channels in one consolidated table instead of a preference record per
+  // channel. Changes are saved in batches: after scheduling commands, in the next loop iteration,
+  // and at shutdown.
+  void enable_channel_table() { this->channel_registry_.enable_channel_table(); }
+  void flush_channel_table() { this->channel_registry_.flush_channel_table(); }
+
+  void set_rolling_code_lease_size(uint16_t rolling_code_lease_size) {
+    this->channel_registry_.set_rolling_code_lease_size(rolling_code_lease_size);
+  }
+
+  // State of every channel, which covers address through their RTSChannel handles.
+  RTSChannelRegistry &channel_registry() { return this->channel_registry_; }
+  void reserve_channels(size_t num_channels) { this->channel_registry_.reserve_channels(num_channels); }
+
+  // Commands with an urgent control code preempt other queued commands at the next frame boundary.
+  // STOP is urgent by default.
+  void set_urgent_control_codes(std::initializer_list<RTSControlCode> control_codes) {
+    this->urgent_control_codes_ = 0;
+    for (auto control_code : control_codes) {
+      this->urgent_control_codes_ |= 1 << control_code;
+    }
+  }
+  bool is_urgent_control_code(RTSControlCode control_code) const {
+    return (this->urgent_control_codes_ & (1 << control_code)) != 0;
+  }
+
+  // Capacity of each transmitter's queue.
+  void set_queue_capacity(size_t queue_capacity) {
+    this->queue_capacity_ = queue_capacity;
+    for (auto &tx : this->transmitters_) {
+      this->init_transmitter_(*tx);
+    }
+    this->init_pending_commands_();
+  }
+  void set_queue_overflow_policy(QueueOverflowPolicy queue_overflow_policy) {
+    this->queue_overflow_policy_ = queue_overflow_policy;
+  }
+
+  // Number of commands that were rejected or dropped because the transmission queue was full.
+  uint32_t queue_overflow_count() const {
+    return this->queue_overflow_count_ + this->transmit_task_inbox_overflow_count_;
+  }
+
+  // In burst mode, a command's wakeup signal, repetitions and the gaps between them are encoded into
+  // one TransmitCall. Commands that would need more than burst_max_items timings, as well as group
+  // commands, are transmitted one frame at a time instead.
+  void set_burst_transmit(bool burst_transmit) { this->burst_transmit_ = burst_transmit; }
+  void set_burst_max_items(size_t burst_max_items) { this->burst_max_items_ = burst_max_items; }
+
+  // A command whose transmission fails moves behind the other queued commands and gets retried
+  // after retry_backoff_millis, doubling with each further failure. After max_command_retries
+  // retries, the command is given up. Other commands keep going out in the meantime.
+  void set_max_command_retries(uint8_t max_command_retries) { this->max_command_retries_ = max_command_retries; }
+  void set_retry_backoff(uint32_t retry_backoff_millis) { this->retry_backoff_millis_ = retry_backoff_millis; }
+
+  // Each transmitter keeps the last trace_size frames that it sent in a binary trace, which
+  // dump_trace() decodes into the log.
+  void set_trace_size(size_t trace_size) {
+    this->trace_size_ = trace_size;
+    for (auto &tx : this->transmitters_) {
+      tx->trace.init(trace_size);
+    }
+  }
+  void dump_trace();
+
+#ifdef USE_RTS_TRANSMIT_TASK
+  // Core that the dedicated transmit task gets pinned to on dual-core ESP32 chips.
+  void set_transmit_task_core(int transmit_task_core) { this->transmit_task_core_ = transmit_task_core; }
+#endif
+
+  // Signals user activity, such as a cover being opened in the UI, after which commands are likely
+  // to follow. Devices get woken up right away and kept awake for prewake_hold_millis after the last
+  // activity, so that the commands go out without waiting for a wakeup signal. Wakeups sent this way
+  // use at most prewake_airtime_percent of the airtime budget window, and never exceed the airtime
+  // budget. With predictive wakeup, every scheduled command counts as activity.
+  void prewake();
+  void set_predictive_wakeup(bool predictive_wakeup) { this->predictive_wakeup_ = predictive_wakeup; }
+  void set_prewake_hold(uint32_t prewake_hold_millis) { this->prewake_hold_millis_ = prewake_hold_millis; }
+  void set_prewake_airtime_percent(uint8_t prewake_airtime_percent) {
+    this->prewake_airtime_percent_ = prewake_airtime_percent;
+  }
+
+  // Wakeups sent ahead of commands, and the total wakeup delay that commands were spared by them.
+  uint32_t prewakes_sent() const { return this->prewakes_sent_; }
+  uint32_t prewake_latency_saved_millis() const { return this->prewake_latency_saved_millis_; }
+
+  // Number of scheduled commands that were merged into a pending command on the same channel
+  // instead of getting transmitted separately.
+  uint32_t coalesced_command_count() const { return this->coalesced_command_count_; }
+
+  // Time from scheduling to first transmitted frame for the most recently completed urgent command.
+  uint32_t last_urgent_latency_millis() const { return this->last_urgent_latency_millis_; }
+
+  // Devices act on a command once they have received its first frame.
+  static constexpr uint32_t frame_duration_millis() { return (frame_airtime_upper_bound_micros + 999) / 1000; }
+
+  // Expected time from scheduling an urgent command, such as STOP, until devices act on it, based
+  // on the latency that the most recent urgent command saw.
+  uint32_t urgent_reaction_millis() const { return this->last_urgent_latency_millis_ + frame_duration_millis(); }
+
+  // Percentile of the time from scheduling to first transmitted frame, over the most recently
+  // completed commands.
+  uint32_t command_latency_millis(uint8_t percent) const { return this->command_latency_millis_.percentile(percent); }
+
+  // Median airtime of the most recently completed commands, over all of their repetitions.
+  uint32_t command_airtime_micros() const { return this->command_airtime_micros_.percentile(50); }
+
+  // Commands that have been scheduled and whose results have not been reported yet.
+  size_t num_pending_commands() const { return this->num_pending_commands_; }
+  size_t queue_capacity() const { return this->queue_capacity_; }
+
+  // Largest number of queued commands, sampled on every transmitted frame, over the frames of the
+  // most recently completed commands. Stays close to the queue capacity while the transmitter is
+  // saturated.
+  uint32_t peak_queue_depth() const { return this->queue_depth_.max(); }
+
+  // Commands that started with a wakeup signal, and commands that skipped it because another
+  // wakeup was sent less than wakeup_cooldown_millis earlier.
+  uint32_t wakeups_sent() const { return this->wakeups_sent_; }
+  uint32_t wakeups_skipped() const { return this->wakeups_skipped_; }
+
+  // Commands that were given up because their transmissions kept failing.
+  uint32_t cancelled_command_count() const { return this->cancelled_command_count_; }
+
  protected:
+  // Obfuscated RTS packet bytes, exactly as they get transmitted.
+  using Payload = std::array<uint8_t, 7>;
+
+  // Packed to keep the preallocated transmission queue small.
   struct ScheduledCommand {
-    RTSControlCode control_code;
+    uint32_t channel_id : 24;
+    RTSControlCode control_code : 4;
+
+    // Urgent commands are queued ahead of all non-urgent commands, including one that is in the
+    // middle of its repetitions.
+    bool urgent : 1;
+
+    // Set for commands from schedule_hold_command(), whose repetitions get streamed.
+    bool hold : 1;
+
+    uint16_t rolling_code;
+
+    uint8_t num_repetitions;
+    uint8_t num_completed_repetitions;
+
+    // Limit that the caller set, which adapting the repetitions never exceeds.
+    uint8_t max_repetitions;
+
+    // Nonzero for commands scheduled together by schedule_group_command(). After each repetition,
+    // a group command moves behind the other commands in its group.
+    uint8_t group_id;
+
+    // Time when the command entered the queue, used to report enqueue-to-first-edge latency.
+    uint32_t enqueue_millis;
+
+    // Airtime of the repetitions transmitted so far.
+    uint32_t airtime_micros;
+
+    // Handle that the command's result gets reported for.
+    CommandHandle handle;
+
+    // Time when the first frame started, or 0 if it has not.
+    uint32_t start_millis;
+
+    // Failed transmission attempts, and the time before which the command must not be retried.
+    uint8_t num_failures;
+    uint32_t retry_millis;
+
+    // Largest number of queued commands, counting this one, while its frames went out.
+    uint8_t queue_depth;
+
+    // Encoded once when the command is scheduled and reused for every repetition.
+    Payload payload;
+  } __attribute__((packed));
+
+  // Result of one copy of a command, handed from the transmitting context to the main loop, along
+  // with the statistics that the main loop keeps about it.
+  struct CommandOutcome {
+    CommandHandle handle;
+    CommandResult result;
+    bool urgent;
+
+    // Largest queue depth that the copy's frames went out with, or 0 if it sent none.
+    uint8_t queue_depth;
+
+    // Time when the first frame started, or 0 if none did, and how long the copy waited for it.
+    uint32_t start_millis;
+    uint32_t latency_millis;
+
+    uint32_t airtime_micros;
+  };
+
+  // A command whose result has not been reported yet. Each transmitter that the command goes out on
+  // holds a copy, and the command is done once all copies are.
+  struct PendingCommand {
+    // 0 marks a free slot of the pool.
+    CommandHandle handle;
     uint32_t channel_id;
+    RTSControlCode control_code;
+    uint8_t num_copies;
+    bool has_result;
+    CommandResult result;
+
+    // Set while report_done_commands() reports the command, so that commands scheduled by its
+    // callbacks wait for the next round.
+    bool is_reporting;
+
+    // Earliest first frame of any copy, or 0 if none started.
+    uint32_t start_millis;
+    CommandDoneCallback callback;
+    void *callback_context;
+
+    // Order in which commands were scheduled, and what withdraw_pending_command_() needs to know to
+    // take a command's rolling code over.
+    uint32_t sequence;
     uint16_t rolling_code;
+    bool hold;
+  };
+
+#ifdef USE_RTS_TRANSMIT_TASK
+  // Whether a command handed to the transmit tasks may still be withdrawn by the main loop, shared
+  // by all of its copies. Only one side gets to move a command away from CLAIM_OPEN.
+  enum CommandClaim : uint8_t {
+    CLAIM_OPEN,
+    // A transmit task started sending the command, so its rolling code value is used.
+    CLAIM_STARTED,
+    // The main loop handed the command's rolling code value to a newer command, which supersedes it.
+    CLAIM_WITHDRAWN,
+    // A STOP superseded the command, and neither of them gets sent.
+    CLAIM_CANCELLED,
+  };
+#endif
+
+  // Queue, wakeup state and pacing of one radio. Only the context that transmits on the radio, the
+  // main loop or the radio's dedicated task, accesses its queue.
+  struct Transmitter {
+    remote_transmitter::RemoteTransmitterComponent *transmitter;
+    RTSCommandQueue<ScheduledCommand> scheduled_commands;
+    bool is_transmit_task_scheduled{false};
+    // Incremented when the transmission handler restarts, which ends the run that was waiting.
+    uint32_t handler_run{0};
+    bool has_sent_wakeup{false};
+    uint32_t last_wakeup_millis{0};
+    bool last_transmission_was_wakeup{false};
+    // Set when the previous run of the transmission handler only waited, without transmitting.
+    bool last_run_waited{false};
+    bool failure_observed{false};
+    RTSAirtimeWindow airtime_window;
 
-    int num_repetitions;
-    int num_completed_repetitions;
+    // Set by prewake() for the transmitting context, which sends the wakeup once its queue is empty.
+    std::atomic<bool> prewake_requested{false};
+    // Set from a prewake until the first command that it spared a wakeup.
+    bool last_wakeup_was_prewake{false};
+    RTSAirtimeWindow prewake_airtime_window;
+    RTSTraceBuffer trace;
+
+    // Measured time that the transmitter keeps each mark on beyond the requested duration, which
+    // every mark and space it sends gets compensated for.
+    int32_t mark_overhead_micros{0};
+
+    // Raw timings of the most recently encoded frame, which get replayed as long as consecutive
+    // transmissions send the same payload with the same kind of sync.
+    remote_base::RawTimings frame_timings;
+    Payload frame_timings_payload{};
+    bool frame_timings_abbreviated_sync{false};
+    bool frame_timings_valid{false};
+
+    // Timing of the current run of the transmission handler, reported when the queue drains.
+    uint32_t drain_start_millis{0};
+    uint32_t drain_airtime_micros{0};
+
+#ifdef USE_RTS_TRANSMIT_TASK
+    RTS *rts{nullptr};
+    RTSSpscQueue<ScheduledCommand> inbox;
+    RTSSpscQueue<CommandOutcome> outbox;
+#ifdef USE_ESP32
+    TaskHandle_t task_handle{nullptr};
+#else
+    std::thread task_thread;
+    std::mutex task_mutex;
+    std::condition_variable task_condition;
+    bool task_notified{false};
+    // Whether the task waits for work with nothing to do, and whether it has to end.
+    bool task_waiting{false};
+    bool task_stopping{false};
+#endif
+#endif
   };
 
-  void process_one_scheduled_command(bool abbreviated_sync = false);
+  static constexpr size_t max_transmitters = 8;
+
+  void init_transmitter_(Transmitter &tx);
+
+  // A channel without a transmitter mask uses every transmitter.
+  static bool channel_uses_transmitter_(const RTSChannel &rts_channel, size_t index) {
+    return rts_channel.transmitter_mask() == 0 || (rts_channel.transmitter_mask() & (1 << index)) != 0;
+  }
+
+  // Runs the transmission handler once, unless the handler was restarted since the given run.
+  void process_one_scheduled_command(Transmitter &tx, uint32_t run, bool abbreviated_sync = false);
+
+  // Transmits the next wakeup signal or command frame from the queue and returns the length of time
+  // to wait before the next transmission in milliseconds. Returns no value once the queue is empty.
+  // Shared by the main loop transmission handler and the dedicated transmit task.
+  optional<uint32_t> transmit_next_frame(Transmitter &tx, bool abbreviated_sync);
+
+  // Moves the first command that is not waiting to be retried to the front of the queue. Returns
+  // false, with the time until the next retry, if every command is waiting.
+  bool select_ready_command(Transmitter &tx, uint32_t *wait_millis);
+
+  // Counts a failed transmission against the command at the front of the queue, and either moves it
+  // back for a later retry or gives it up.
+  void handle_transmit_failure(Transmitter &tx);
+
+  static bool needs_wakeup(const Transmitter &tx) {
+    return !tx.has_sent_wakeup || millis() - tx.last_wakeup_millis >= wakeup_cooldown_millis;
+  }
+
+  CommandHandle schedule_command(RTSControlCode control_code, RTSChannel *rts_channel, int num_repetitions,
+                                 int max_repetitions, bool hold);
+
+  // Builds a command with the given rolling code value, if any, and otherwise consumes a new one.
+  ScheduledCommand make_command(RTSControlCode control_code, RTSChannel *rts_channel, int num_repetitions,
+                                int max_repetitions, CommandHandle handle, optional<uint16_t> rolling_code = {});
+
+  // Sizes the pool of pending commands for a full queue on every transmitter, with as many commands
+  // again that are done and wait for their results to be reported.
+  void init_pending_commands_();
+
+  // Starts tracking a new command, whose copies get counted by add_command_copy(). Returns 0 if
+  // every slot of the pool is taken. The handle encodes the command's slot of the pool.
+  CommandHandle new_command_handle(RTSControlCode control_code, uint32_t channel_id);
+  // Returns the pending command with the given handle, or a free slot for handle 0.
+  PendingCommand *find_pending_command_(CommandHandle handle);
+  size_t pending_command_slot_(CommandHandle handle) const { return (handle - 1) % this->pending_commands_capacity_; }
+  void add_command_copy(CommandHandle handle);
+
+  // Reports the result of one copy of a command from the context that transmits on tx, either for a
+  // copy that never entered the queue or for a queued one along with its statistics.
+  void note_command_done(Transmitter &tx, CommandHandle handle, CommandResult result);
+  void note_command_done(Transmitter &tx, const ScheduledCommand &command, CommandResult result);
+
+  // Folds the result of one copy into the pending command and the statistics. Main loop only.
+  void resolve_command_copy(const CommandOutcome &outcome);
+
+  // Reports the results of all commands that are done. Main loop only.
+  void report_done_commands();
+
+  // Sends the next batch of queued boot restore commands, and schedules the one after it.
+  void send_boot_restore_batch_();
+
+  // Requests a wakeup from every transmitter while the prewake hold lasts, and schedules the next
+  // request before the devices would fall asleep again.
+  void request_prewake_();
+
+  // Sends a requested wakeup unless devices are still awake or its airtime is not available.
+  // Returns the time to wait before further transmissions, or no value if nothing was sent.
+  optional<uint32_t> transmit_prewake(Transmitter &tx);
+
+  // Starts the transmission handler if it is not already running.
+  void schedule_transmit_task(Transmitter &tx);
+
+  // Adds a command to the queue, after any other urgent commands if it is urgent and at the end
+  // otherwise. The queue must not be full.
+  void enqueue_command(Transmitter &tx, const ScheduledCommand &command);
+
+  // Number of repetitions for a command that is about to enter the queue, given the commands that
+  // are already waiting and the remaining airtime budget.
+  uint8_t adapt_repetitions(Transmitter &tx, const ScheduledCommand &command);
+
+  // Remaining airtime in the budget window, or UINT32_MAX if there is no airtime budget.
+  uint32_t remaining_airtime_budget_micros(Transmitter &tx);
+
+  // Adds airtime that was just transmitted to the statistics and the budget window.
+  void record_airtime(Transmitter &tx, uint32_t micros);
+
+  // Logs the first transmission of a command and records whether it needed its own wakeup signal.
+  void note_command_started(Transmitter &tx, ScheduledCommand &command, bool after_wakeup);
+
+  // Coalesces or enqueues a command that was built before it reached the queue, which is the case
+  // for commands handed to the dedicated transmit task.
+  void accept_command(Transmitter &tx, const ScheduledCommand &command);
+
+  // Applies the overflow policy if the queue is full. Returns false if there is still no room for
+  // the new command, in which case it must be rejected.
+  bool make_room_in_queue(Transmitter &tx, bool urgent);
+
+  // If the most recently scheduled command for the channel has not started transmitting and gets
+  // superseded by the new control code, rewrites it in place, reusing its rolling code value.
+  // Returns true if the new command was merged this way.
+  // The pending command takes over the new command's handle, and its own is reported superseded.
+  // A STOP instead removes the pending command, and is itself done without being sent.
+  bool coalesce_pending_command(Transmitter &tx, RTSControlCode control_code, uint32_t channel_id,
+                                int num_repetitions, int max_repetitions, CommandHandle handle);
+
+  // OPEN and CLOSE each override whatever movement the previous one started. A STOP for a movement
+  // that never started has nothing to stop, but one that gets queued is always sent.
+  static bool is_coalescible_control_code(RTSControlCode control_code) {
+    return control_code == OPEN || control_code == CLOSE;
+  }
+
+  static Payload encode_payload(RTSControlCode control_code, uint32_t channel_id, uint16_t rolling_code);
+
+  // Searches raw receive timings, starting at *index, for the next frame that decodes with a valid
+  // checksum. On success, advances *index past the frame. Works directly on the receiver's buffer
+  // without allocating.
+  static bool decode_frame(const remote_base::RawTimings &timings, size_t *index, ReceivedFrame *frame);
+
+  // Recovers the obfuscated payload from the Manchester-encoded data that follows a software sync
+  // mark, advancing *position past it.
+  static bool demodulate_payload(const remote_base::RawTimings &timings, size_t *position, Payload *payload);
+
+  // Reverses the obfuscation of a payload and verifies its checksum.
+  static bool decode_payload(const Payload &payload, ReceivedFrame *frame);
+
+  static bool matches_duration(uint32_t duration, uint32_t expected);
+
+#ifdef USE_RTS_TRANSMIT_TASK
+  // In transmit task mode, schedule_rts_command() builds commands on the main loop, including
+  // consuming their rolling code values, and hands them to the task, which owns the queue.
+  void submit_to_transmit_task(Transmitter &tx, const ScheduledCommand &command);
+  // Hands a command to the tasks of all transmitters that reach its channel.
+  void submit_to_transmit_tasks_(RTSChannel *rts_channel, const ScheduledCommand &command);
+
+  // Coalescing on the main loop: if the newest pending command on the channel has not started
+  // transmitting and gets superseded by the new control code, withdraws and returns it. The new
+  // command takes its rolling code value over, and the task merges it into its place. A STOP
+  // cancels the pending command instead, and is done without reaching the task.
+  PendingCommand *withdraw_pending_command_(RTSControlCode control_code, uint32_t channel_id, CommandHandle handle);
+  std::atomic<uint8_t> &command_claim_(CommandHandle handle) {
+    return this->command_claims_[this->pending_command_slot_(handle)];
+  }
+  void run_transmit_task(Transmitter &tx);
+  void notify_transmit_task(Transmitter &tx);
+  // Blocks until new commands or a prewake request arrive, or until the timeout passes. Returns
+  // false once the task has to end.
+  bool wait_for_transmit_task_work(Transmitter &tx, optional<uint32_t> timeout_millis = {});
+#endif
 
   // Transmits the wakeup signal and returns the length of time to wait before further
-  // transmissions in milliseconds. Sets failure_observed_ on error.
-  uint32_t transmit_wakeup();
+  // transmissions in milliseconds. Sets failure_observed on error.
+  uint32_t transmit_wakeup(Transmitter &tx);
 
   // Transmits one RTS command packet, including synchronization signals, and returns the length
-  // of time to wait before further transmissions in milliseconds. Sets failure_observed_ on
-  // error.
-  uint32_t transmit_command(RTSControlCode control_code, uint32_t channel_id, uint16_t rolling_code,
-                            bool abbreviated_sync = false);
+  // of time to wait before further transmissions in milliseconds. Adds the frame's airtime to the
+  // command. Sets failure_observed on error.
+  uint32_t transmit_command(Transmitter &tx, ScheduledCommand &command, bool abbreviated_sync = false);
+
+  // Transmits num_frames repetitions of a command, starting at its next repetition and optionally
+  // preceded by the wakeup signal, in one TransmitCall, with the silences between them encoded as
+  // spaces. The first frame gets abbreviated sync if abbreviated_sync is set, and the others always
+  // do. Adds the frames' airtime to the command. Returns the length of time to wait before further
+  // transmissions in milliseconds. Sets failure_observed on error.
+  uint32_t transmit_burst(Transmitter &tx, ScheduledCommand &command, int num_frames, bool include_wakeup,
+                          bool abbreviated_sync);
+
+  // Marks the command at the front of the queue as started before its first frame goes out. In
+  // transmit task mode, drops it instead if the main loop withdrew it, and returns false.
+  bool claim_front_command_(Transmitter &tx);
+
+  // Streams the next part of a hold command, of up to hold_part_frames frames in one burst, so that
+  // they are paced by the transmitter hardware rather than by the loop. The first frame of the hold
+  // always gets full sync, even right after a wakeup, so that the hold lasts hold_duration_millis()
+  // however it starts.
+  uint32_t transmit_hold(Transmitter &tx, ScheduledCommand &command, bool abbreviated_sync);
+
+  // Records a transmitted frame of the command in the transmitter's trace.
+  static void trace_frame(Transmitter &tx, const ScheduledCommand &command, uint32_t frame_millis, uint8_t repetition,
+                          RTSTraceBuffer::FrameKind kind);
+
+  // Returns the raw timings for a frame, encoding it only if it differs from the most recently
+  // encoded frame.
+  const remote_base::RawTimings &frame_timings(Transmitter &tx, const Payload &payload, bool abbreviated_sync);
+
+  // Expands a payload into the raw mark/space timings of a complete frame, compensated for the
+  // transmitter's mark overhead, replacing the contents of the transmitter's frame_timings.
+  void encode_frame(Transmitter &tx, const Payload &payload, bool abbreviated_sync);
 
-  // Before sending a command, the transmitter sends a long wakeup signal followed by radio
-  // silence.
-  static constexpr uint32_t wakeup_signal_high_micros = 9415;
-  static constexpr uint32_t wakeup_signal_low_millis = 90;  // 89565 microsends per the spec
+  // The timing profile that frames get encoded with, selected at compile time.
+#ifdef USE_RTS_ROUNDED_TIMING
+  using TimingProfile = RTSRoundedTiming;
+#else
+  using TimingProfile = RTSSpecTiming;
+#endif
+  using Timing = RTSTimingTables<TimingProfile>;
+
+  static constexpr uint32_t wakeup_signal_high_micros = TimingProfile::wakeup_high_micros;
+  static constexpr uint32_t wakeup_signal_low_micros = TimingProfile::wakeup_low_micros;
+  static constexpr uint32_t wakeup_signal_low_millis = Timing::loop_delay_millis(wakeup_signal_low_micros);
 
   // After sending one wakeup, don't send another one for another 10 seconds.
   static constexpr uint32_t wakeup_cooldown_millis = 10000;
 
-  // Total time to transmit a Manchester-encoded bit.
-  static constexpr uint32_t symbol_micros = 1208;
+  // A prewake renews the wakeup this long before the previous one expires.
+  static constexpr uint32_t prewake_lead_millis = 1000;
+
+  static constexpr uint32_t symbol_micros = TimingProfile::symbol_micros;
+  static constexpr uint32_t software_sync_high_micros = TimingProfile::software_sync_high_micros;
+  static constexpr uint32_t inter_frame_gap_micros = TimingProfile::inter_frame_gap_micros;
+  static constexpr uint32_t inter_frame_gap_millis = Timing::loop_delay_millis(inter_frame_gap_micros);
+
+  // The dedicated transmit task spends nearly all of its time blocked, so it can run at a higher
+  // priority than the main loop without starving it.
+  static constexpr uint32_t transmit_task_stack_size = 4096;
+  static constexpr uint32_t transmit_task_priority = 5;
+
+  // Each Manchester-encoded bit is one mark and one space.
+  static constexpr size_t payload_items = 2 * 8 * std::tuple_size<Payload>::value;
+  static constexpr size_t frame_items_upper_bound = Timing::full_sync_preamble.size() + payload_items;
+
+  // Airtime of a frame with full sync, which is used to estimate the airtime of queued frames.
+  static constexpr uint32_t frame_airtime_upper_bound_micros =
+      Timing::frame_airtime_micros(7, std::tuple_size<Payload>::value);
 
-  // Each data packet is preceded by a square-wave sync signal.
-  static constexpr uint32_t hardware_sync_high_micros = 2 * symbol_micros;
-  static constexpr uint32_t hardware_sync_low_micros = 2 * symbol_micros;
+  // A streamed hold goes out in parts of up to this many frames, as far as burst_max_items allows.
+  // Nothing else goes out between the parts. On the main loop, they are short enough to block it
+  // for no more than about a quarter second each, while the transmit task sends the whole hold in
+  // as few bursts as possible.
+#ifdef USE_RTS_TRANSMIT_TASK
+  static constexpr int hold_part_frames = UINT8_MAX;
+#else
+  static constexpr int hold_part_frames = 2;
+#endif
 
-  // After the hardware sync and before data bits get transmitted, there is one last
-  // synchronization signal that ends with half a signal of silence.
-  static constexpr uint32_t software_sync_high_micros = 4550;
-  static constexpr uint32_t software_sync_low_micros = symbol_micros / 2;
+  // Time from the start of one frame of a hold command to the start of the next: the first frame
+  // with full sync, and the ones after it with abbreviated sync.
+  static constexpr uint32_t hold_first_frame_period_micros =
+      Timing::frame_airtime_micros(7, std::tuple_size<Payload>::value) + inter_frame_gap_micros;
+  static constexpr uint32_t hold_frame_period_micros =
+      Timing::frame_airtime_micros(2, std::tuple_size<Payload>::value) + inter_frame_gap_micros;
 
-  static constexpr uint32_t inter_frame_gap_millis = 30;  // 30415 microseconds per the spec
+  // A burst holds the optional wakeup mark and silence, each frame, and a gap between frames.
+  static constexpr size_t burst_items_upper_bound(int num_repetitions, bool include_wakeup) {
+    return (include_wakeup ? 2 : 0) + num_repetitions * (frame_items_upper_bound + 1);
+  }
 
-  // Approximate number of data items needed to send a single command. Used to reserve space when
-  // building a TransmitCall.
-  static constexpr uint32_t transmit_items_per_command_upper_bound = 130;
+  // Sums the mark and space durations of a sequence of raw timings.
+  static uint32_t airtime_micros(const remote_base::RawTimings &timings);
 
-  remote_transmitter::RemoteTransmitterComponent *transmitter_;
+#ifdef USE_RTS_TRANSMIT_TASK
+  // Counters that the transmit tasks increment while the main loop reads them.
+  using Counter = std::atomic<uint32_t>;
+#else
+  using Counter = uint32_t;
+#endif
+
+  std::vector<std::unique_ptr<Transmitter>> transmitters_;
+  size_t queue_capacity_{32};
+  RTSChannelRegistry channel_registry_;
   int command_repetitions_ = 2;
+  int min_command_repetitions_ = 2;
+  int max_command_repetitions_ = 2;
+  uint8_t airtime_budget_percent_{0};
+  uint32_t airtime_budget_window_millis_{3600000};
+  uint16_t urgent_control_codes_ = 1 << STOP;
+
+  QueueOverflowPolicy queue_overflow_policy_{OVERFLOW_REJECT_NEW};
+  bool burst_transmit_{false};
+  size_t burst_max_items_{1024};
+  uint8_t max_command_retries_{3};
+  uint32_t retry_backoff_millis_{100};
+  size_t trace_size_{32};
+  Counter queue_overflow_count_{0};
+
+  bool has_receiver_{false};
+  bool has_received_frame_{false};
+  ReceivedFrame last_received_frame_{};
+  CallbackManager<void(const ReceivedFrame &)> frame_received_callback_{};
+
+  // Written only by the producer side when the transmit task's inbox is full.
+  uint32_t transmit_task_inbox_overflow_count_{0};
+
+#ifdef USE_RTS_TRANSMIT_TASK
+  int transmit_task_core_{1};
+  // Claims of the commands in the pending pool, by slot.
+  std::unique_ptr<std::atomic<uint8_t>[]> command_claims_;
+
+  // Commands of a group, which go to the tasks once all of their rolling codes are saved.
+  struct GroupCommand {
+    RTSChannel *rts_channel;
+    ScheduledCommand command;
+  };
+  std::vector<GroupCommand> group_commands_;
+#endif
+  Counter coalesced_command_count_{0};
+  uint8_t last_group_id_{0};
+
+  uint32_t last_command_sequence_{0};
+  std::unique_ptr<PendingCommand[]> pending_commands_;
+  size_t pending_commands_capacity_{0};
+  size_t num_pending_commands_{0};
+  CallbackManager<void(CommandHandle, uint32_t, RTSControlCode, CommandResult)> command_done_callback_{};
+
+  struct BootRestoreCommand {
+    RTSControlCode control_code;
+    RTSChannel *rts_channel;
+  };
+  std::vector<BootRestoreCommand> boot_restore_commands_;
+  size_t next_boot_restore_command_{0};
+  uint32_t boot_restore_delay_millis_{5000};
+  size_t boot_restore_batch_size_{8};
+  uint32_t boot_restore_interval_millis_{2000};
+  uint32_t last_urgent_latency_millis_{0};
+
+  // Rolling statistics over the last statistics_window_size commands. They get fed from the results
+  // of commands, so that only the main loop touches them.
+  static constexpr size_t statistics_window_size = 64;
+  RTSSampleWindow<statistics_window_size> command_latency_millis_;
+  RTSSampleWindow<statistics_window_size> command_airtime_micros_;
+  RTSSampleWindow<statistics_window_size> queue_depth_;
+  Counter wakeups_sent_{0};
+  Counter wakeups_skipped_{0};
 
-  std::queue<ScheduledCommand> scheduled_commands_;
-  bool is_transmit_task_scheduled_{false};
-  bool needs_wakeup_{true};
-  bool failure_observed_{false};
+  bool predictive_wakeup_{false};
+  uint32_t prewake_hold_millis_{30000};
+  uint8_t prewake_airtime_percent_{1};
+  bool is_prewake_active_{false};
+  uint32_t prewake_until_millis_{0};
+  Counter prewakes_sent_{0};
+  Counter prewake_latency_saved_millis_{0};
+  Counter cancelled_command_count_{0};
 };
 
 }  // namespace rts
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace rts {
+
+// Tracks the airtime used in a sliding window of time. The window is split into a fixed number of
+// buckets, and airtime expires one bucket at a time as the window moves forward.
+class RTSAirtimeWindow {
+ public:
+  static constexpr size_t num_buckets = 16;
+
+  void set_window_millis(uint32_t window_millis) {
+    this->bucket_millis_ = window_millis >= num_buckets ? window_millis / num_buckets : 1;
+  }
+  uint32_t window_millis() const { return this->bucket_millis_ * num_buckets; }
+
+  void add(uint32_t now_millis, uint32_t airtime_micros) {
+    this->advance_(now_millis);
+    this->buckets_[this->current_bucket_] += airtime_micros;
+  }
+
+  uint64_t used_micros(uint32_t now_millis) {
+    this->advance_(now_millis);
+    uint64_t total = 0;
+    for (uint32_t bucket : this->buckets_) {
+      total += bucket;
+    }
+    return total;
+  }
+
+  // Time until the oldest bucket expires and its airtime becomes available again.
+  uint32_t millis_until_next_bucket(uint32_t now_millis) {
+    this->advance_(now_millis);
+    return this->bucket_millis_ - (now_millis - this->bucket_start_millis_);
+  }
+
+ protected:
+  void advance_(uint32_t now_millis) {
+    uint32_t elapsed_buckets = (now_millis - this->bucket_start_millis_) / this->bucket_millis_;
+    if (elapsed_buckets == 0) {
+      return;
+    }
+    for (uint32_t i = 0; i < elapsed_buckets && i < num_buckets; i++) {
+      this->current_bucket_ = (this->current_bucket_ + 1) % num_buckets;
+      this->buckets_[this->current_bucket_] = 0;
+    }
+    this->bucket_start_millis_ += elapsed_buckets * this->bucket_millis_;
+  }
+
+  std::array<uint32_t, num_buckets> buckets_{};
+  size_t current_bucket_{0};
+  uint32_t bucket_start_millis_{0};
+  uint32_t bucket_millis_{1000};
+};
+
+}  // namespace rts
+}  // namespace esphome
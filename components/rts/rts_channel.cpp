@@ -6,59 +6,158 @@ namespace rts {
 
 static const char *const TAG = "rts.channel";
 
-void RTSChannel::init(uint32_t preference_id, const std::string &component_name) {
-  this->component_name_ = component_name;
-  this->rtc_ = global_preferences->make_preference<ChannelState>(preference_id);
-  if (!this->rtc_.load(&this->state_)) {
-    ESP_LOGW(TAG, "Failed to load channel information (INCLUDING ROLLING CODE) for RTS component: %s",
-             this->component_name_.c_str());
+uint16_t RTSChannelRegistry::add_channel(const void *handle, uint32_t preference_id, const char *name) {
+  uint16_t index = this->entries_.size();
+  this->entries_.emplace_back();
+  auto &entry = this->entries_.back();
+  entry.name = name;
+  entry.transmitter_mask = 0;
+  entry.channel_table_slot = -1;
+  entry.first_callback = no_callback;
+  entry.flash_writes_avoided = 0;
+
+  for (size_t i = 0; i < this->unbound_callbacks_.size();) {
+    if (this->unbound_callbacks_[i].handle != handle) {
+      i++;
+      continue;
+    }
+    this->add_on_channel_update_callback(index, std::move(this->unbound_callbacks_[i].callback));
+    this->unbound_callbacks_.erase(this->unbound_callbacks_.begin() + i);
+  }
+
+  ChannelState state{};
+  bool loaded = false;
+  bool migrate = false;
+  if (this->channel_table_ != nullptr) {
+    bool found;
+    int slot = this->channel_table_->claim(preference_id != 0 ? preference_id : 1, &found);
+    if (slot >= 0) {
+      entry.channel_table_slot = slot;
+      if (found) {
+        state.channel_id = this->channel_table_->channel_id(slot);
+        state.rolling_code = this->channel_table_->rolling_code(slot);
+        loaded = true;
+      }
+      // Once the table has been saved, it is the only store, and the channel's own record, if it has
+      // one, is older than the table. Only a table that was just enabled takes state from them.
+      migrate = !found && !this->channel_table_->has_saved_state();
+    } else {
+      ESP_LOGE(TAG, "RTS channel table is full; RTS component %s uses its own preference record", name);
+    }
+  }
+
+  if (entry.channel_table_slot < 0) {
+    entry.rtc = global_preferences->make_preference<ChannelState>(preference_id);
+    loaded = entry.rtc.load(&state);
+  } else if (migrate) {
+    loaded = global_preferences->make_preference<ChannelState>(preference_id).load(&state);
+    if (loaded) {
+      ESP_LOGI(TAG, "Moving channel information for RTS component %s into the channel table", name);
+    }
+  }
+
+  if (!loaded) {
+    ESP_LOGW(TAG, "Failed to load channel information (INCLUDING ROLLING CODE) for RTS component: %s", name);
     ESP_LOGW(TAG, "Entity will be initialized as a NEW REMOTE with a random channel id");
 
     // Choose a random channel and random start point for the rolling code. The code always starts
     // from the lower half of possible values, because I haven't tested that rollover works :).
-    this->state_.channel_id = 0xffffff & random_uint32();
-    this->state_.rolling_code = 0x7fff & static_cast<uint16_t>(random_uint32());
+    state.channel_id = 0xffffff & random_uint32();
+    state.rolling_code = 0x7fff & static_cast<uint16_t>(random_uint32());
   }
-  ESP_LOGI(TAG, "Initialized RTS component %s with channel id 0x%x; next rolling code value is %u",
-           this->component_name_.c_str(), this->state_.channel_id, this->state_.rolling_code);
+
+  entry.channel_id = state.channel_id;
+  entry.rolling_code = state.rolling_code;
+
+  // After an unclean shutdown, the persisted value is the high-water mark of the last lease, which
+  // is safely ahead of any rolling code value that was transmitted.
+  entry.leased_rolling_code = state.rolling_code;
+  if (entry.channel_table_slot >= 0) {
+    this->channel_table_->set(entry.channel_table_slot, entry.channel_id, entry.rolling_code);
+  }
+  ESP_LOGI(TAG, "Initialized RTS component %s with channel id 0x%x; next rolling code value is %u", name,
+           entry.channel_id, entry.rolling_code);
+  return index;
 }
 
-void RTSChannel::config_channel(optional<uint16_t> channel_id, optional<uint16_t> rolling_code) {
+void RTSChannelRegistry::config_channel(uint16_t index, optional<uint16_t> channel_id,
+                                        optional<uint16_t> rolling_code) {
+  auto &entry = this->entries_[index];
   if (channel_id.has_value()) {
-    ESP_LOGI(TAG, "Assigning new channel id to RTS component %s: previously %x, now %x", this->component_name_.c_str(),
-             this->state_.channel_id, channel_id.value());
-    this->state_.channel_id = channel_id.value();
+    ESP_LOGI(TAG, "Assigning new channel id to RTS component %s: previously %x, now %x", entry.name, entry.channel_id,
+             channel_id.value());
+    entry.channel_id = channel_id.value();
   }
   if (rolling_code.has_value()) {
-    ESP_LOGI(TAG, "Updating next rolling code value for RTS component %s: previously %u, now %u",
-             this->component_name_.c_str(), this->state_.rolling_code, rolling_code.value());
-    this->state_.rolling_code = rolling_code.value();
+    ESP_LOGI(TAG, "Updating next rolling code value for RTS component %s: previously %u, now %u", entry.name,
+             entry.rolling_code, rolling_code.value());
+    entry.rolling_code = rolling_code.value();
+    entry.leased_rolling_code = rolling_code.value();
   }
   if (!channel_id.has_value() && !rolling_code.has_value()) {
-    ESP_LOGW(TAG, "RTS cover component %s received no-op 'config_channel' action", this->component_name_.c_str());
+    ESP_LOGW(TAG, "RTS cover component %s received no-op 'config_channel' action", entry.name);
   }
 
-  this->persist_channel_state_();
+  this->persist_channel_state_(index, true);
 }
 
-uint16_t RTSChannel::consume_rolling_code_value() {
+uint16_t RTSChannelRegistry::consume_rolling_code_value(uint16_t index) {
+  auto &entry = this->entries_[index];
+
   // I have not exhaustively tested using 0 as the rolling code, but I observed it failing at
   // least once.
-  uint16_t consumedCode = this->state_.rolling_code != 0 ? this->state_.rolling_code : 1;
-  this->state_.rolling_code = consumedCode + 1;
+  uint16_t consumedCode = entry.rolling_code != 0 ? entry.rolling_code : 1;
+  entry.rolling_code = consumedCode + 1;
 
-  this->persist_channel_state_();
+  // Codes below the leased high-water mark are handed out from memory. Once they run out, a new
+  // lease gets persisted before the code is used. The comparison tolerates rollover.
+  if (static_cast<uint16_t>(consumedCode - entry.leased_rolling_code) < 0x8000) {
+    entry.leased_rolling_code = consumedCode + this->rolling_code_lease_size_;
+    this->persist_channel_state_(index);
+  } else {
+    entry.flash_writes_avoided++;
+    this->notify_channel_update_(index, false);
+  }
 
   return consumedCode;
 }
 
-void RTSChannel::persist_channel_state_() {
-  if (!this->rtc_.save(&this->state_)) {
-    ESP_LOGE(TAG, "Failed to persist channel state for RTS component %s", this->component_name_.c_str());
+void RTSChannelRegistry::release_rolling_code_lease(uint16_t index) {
+  auto &entry = this->entries_[index];
+  if (entry.leased_rolling_code == entry.rolling_code) {
+    return;
+  }
+
+  ESP_LOGD(TAG, "Releasing rolling code lease for RTS component %s at %u", entry.name, entry.rolling_code);
+  entry.leased_rolling_code = entry.rolling_code;
+  this->persist_channel_state_(index);
+}
+
+void RTSChannelRegistry::persist_channel_state_(uint16_t index, bool configured) {
+  auto &entry = this->entries_[index];
+  ChannelState persisted_state{entry.channel_id, entry.leased_rolling_code};
+  if (entry.channel_table_slot >= 0) {
+    // Saved with the rest of the table when RTS flushes it.
+    this->channel_table_->set(entry.channel_table_slot, persisted_state.channel_id, persisted_state.rolling_code);
+  } else if (!entry.rtc.save(&persisted_state)) {
+    ESP_LOGE(TAG, "Failed to persist channel state for RTS component %s", entry.name);
     ESP_LOGE(TAG, "  RTS CONTROL WILL DESYNCHRONIZE IF ESPHOME DEVICE SHUTS DOWN OR RESTARTS");
   }
 
-  this->channel_update_callback_.call(this->state_.channel_id, this->state_.rolling_code);
+  this->notify_channel_update_(index, configured);
+}
+
+void RTSChannelRegistry::add_on_channel_update_callback(uint16_t index, ChannelUpdateCallback &&callback) {
+  auto &entry = this->entries_[index];
+  this->callbacks_.push_back({std::move(callback), entry.first_callback});
+  entry.first_callback = this->callbacks_.size() - 1;
+}
+
+void RTSChannelRegistry::notify_channel_update_(uint16_t index, bool configured) {
+  const auto &entry = this->entries_[index];
+  for (uint16_t i = entry.first_callback; i != no_callback; i = this->callbacks_[i].next) {
+    this->callbacks_[i].callback(entry.channel_id, entry.rolling_code, configured);
+  }
 }
 
 }  // namespace rts
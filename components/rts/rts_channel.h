@@ -1,38 +1,194 @@
 #pragma once
 
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "esphome/core/helpers.h"
+#include "esphome/core/optional.h"
 #include "esphome/core/preferences.h"
+#include "rts_channel_table.h"
 
 namespace esphome {
 namespace rts {
 
-class RTSChannel {
+// Dense storage for the state of every RTS channel, owned by the RTS component. Channels are
+// addressed by their index, which RTSChannel handles hold.
+class RTSChannelRegistry {
  public:
-  void init(uint32_t preference_id, const std::string &component_name);
-  void config_channel(optional<uint16_t> channel_id, optional<uint16_t> rolling_code);
+  // Called with a channel's id and next rolling code value whenever they change, and whether the
+  // change came from config_channel() rather than from transmitting a command.
+  using ChannelUpdateCallback = std::function<void(uint32_t, uint16_t, bool)>;
 
-  // Returns an unused "rolling code" value and increments the stored rolling code value as a side
-  // effect, saving it to persistent storage.
-  uint16_t consume_rolling_code_value();
+  // Makes room for every channel ahead of time, so that registering channels during setup
+  // allocates the registry once instead of growing it.
+  void reserve_channels(size_t num_channels) { this->entries_.reserve(num_channels); }
+
+  // Loads or creates the state of a channel and returns its index. The name is only used for
+  // logging and must outlive the registry. Callbacks that were added for the handle before it had
+  // an index get bound to the new channel.
+  uint16_t add_channel(const void *handle, uint32_t preference_id, const char *name);
+
+  // A rolling_code_lease_size greater than 1 enables lease mode: persistent storage holds a
+  // rolling code value that many codes ahead of the next value, and only gets updated when the
+  // codes below it are used up.
+  uint16_t rolling_code_lease_size() const { return this->rolling_code_lease_size_; }
+  void set_rolling_code_lease_size(uint16_t rolling_code_lease_size) {
+    this->rolling_code_lease_size_ = rolling_code_lease_size;
+  }
+
+  // Keeps the state of all channels in one consolidated table instead of a preference record per
+  // channel. The table is then the only store. When it is first enabled, channels get migrated from
+  // their own records. Must be enabled before any channel gets added.
+  void enable_channel_table() { this->channel_table_.reset(new RTSChannelTable()); }
+  bool has_channel_table() const { return this->channel_table_ != nullptr; }
+  size_t channel_table_blocks() const { return this->channel_table_->num_blocks(); }
+  void flush_channel_table() {
+    if (this->channel_table_ != nullptr) {
+      this->channel_table_->flush();
+    }
+  }
+
+  size_t size() const { return this->entries_.size(); }
+
+  // Index of the channel with the given channel id, if any channel has it.
+  optional<uint16_t> find_channel(uint32_t channel_id) const {
+    for (size_t index = 0; index < this->entries_.size(); index++) {
+      if (this->entries_[index].channel_id == channel_id) {
+        return static_cast<uint16_t>(index);
+      }
+    }
+    return {};
+  }
+  static constexpr size_t bytes_per_channel() { return sizeof(Entry); }
 
-  uint32_t id() const { return state_.channel_id; }
-  uint16_t rolling_code() const { return state_.rolling_code; }
+  uint32_t channel_id(uint16_t index) const { return this->entries_[index].channel_id; }
+  uint16_t rolling_code(uint16_t index) const { return this->entries_[index].rolling_code; }
+  uint32_t flash_writes_avoided(uint16_t index) const { return this->entries_[index].flash_writes_avoided; }
+  uint8_t transmitter_mask(uint16_t index) const { return this->entries_[index].transmitter_mask; }
+  void set_transmitter_mask(uint16_t index, uint8_t transmitter_mask) {
+    this->entries_[index].transmitter_mask = transmitter_mask;
+  }
+
+  void config_channel(uint16_t index, optional<uint16_t> channel_id, optional<uint16_t> rolling_code);
+  uint16_t consume_rolling_code_value(uint16_t index);
+  void release_rolling_code_lease(uint16_t index);
 
-  void add_on_channel_update_callback(std::function<void(uint32_t, uint16_t)> &&f) {
-    this->channel_update_callback_.add(std::move(f));
+  // Callbacks are kept in a list per channel, so that an update only calls those of its own
+  // channel. A handle that has no index yet keeps its callbacks aside until add_channel().
+  void add_on_channel_update_callback(uint16_t index, ChannelUpdateCallback &&callback);
+  void add_on_channel_update_callback(const void *handle, ChannelUpdateCallback &&callback) {
+    this->unbound_callbacks_.push_back({handle, std::move(callback)});
   }
 
  protected:
+  // Persisted format of a channel's own preference record.
   struct ChannelState {
     uint32_t channel_id;
     uint16_t rolling_code;
-  } __attribute__((packed)) state_;
+  } __attribute__((packed));
+
+  struct Entry {
+    const char *name;
+    // The channel's own preference record, unless it is in the channel table.
+    ESPPreferenceObject rtc;
+    uint32_t channel_id : 24;
+
+    // Bitmask of the RTS transmitters that reach the channel's device. 0 selects every
+    // transmitter.
+    uint32_t transmitter_mask : 8;
+
+    uint16_t rolling_code;
+
+    // Rolling code value that is persisted as the high-water mark. Every value below it may
+    // already have been used.
+    uint16_t leased_rolling_code;
+
+    // Slot in the channel table, or -1 if the channel uses its own preference record.
+    int16_t channel_table_slot;
+
+    // First of the channel's update callbacks in callbacks_, or no_callback.
+    uint16_t first_callback;
+
+    // Number of rolling code values handed out without writing to persistent storage.
+    uint32_t flash_writes_avoided;
+  };
+
+  static constexpr uint16_t no_callback = 0xffff;
 
-  void persist_channel_state_();
+  // One update callback, linked to the next one of the same channel.
+  struct CallbackRecord {
+    ChannelUpdateCallback callback;
+    uint16_t next;
+  };
 
-  std::string component_name_;
-  ESPPreferenceObject rtc_;
+  struct UnboundCallback {
+    const void *handle;
+    ChannelUpdateCallback callback;
+  };
+
+  void persist_channel_state_(uint16_t index, bool configured = false);
+  void notify_channel_update_(uint16_t index, bool configured);
+
+  std::vector<Entry> entries_;
+  uint16_t rolling_code_lease_size_{1};
+  std::unique_ptr<RTSChannelTable> channel_table_;
+  std::vector<CallbackRecord> callbacks_;
+  std::vector<UnboundCallback> unbound_callbacks_;
+};
+
+// Handle to one channel's state in an RTSChannelRegistry.
+class RTSChannel {
+ public:
+  // The registry must be set before init(), and before callbacks get added.
+  void set_registry(RTSChannelRegistry *registry) { this->registry_ = registry; }
+  void init(uint32_t preference_id, const char *name) {
+    this->index_ = this->registry_->add_channel(this, preference_id, name);
+  }
+
+  // Addresses a channel that another handle already added to the registry, such as one found by
+  // RTSChannelRegistry::find_channel().
+  void attach(uint16_t index) { this->index_ = index; }
+
+  void config_channel(optional<uint16_t> channel_id, optional<uint16_t> rolling_code) {
+    this->registry_->config_channel(this->index_, channel_id, rolling_code);
+  }
+
+  // Returns an unused "rolling code" value and increments the stored rolling code value as a side
+  // effect, saving it to persistent storage unless the value is covered by the current lease.
+  uint16_t consume_rolling_code_value() { return this->registry_->consume_rolling_code_value(this->index_); }
+
+  // Saves the exact next rolling code value, so that a clean restart does not skip the unused
+  // remainder of the lease.
+  void release_rolling_code_lease() { this->registry_->release_rolling_code_lease(this->index_); }
+
+  uint32_t id() const { return this->registry_->channel_id(this->index_); }
+  uint16_t rolling_code() const { return this->registry_->rolling_code(this->index_); }
+
+  // Bitmask of the RTS transmitters that reach this channel's device. Commands go out on each of
+  // them. 0, the default, selects every transmitter.
+  uint8_t transmitter_mask() const { return this->registry_->transmitter_mask(this->index_); }
+  void set_transmitter_mask(uint8_t transmitter_mask) {
+    this->registry_->set_transmitter_mask(this->index_, transmitter_mask);
+  }
+
+  // Number of rolling code values handed out without writing to persistent storage.
+  uint32_t flash_writes_avoided() const { return this->registry_->flash_writes_avoided(this->index_); }
+
+  // May be called before init(); the callback only sees updates of this channel.
+  void add_on_channel_update_callback(RTSChannelRegistry::ChannelUpdateCallback &&callback) {
+    if (this->index_ == no_index) {
+      this->registry_->add_on_channel_update_callback(static_cast<const void *>(this), std::move(callback));
+    } else {
+      this->registry_->add_on_channel_update_callback(this->index_, std::move(callback));
+    }
+  }
+
+ protected:
+  static constexpr uint16_t no_index = 0xffff;
 
-  CallbackManager<void(uint32_t, uint16_t)> channel_update_callback_{};
+  RTSChannelRegistry *registry_{nullptr};
+  uint16_t index_{no_index};
 };
 
 }  // namespace rts
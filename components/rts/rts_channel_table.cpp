@@ -0,0 +1,179 @@
+#include <cstddef>
+
+#include "rts_channel_table.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/log.h"
+
+namespace esphome {
+namespace rts {
+
+static const char *const TAG = "rts.channel_table";
+
+int RTSChannelTable::claim(uint32_t key, bool *found) {
+  this->load_();
+  *found = false;
+
+  optional<int> free_slot;
+  optional<int> stale_slot;
+  for (size_t b = 0; b < this->blocks_.size(); b++) {
+    auto &loaded = *this->blocks_[b];
+    for (size_t e = 0; e < entries_per_block; e++) {
+      int slot = b * entries_per_block + e;
+      const auto &entry = loaded.block.entries[e];
+      if (entry.key == key && !loaded.is_claimed[e]) {
+        loaded.is_claimed[e] = true;
+        *found = true;
+        return slot;
+      } else if (entry.key == 0 && !free_slot.has_value()) {
+        free_slot = slot;
+      } else if (!loaded.is_claimed[e] && !stale_slot.has_value()) {
+        stale_slot = slot;
+      }
+    }
+  }
+
+  if (!free_slot.has_value() && this->blocks_.size() < max_blocks) {
+    this->add_block_();
+    free_slot = (this->blocks_.size() - 1) * entries_per_block;
+  }
+  if (!free_slot.has_value() && stale_slot.has_value()) {
+    ESP_LOGW(TAG, "RTS channel table is full; discarding state of unused entry 0x%08x",
+             this->entry_(*stale_slot).key);
+    free_slot = stale_slot;
+  }
+  if (!free_slot.has_value()) {
+    return -1;
+  }
+
+  int slot = *free_slot;
+  this->blocks_[slot / entries_per_block]->is_claimed[slot % entries_per_block] = true;
+  this->entry_(slot).key = key;
+  return slot;
+}
+
+void RTSChannelTable::set(int slot, uint32_t channel_id, uint16_t rolling_code) {
+  auto &entry = this->entry_(slot);
+  entry.channel_id = channel_id;
+  entry.rolling_code = rolling_code;
+  this->blocks_[slot / entries_per_block]->is_dirty = true;
+  this->is_dirty_ = true;
+}
+
+void RTSChannelTable::flush() {
+  if (!this->is_dirty_) {
+    return;
+  }
+
+  for (auto &loaded : this->blocks_) {
+    if (!loaded->is_dirty) {
+      continue;
+    }
+    loaded->block.num_blocks = this->blocks_.size();
+    loaded->block.generation++;
+    loaded->block.crc = block_crc_(loaded->block);
+    uint8_t copy = 1 - loaded->current_copy;
+    if (!loaded->copies[copy].save(&loaded->block)) {
+      ESP_LOGE(TAG, "Failed to persist RTS channel table");
+      ESP_LOGE(TAG, "  RTS CONTROL WILL DESYNCHRONIZE IF ESPHOME DEVICE SHUTS DOWN OR RESTARTS");
+      continue;
+    }
+    loaded->current_copy = copy;
+    loaded->is_dirty = false;
+  }
+  this->is_dirty_ = false;
+  ESP_LOGV(TAG, "Flushed RTS channel table");
+}
+
+void RTSChannelTable::load_() {
+  if (this->is_loaded_) {
+    return;
+  }
+  this->is_loaded_ = true;
+
+  // The first block records how many blocks there are. If it is unreadable, every possible block
+  // gets probed, so that one corrupt block does not take the others down with it.
+  bool has_first_block = this->load_block_(0);
+  size_t num_blocks = has_first_block ? this->blocks_[0]->block.num_blocks : max_blocks;
+  for (size_t i = 1; i < num_blocks && i < max_blocks; i++) {
+    if (!this->load_block_(i) && has_first_block) {
+      // Channels whose entries were in the block start over as new remotes.
+      ESP_LOGE(TAG, "Both copies of RTS channel table block %zu are missing or corrupt", i);
+    }
+  }
+
+  for (auto &loaded : this->blocks_) {
+    this->has_saved_state_ |= loaded->block.num_blocks != 0;
+  }
+
+  // Blocks past the last valid one were never written.
+  while (!this->blocks_.empty() && this->blocks_.back()->block.num_blocks == 0) {
+    this->blocks_.pop_back();
+  }
+  for (auto &loaded : this->blocks_) {
+    if (loaded->block.num_blocks != this->blocks_.size()) {
+      loaded->is_dirty = true;
+      this->is_dirty_ = true;
+    }
+  }
+  ESP_LOGD(TAG, "Loaded RTS channel table with %zu blocks", this->blocks_.size());
+}
+
+bool RTSChannelTable::load_block_(size_t index) {
+  auto &loaded = this->append_block_();
+  bool is_valid = false;
+  for (uint8_t copy = 0; copy < 2; copy++) {
+    Block block;
+    if (!loaded.copies[copy].load(&block) || block.crc != block_crc_(block) || block.num_blocks <= index) {
+      continue;
+    }
+    if (!is_valid || static_cast<int32_t>(block.generation - loaded.block.generation) > 0) {
+      loaded.block = block;
+      loaded.current_copy = copy;
+      is_valid = true;
+    }
+  }
+  if (!is_valid) {
+    loaded.block = {};
+  }
+  return is_valid;
+}
+
+RTSChannelTable::LoadedBlock &RTSChannelTable::append_block_() {
+  std::unique_ptr<LoadedBlock> loaded(new LoadedBlock());
+  // The copies of a block have keys max_blocks apart.
+  uint32_t key = fnv1_hash("rts_channel_table") + this->blocks_.size();
+  loaded->copies[0] = global_preferences->make_preference<Block>(key);
+  loaded->copies[1] = global_preferences->make_preference<Block>(key + max_blocks);
+  loaded->current_copy = 1;
+  loaded->block = {};
+  loaded->is_dirty = false;
+  loaded->is_claimed = {};
+  this->blocks_.push_back(std::move(loaded));
+  return *this->blocks_.back();
+}
+
+void RTSChannelTable::add_block_() {
+  this->append_block_();
+
+  // Every block records the number of blocks, so all of them need saving.
+  for (auto &loaded : this->blocks_) {
+    loaded->is_dirty = true;
+  }
+  this->is_dirty_ = true;
+}
+
+uint16_t RTSChannelTable::block_crc_(const Block &block) {
+  // CRC-16/CCITT over everything but the CRC itself.
+  const auto *data = reinterpret_cast<const uint8_t *>(&block);
+  uint16_t crc = 0xffff;
+  for (size_t i = 0; i < offsetof(Block, crc); i++) {
+    crc ^= static_cast<uint16_t>(data[i]) << 8;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+  }
+  return crc;
+}
+
+}  // namespace rts
+}  // namespace esphome
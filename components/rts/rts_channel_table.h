@@ -0,0 +1,99 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#include "esphome/core/preferences.h"
+
+namespace esphome {
+namespace rts {
+
+// Persists the state of all RTS channels in a few CRC-protected blocks of entries, instead of one
+// preference record per channel. Entries are keyed by the channel's preference id, so they follow
+// covers across configuration changes. Updates only mark their block dirty; flush() saves the
+// dirty blocks in one batch. Each block has two copies that saves alternate between, so a save that
+// gets interrupted leaves the previous contents of the block intact in the other copy.
+class RTSChannelTable {
+ public:
+  static constexpr size_t entries_per_block = 16;
+  static constexpr size_t max_blocks = 16;
+
+  // Returns the slot for the key, claiming a free one if the table has no entry for it yet.
+  // Sets *found if the slot holds state that was loaded from persistent storage. Returns a negative
+  // value if the table is full.
+  int claim(uint32_t key, bool *found);
+
+  uint32_t channel_id(int slot) const { return this->entry_(slot).channel_id; }
+  uint16_t rolling_code(int slot) const { return this->entry_(slot).rolling_code; }
+  void set(int slot, uint32_t channel_id, uint16_t rolling_code);
+
+  bool is_dirty() const { return this->is_dirty_; }
+
+  // Whether any block was loaded from persistent storage, that is, the table was saved before.
+  bool has_saved_state() {
+    this->load_();
+    return this->has_saved_state_;
+  }
+
+  // Saves every block that changed since the last flush.
+  void flush();
+
+  size_t num_blocks() const { return this->blocks_.size(); }
+
+ protected:
+  struct Entry {
+    // 0 marks a free entry.
+    uint32_t key;
+    uint32_t channel_id;
+    uint16_t rolling_code;
+  } __attribute__((packed));
+
+  struct Block {
+    // Number of blocks in the table when this block was saved.
+    uint8_t num_blocks;
+    // Incremented by every save. Of two valid copies, the one with the higher generation is newer.
+    uint32_t generation;
+    std::array<Entry, entries_per_block> entries;
+    uint16_t crc;
+  } __attribute__((packed));
+
+  struct LoadedBlock {
+    Block block;
+    std::array<ESPPreferenceObject, 2> copies;
+    // Copy that holds the current contents of the block. The next save goes to the other one.
+    uint8_t current_copy;
+    bool is_dirty;
+
+    // Entries that belong to a channel that claimed them since boot. Entries that were loaded but
+    // not claimed are kept, in case their cover comes back, until the table runs out of room.
+    std::array<bool, entries_per_block> is_claimed;
+  };
+
+  void load_();
+
+  // Appends the block with the given index, loading the newer of its valid copies. Returns false if
+  // both copies are missing or corrupt, in which case the block is left empty.
+  bool load_block_(size_t index);
+
+  // Appends an empty block, without loading it.
+  LoadedBlock &append_block_();
+
+  // Grows the table by one empty block.
+  void add_block_();
+
+  Entry &entry_(int slot) { return this->blocks_[slot / entries_per_block]->block.entries[slot % entries_per_block]; }
+  const Entry &entry_(int slot) const {
+    return this->blocks_[slot / entries_per_block]->block.entries[slot % entries_per_block];
+  }
+
+  static uint16_t block_crc_(const Block &block);
+
+  std::vector<std::unique_ptr<LoadedBlock>> blocks_;
+  bool is_loaded_{false};
+  bool is_dirty_{false};
+  bool has_saved_state_{false};
+};
+
+}  // namespace rts
+}  // namespace esphome
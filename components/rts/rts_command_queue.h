@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+namespace esphome {
+namespace rts {
+
+// Fixed-capacity ring buffer used as the RTS transmission queue. Storage is allocated once by
+// init(), so scheduling and transmitting commands never touches the heap. Elements are addressed
+// by their position relative to the front of the queue.
+template<typename T> class RTSCommandQueue {
+ public:
+  void init(size_t capacity) {
+    this->buffer_.reset(new T[capacity]);
+    this->capacity_ = capacity;
+    this->head_ = 0;
+    this->size_ = 0;
+  }
+
+  size_t size() const { return this->size_; }
+  size_t capacity() const { return this->capacity_; }
+  bool empty() const { return this->size_ == 0; }
+  bool full() const { return this->size_ == this->capacity_; }
+
+  T &operator[](size_t index) { return this->buffer_[this->slot_(index)]; }
+  const T &operator[](size_t index) const { return this->buffer_[this->slot_(index)]; }
+  T &front() { return (*this)[0]; }
+
+  // The caller is responsible for checking full() before adding elements.
+  void push_back(const T &value) { this->insert(this->size_, value); }
+
+  void insert(size_t index, const T &value) {
+    for (size_t i = this->size_; i > index; i--) {
+      this->buffer_[this->slot_(i)] = this->buffer_[this->slot_(i - 1)];
+    }
+    this->buffer_[this->slot_(index)] = value;
+    this->size_++;
+  }
+
+  void pop_front() {
+    this->head_ = this->slot_(1);
+    this->size_--;
+  }
+
+  void erase(size_t index) {
+    if (index == 0) {
+      this->pop_front();
+      return;
+    }
+    for (size_t i = index; i + 1 < this->size_; i++) {
+      this->buffer_[this->slot_(i)] = this->buffer_[this->slot_(i + 1)];
+    }
+    this->size_--;
+  }
+
+  // Moves the front element behind the next count - 1 elements.
+  void rotate_front(size_t count) {
+    if (count < 2) {
+      return;
+    }
+    T value = this->front();
+    for (size_t i = 0; i + 1 < count; i++) {
+      this->buffer_[this->slot_(i)] = this->buffer_[this->slot_(i + 1)];
+    }
+    this->buffer_[this->slot_(count - 1)] = value;
+  }
+
+  void clear() {
+    this->head_ = 0;
+    this->size_ = 0;
+  }
+
+ protected:
+  size_t slot_(size_t index) const { return (this->head_ + index) % this->capacity_; }
+
+  std::unique_ptr<T[]> buffer_;
+  size_t capacity_{0};
+  size_t head_{0};
+  size_t size_{0};
+};
+
+}  // namespace rts
+}  // namespace esphome
@@ -0,0 +1,158 @@
+#include "rts.h"
+#include "esphome/core/log.h"
+
+namespace esphome {
+namespace rts {
+
+static const char *const TAG = "rts.receiver";
+
+// Received durations are matched against the protocol timings with this tolerance, in percent.
+static const uint32_t RECEIVE_TOLERANCE_PERCENT = 25;
+
+bool RTS::on_receive(remote_base::RemoteReceiveData data) {
+  const auto &timings = data.get_raw_data();
+
+  bool decoded_any = false;
+  size_t index = 0;
+  ReceivedFrame frame;
+  while (decode_frame(timings, &index, &frame)) {
+    decoded_any = true;
+
+    // Remotes repeat each frame for as long as a button is held. Only the first copy is reported.
+    if (this->has_received_frame_ && frame.channel_id == this->last_received_frame_.channel_id &&
+        frame.rolling_code == this->last_received_frame_.rolling_code) {
+      continue;
+    }
+    this->last_received_frame_ = frame;
+    this->has_received_frame_ = true;
+
+    ESP_LOGD(TAG, "Received RTS command -- Control code: 0x%x, Channel id: 0x%x, Rolling code value: %u",
+             frame.control_code, frame.channel_id, frame.rolling_code);
+    this->frame_received_callback_.call(frame);
+  }
+
+  return decoded_any;
+}
+
+bool RTS::decode_frame(const remote_base::RawTimings &timings, size_t *index, ReceivedFrame *frame) {
+  for (; *index < timings.size(); (*index)++) {
+    // Every frame's data starts right after the software sync mark, which is much longer than any
+    // other mark in the frame.
+    int32_t item = timings[*index];
+    if (item <= 0 || !matches_duration(item, software_sync_high_micros)) {
+      continue;
+    }
+
+    size_t position = *index + 1;
+    Payload payload;
+    if (!demodulate_payload(timings, &position, &payload)) {
+      continue;
+    }
+
+    if (!decode_payload(payload, frame)) {
+      ESP_LOGV(TAG, "Discarding RTS frame with invalid checksum");
+      continue;
+    }
+
+    *index = position;
+    return true;
+  }
+
+  return false;
+}
+
+bool RTS::demodulate_payload(const remote_base::RawTimings &timings, size_t *position, Payload *payload) {
+  constexpr uint32_t half_symbol = symbol_micros / 2;
+  constexpr size_t num_halves = payload_items;
+
+  payload->fill(0);
+
+  // The software sync ends with half a symbol of silence, which merges with the first half of the
+  // data when the first bit is a 1.
+  bool skipped_sync_half = false;
+  size_t half_index = 0;
+  bool first_half_is_mark = false;
+
+  while (half_index < num_halves) {
+    if (*position >= timings.size()) {
+      // A trailing space gets dropped by receivers that end the buffer on the last mark. If only the
+      // second half of a final 0 bit is missing, the frame is still complete.
+      if (half_index == num_halves - 1 && first_half_is_mark) {
+        half_index++;
+        break;
+      }
+      return false;
+    }
+
+    int32_t item = timings[(*position)++];
+    bool is_mark = item > 0;
+    uint32_t duration = is_mark ? item : -item;
+    uint32_t num_item_halves = (duration + half_symbol / 2) / half_symbol;
+
+    if (num_item_halves == 0) {
+      return false;
+    } else if (num_item_halves > 2) {
+      // Only the silence after the frame may be longer than a full symbol.
+      if (is_mark || half_index + num_item_halves < num_halves) {
+        return false;
+      }
+      num_item_halves = num_halves - half_index;
+    }
+
+    for (uint32_t i = 0; i < num_item_halves; i++) {
+      if (!skipped_sync_half) {
+        if (is_mark) {
+          return false;
+        }
+        skipped_sync_half = true;
+        continue;
+      }
+
+      if (half_index % 2 == 0) {
+        first_half_is_mark = is_mark;
+      } else if (first_half_is_mark == is_mark) {
+        // Manchester encoding always has an edge in the middle of a symbol.
+        return false;
+      } else if (!is_mark) {
+        // A falling edge is a 0 bit, and a rising edge is a 1 bit.
+        size_t bit_index = half_index / 2;
+        (*payload)[bit_index / 8] &= ~(0x80 >> (bit_index % 8));
+      } else {
+        size_t bit_index = half_index / 2;
+        (*payload)[bit_index / 8] |= 0x80 >> (bit_index % 8);
+      }
+      half_index++;
+    }
+  }
+
+  return true;
+}
+
+bool RTS::decode_payload(const Payload &payload, ReceivedFrame *frame) {
+  // Reverse the obfuscation applied by the transmitter.
+  Payload data;
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = payload[i] ^ (i > 0 ? payload[i - 1] : 0);
+  }
+
+  uint8_t checksum = 0;
+  for (uint8_t byte : data) {
+    checksum ^= byte ^ (byte >> 4);
+  }
+  if ((checksum & 0xf) != 0) {
+    return false;
+  }
+
+  frame->control_code = static_cast<RTSControlCode>(data[1] >> 4);
+  frame->rolling_code = (data[2] << 8) | data[3];
+  frame->channel_id = data[4] | (data[5] << 8) | (data[6] << 16);
+  return true;
+}
+
+bool RTS::matches_duration(uint32_t duration, uint32_t expected) {
+  uint32_t tolerance = expected * RECEIVE_TOLERANCE_PERCENT / 100;
+  return duration + tolerance >= expected && duration <= expected + tolerance;
+}
+
+}  // namespace rts
+}  // namespace esphome
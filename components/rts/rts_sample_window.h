@@ -0,0 +1,52 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace rts {
+
+// Keeps the most recent N samples of a measurement in a fixed array, so that percentiles over a
+// rolling window can be reported without any heap allocation.
+template<size_t N> class RTSSampleWindow {
+ public:
+  void add(uint32_t sample) {
+    this->samples_[this->next_] = sample;
+    this->next_ = (this->next_ + 1) % N;
+    if (this->size_ < N) {
+      this->size_++;
+    }
+  }
+
+  size_t size() const { return this->size_; }
+  bool empty() const { return this->size_ == 0; }
+
+  // Nearest-rank percentile of the samples in the window. Returns 0 if there are none.
+  uint32_t percentile(uint8_t percent) const {
+    if (this->size_ == 0) {
+      return 0;
+    }
+    std::array<uint32_t, N> sorted = this->samples_;
+    size_t rank = (this->size_ * percent + 99) / 100;
+    size_t index = rank > 0 ? rank - 1 : 0;
+    std::nth_element(sorted.begin(), sorted.begin() + index, sorted.begin() + this->size_);
+    return sorted[index];
+  }
+
+  uint32_t max() const {
+    if (this->size_ == 0) {
+      return 0;
+    }
+    return *std::max_element(this->samples_.begin(), this->samples_.begin() + this->size_);
+  }
+
+ protected:
+  std::array<uint32_t, N> samples_{};
+  size_t next_{0};
+  size_t size_{0};
+};
+
+}  // namespace rts
+}  // namespace esphome
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace esphome {
+namespace rts {
+
+// Lock-free queue for handing elements from exactly one producer thread to exactly one consumer
+// thread. Storage is allocated once by init(). Only standard C++ atomics are used, so the queue
+// behaves the same on microcontrollers and on a host build.
+template<typename T> class RTSSpscQueue {
+ public:
+  void init(size_t capacity) {
+    // One slot always stays empty to distinguish a full queue from an empty one.
+    this->buffer_.reset(new T[capacity + 1]);
+    this->num_slots_ = capacity + 1;
+  }
+
+  // Called only by the producer. Returns false if the queue is full.
+  bool push(const T &value) {
+    size_t tail = this->tail_.load(std::memory_order_relaxed);
+    size_t next_tail = (tail + 1) % this->num_slots_;
+    if (next_tail == this->head_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    this->buffer_[tail] = value;
+    this->tail_.store(next_tail, std::memory_order_release);
+    return true;
+  }
+
+  // Called only by the consumer. Returns false if the queue is empty.
+  bool pop(T &value) {
+    size_t head = this->head_.load(std::memory_order_relaxed);
+    if (head == this->tail_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    value = this->buffer_[head];
+    this->head_.store((head + 1) % this->num_slots_, std::memory_order_release);
+    return true;
+  }
+
+ protected:
+  std::unique_ptr<T[]> buffer_;
+  size_t num_slots_{0};
+  std::atomic<size_t> head_{0};
+  std::atomic<size_t> tail_{0};
+};
+
+}  // namespace rts
+}  // namespace esphome
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "esphome/components/remote_base/remote_base.h"
+
+namespace esphome {
+namespace rts {
+
+// Builds the synchronization signal that precedes each RTS data frame: a number of square-wave
+// hardware sync pulses followed by one software sync pulse, as alternating mark and space timings.
+template<size_t num_hardware_syncs>
+constexpr std::array<int32_t, 2 * num_hardware_syncs + 2> make_sync_preamble(uint32_t hardware_high_micros,
+                                                                           uint32_t hardware_low_micros,
+                                                                           uint32_t software_high_micros,
+                                                                           uint32_t software_low_micros) {
+  std::array<int32_t, 2 * num_hardware_syncs + 2> preamble{};
+  for (size_t i = 0; i < num_hardware_syncs; i++) {
+    preamble[2 * i] = static_cast<int32_t>(hardware_high_micros);
+    preamble[2 * i + 1] = -static_cast<int32_t>(hardware_low_micros);
+  }
+  preamble[2 * num_hardware_syncs] = static_cast<int32_t>(software_high_micros);
+  preamble[2 * num_hardware_syncs + 1] = -static_cast<int32_t>(software_low_micros);
+  return preamble;
+}
+
+// Timing profiles list the durations of each part of the RTS waveform. RTSSpecTiming follows the
+// protocol as documented at https://pushstack.wordpress.com/somfy-rts-protocol/.
+struct RTSSpecTiming {
+  // Before sending a command, the transmitter sends a long wakeup signal followed by radio
+  // silence.
+  static constexpr uint32_t wakeup_high_micros = 9415;
+  static constexpr uint32_t wakeup_low_micros = 89565;
+
+  // Total time to transmit a Manchester-encoded bit.
+  static constexpr uint32_t symbol_micros = 1208;
+
+  // Each data packet is preceded by a square-wave sync signal.
+  static constexpr uint32_t hardware_sync_high_micros = 2 * symbol_micros;
+  static constexpr uint32_t hardware_sync_low_micros = 2 * symbol_micros;
+
+  // After the hardware sync and before data bits get transmitted, there is one last
+  // synchronization signal that ends with half a signal of silence.
+  static constexpr uint32_t software_sync_high_micros = 4550;
+  static constexpr uint32_t software_sync_low_micros = symbol_micros / 2;
+
+  static constexpr uint32_t inter_frame_gap_micros = 30415;
+};
+
+// The timings this component used before profiles existed, with the silences rounded to whole
+// milliseconds.
+struct RTSRoundedTiming : RTSSpecTiming {
+  static constexpr uint32_t wakeup_low_micros = 90000;
+  static constexpr uint32_t inter_frame_gap_micros = 30000;
+};
+
+// Compensates for a transmitter that keeps each mark on for mark_overhead_micros longer than
+// requested: marks get shorter by that much, and spaces longer. Neither ever reaches 0.
+constexpr uint32_t compensated_mark_micros(uint32_t micros, int32_t mark_overhead_micros) {
+  return static_cast<int32_t>(micros) > mark_overhead_micros ? micros - mark_overhead_micros : 1;
+}
+constexpr uint32_t compensated_space_micros(uint32_t micros, int32_t mark_overhead_micros) {
+  return static_cast<int32_t>(micros) > -mark_overhead_micros ? micros + mark_overhead_micros : 1;
+}
+
+// Waveform tables and frame encoding for one timing profile, generated at compile time.
+template<typename Profile> class RTSTimingTables {
+ public:
+  // Every duration of a profile must stay within this tolerance of the spec. Receivers accept
+  // larger deviations, but frames far from the spec need more repetitions to get through.
+  static constexpr uint32_t spec_tolerance_percent = 5;
+
+  static constexpr bool within_spec(uint32_t micros, uint32_t spec_micros) {
+    return micros * 100 <= spec_micros * (100 + spec_tolerance_percent) &&
+           micros * 100 >= spec_micros * (100 - spec_tolerance_percent);
+  }
+
+  static_assert(within_spec(Profile::wakeup_high_micros, RTSSpecTiming::wakeup_high_micros),
+                "wakeup mark is out of spec");
+  static_assert(within_spec(Profile::wakeup_low_micros, RTSSpecTiming::wakeup_low_micros),
+                "wakeup silence is out of spec");
+  static_assert(within_spec(Profile::symbol_micros, RTSSpecTiming::symbol_micros), "symbol is out of spec");
+  static_assert(within_spec(Profile::hardware_sync_high_micros, RTSSpecTiming::hardware_sync_high_micros),
+                "hardware sync mark is out of spec");
+  static_assert(within_spec(Profile::hardware_sync_low_micros, RTSSpecTiming::hardware_sync_low_micros),
+                "hardware sync space is out of spec");
+  static_assert(within_spec(Profile::software_sync_high_micros, RTSSpecTiming::software_sync_high_micros),
+                "software sync mark is out of spec");
+  static_assert(within_spec(Profile::software_sync_low_micros, RTSSpecTiming::software_sync_low_micros),
+                "software sync space is out of spec");
+  static_assert(within_spec(Profile::inter_frame_gap_micros, RTSSpecTiming::inter_frame_gap_micros),
+                "inter-frame gap is out of spec");
+
+  // Sync signals precede every frame: 7 hardware sync pulses normally, or 2 immediately after a
+  // wakeup signal or a previous frame.
+  static constexpr auto full_sync_preamble =
+      make_sync_preamble<7>(Profile::hardware_sync_high_micros, Profile::hardware_sync_low_micros,
+                            Profile::software_sync_high_micros, Profile::software_sync_low_micros);
+  static constexpr auto abbreviated_sync_preamble =
+      make_sync_preamble<2>(Profile::hardware_sync_high_micros, Profile::hardware_sync_low_micros,
+                            Profile::software_sync_high_micros, Profile::software_sync_low_micros);
+
+  static constexpr int32_t half_symbol_micros = Profile::symbol_micros / 2;
+
+  // Airtime of a frame with the given number of hardware sync pulses and payload bytes.
+  static constexpr uint32_t frame_airtime_micros(size_t num_hardware_syncs, size_t payload_bytes) {
+    return num_hardware_syncs * (Profile::hardware_sync_high_micros + Profile::hardware_sync_low_micros) +
+           Profile::software_sync_high_micros + Profile::software_sync_low_micros +
+           8 * payload_bytes * Profile::symbol_micros;
+  }
+
+  // Silences that the main loop waits out are rounded up to whole milliseconds, so that they never
+  // end before the spec allows.
+  static constexpr uint32_t loop_delay_millis(uint32_t micros) { return (micros + 999) / 1000; }
+
+  // Replaces the timings with one frame. Consecutive halves of the Manchester-encoded data at the
+  // same level get merged into one item, so that each edge of the waveform is compensated for the
+  // transmitter's mark overhead exactly once.
+  template<size_t payload_bytes>
+  static void encode_frame(const std::array<uint8_t, payload_bytes> &payload, bool abbreviated_sync,
+                           int32_t mark_overhead_micros, remote_base::RawTimings *timings) {
+    // Hardware sync: sent twice immediately after a wakeup signal or 7 times otherwise, followed by
+    // one last software sync signal.
+    if (abbreviated_sync) {
+      timings->assign(abbreviated_sync_preamble.begin(), abbreviated_sync_preamble.end());
+    } else {
+      timings->assign(full_sync_preamble.begin(), full_sync_preamble.end());
+    }
+
+    // Transmit the data with Manchester encoding: a 0 bit as a falling edge, a 1 bit as a rising
+    // edge.
+    for (auto byte_to_transmit : payload) {
+      for (int bit_index = 0; bit_index < 8; bit_index++) {
+        bool bit = (byte_to_transmit & 0x80) != 0;
+        append_merged_(timings, bit ? -half_symbol_micros : half_symbol_micros);
+        append_merged_(timings, bit ? half_symbol_micros : -half_symbol_micros);
+        byte_to_transmit <<= 1;
+      }
+    }
+
+    if (mark_overhead_micros != 0) {
+      for (int32_t &item : *timings) {
+        item = item > 0 ? static_cast<int32_t>(compensated_mark_micros(item, mark_overhead_micros))
+                        : -static_cast<int32_t>(compensated_space_micros(-item, mark_overhead_micros));
+      }
+    }
+  }
+
+ protected:
+  static void append_merged_(remote_base::RawTimings *timings, int32_t item) {
+    int32_t &last = timings->back();
+    if ((last > 0) == (item > 0)) {
+      last += item;
+    } else {
+      timings->push_back(item);
+    }
+  }
+};
+
+}  // namespace rts
+}  // namespace esphome
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace esphome {
+namespace rts {
+
+// Fixed-size ring buffer of the most recently transmitted frames, in a compact binary form that is
+// only decoded when the trace gets dumped. Storage is allocated once by init(). Exactly one context
+// records into a buffer, and any other context may read it; an entry that gets overwritten while it
+// is being read is skipped.
+class RTSTraceBuffer {
+ public:
+  enum FrameKind : uint8_t {
+    FRAME_FULL_SYNC,
+    FRAME_ABBREVIATED_SYNC,
+    FRAME_WAKEUP,
+  };
+
+  struct Entry {
+    uint32_t millis;
+    uint32_t channel_id : 24;
+    uint8_t control_code : 4;
+    FrameKind kind : 4;
+    uint16_t rolling_code;
+
+    // Index of the repetition within its command, starting at 0.
+    uint8_t repetition;
+    uint8_t num_repetitions;
+  } __attribute__((packed));
+
+  void init(size_t capacity) {
+    this->entries_.reset(capacity != 0 ? new Entry[capacity] : nullptr);
+    this->capacity_ = capacity;
+  }
+  size_t capacity() const { return this->capacity_; }
+
+  // Total number of entries recorded, including those that have been overwritten since.
+  uint32_t num_recorded() const { return this->num_recorded_.load(std::memory_order_acquire); }
+
+  // Called only by the recording context.
+  void record(const Entry &entry) {
+    if (this->capacity_ == 0) {
+      return;
+    }
+    uint32_t index = this->num_recorded_.load(std::memory_order_relaxed);
+    this->num_started_.store(index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    this->entries_[index % this->capacity_] = entry;
+    this->num_recorded_.store(index + 1, std::memory_order_release);
+  }
+
+  // Calls the function with every entry that is still in the buffer, oldest first.
+  template<typename F> void for_each(F &&function) const {
+    uint32_t end = this->num_recorded();
+    uint32_t begin = end > this->capacity_ ? end - this->capacity_ : 0;
+    for (uint32_t index = begin; index != end; index++) {
+      Entry entry = this->entries_[index % this->capacity_];
+
+      // The recording context may have started reusing the slot while the entry was copied.
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (this->num_started_.load(std::memory_order_relaxed) - index > this->capacity_) {
+        continue;
+      }
+      function(entry);
+    }
+  }
+
+ protected:
+  std::unique_ptr<Entry[]> entries_;
+  size_t capacity_{0};
+  std::atomic<uint32_t> num_recorded_{0};
+
+  // Ahead of num_recorded_ while an entry is being written.
+  std::atomic<uint32_t> num_started_{0};
+};
+
+}  // namespace rts
+}  // namespace esphome
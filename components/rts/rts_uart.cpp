@@ -0,0 +1,201 @@
+#include "rts_uart.h"
+
+#ifdef USE_RTS_UART
+
+#include <algorithm>
+
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/log.h"
+
+namespace esphome {
+namespace rts {
+
+static const char *const TAG = "rts.uart";
+
+void RTSUartInterface::setup() {
+  this->rts_parent_->add_on_command_done_callback(
+      [this](RTS::CommandHandle handle, uint32_t channel_id, RTS::RTSControlCode control_code,
+             RTS::CommandResult result) { this->on_command_done_(handle, result); });
+}
+
+void RTSUartInterface::loop() {
+  uint32_t now = millis();
+
+  // Bytes are read in chunks, so that a whole batch takes a few calls into the UART driver rather
+  // than one per byte.
+  uint8_t chunk[64];
+  int available;
+  bool has_received = false;
+  while ((available = this->available()) > 0) {
+    size_t size = std::min<size_t>(available, sizeof(chunk));
+    if (!this->read_array(chunk, size)) {
+      break;
+    }
+    this->last_byte_millis_ = now;
+    has_received = true;
+    for (size_t i = 0; i < size; i++) {
+      this->receive_byte_(chunk[i]);
+    }
+  }
+
+  // Only a frame that no bytes arrived for is timed out. Bytes that waited in the UART buffer while
+  // the main loop was busy, for example with a burst transmission, were sent in time.
+  if (!has_received && this->in_frame_ && now - this->last_byte_millis_ > frame_timeout_millis) {
+    ESP_LOGW(TAG, "Discarding incomplete frame");
+    this->in_frame_ = false;
+    this->send_error_(ERROR_TIMEOUT);
+  }
+}
+
+void RTSUartInterface::dump_config() {
+  ESP_LOGCONFIG(TAG, "RTS UART command interface:");
+  ESP_LOGCONFIG(TAG, "  Batches of up to %zu commands, tracking up to %zu pending commands", max_batch_commands,
+                this->max_pending_commands_);
+}
+
+void RTSUartInterface::receive_byte_(uint8_t byte) {
+  // Bytes outside of a frame are skipped until the next start byte.
+  if (!this->in_frame_) {
+    this->in_frame_ = byte == frame_start;
+    this->rx_size_ = 0;
+    return;
+  }
+
+  this->rx_buffer_[this->rx_size_++] = byte;
+  if (this->rx_size_ == 2 && this->rx_buffer_[1] > max_payload_size) {
+    this->in_frame_ = false;
+    this->send_error_(ERROR_LENGTH);
+    return;
+  }
+  if (this->rx_size_ < 2) {
+    return;
+  }
+  size_t payload_size = this->rx_buffer_[1];
+  if (this->rx_size_ < 2 + payload_size + 1) {
+    return;
+  }
+
+  this->in_frame_ = false;
+  if (crc8(this->rx_buffer_.data(), 2 + payload_size) != this->rx_buffer_[2 + payload_size]) {
+    ESP_LOGW(TAG, "Discarding frame with invalid checksum");
+    this->send_error_(ERROR_CHECKSUM);
+    return;
+  }
+  this->handle_frame_(this->rx_buffer_[0], this->rx_buffer_.data() + 2, payload_size);
+}
+
+void RTSUartInterface::handle_frame_(uint8_t type, const uint8_t *payload, size_t size) {
+  switch (type) {
+    case FRAME_COMMAND_BATCH:
+      this->handle_batch_(payload, size);
+      break;
+    case FRAME_STATUS_REQUEST: {
+      uint8_t status[] = {saturate_(this->rts_parent_->num_pending_commands()),
+                          saturate_(this->rts_parent_->queue_capacity()),
+                          saturate_(this->max_pending_commands_ - this->tracked_commands_.size())};
+      this->send_frame_(FRAME_STATUS, status, sizeof(status));
+      break;
+    }
+    default:
+      ESP_LOGW(TAG, "Discarding frame of unknown type 0x%02x", type);
+      this->send_error_(ERROR_UNKNOWN_TYPE);
+      break;
+  }
+}
+
+void RTSUartInterface::handle_batch_(const uint8_t *payload, size_t size) {
+  if (size < 1 + command_size || (size - 1) % command_size != 0) {
+    ESP_LOGW(TAG, "Discarding command batch of %zu bytes", size);
+    this->send_error_(ERROR_LENGTH);
+    return;
+  }
+
+  uint8_t sequence = payload[0];
+  size_t num_commands = (size - 1) / command_size;
+
+  // Commands that cannot be scheduled get their results reported right after the acknowledgement.
+  std::array<uint8_t, max_batch_commands> immediate_results;
+  uint8_t num_accepted = 0;
+  for (size_t i = 0; i < num_commands; i++) {
+    const uint8_t *command = payload + 1 + i * command_size;
+    uint32_t channel_id = command[0] | (command[1] << 8) | (command[2] << 16);
+    auto control_code = static_cast<RTS::RTSControlCode>(command[3]);
+    uint8_t max_repetitions = command[4];
+
+    auto index = this->rts_parent_->channel_registry().find_channel(channel_id);
+    if (!index.has_value()) {
+      immediate_results[i] = COMMAND_UNKNOWN_CHANNEL;
+      continue;
+    }
+    if (control_code != RTS::STOP && control_code != RTS::OPEN && control_code != RTS::CLOSE &&
+        control_code != RTS::PROGRAM) {
+      immediate_results[i] = COMMAND_INVALID_CONTROL_CODE;
+      continue;
+    }
+    if (this->tracked_commands_.size() >= this->max_pending_commands_) {
+      immediate_results[i] = RTS::COMMAND_REJECTED;
+      continue;
+    }
+
+    this->channel_.attach(*index);
+    RTS::CommandHandle handle = this->rts_parent_->schedule_rts_command(
+        control_code, &this->channel_, max_repetitions != 0 ? max_repetitions : 16);
+    if (handle == 0) {
+      immediate_results[i] = RTS::COMMAND_REJECTED;
+      continue;
+    }
+    this->tracked_commands_.push_back({handle, sequence, static_cast<uint8_t>(i)});
+    immediate_results[i] = UINT8_MAX;
+    num_accepted++;
+  }
+
+  uint8_t ack[] = {sequence, num_accepted, saturate_(this->rts_parent_->num_pending_commands()),
+                   saturate_(this->rts_parent_->queue_capacity())};
+  this->send_frame_(FRAME_BATCH_ACK, ack, sizeof(ack));
+
+  for (size_t i = 0; i < num_commands; i++) {
+    if (immediate_results[i] != UINT8_MAX) {
+      this->send_command_done_(sequence, i, immediate_results[i]);
+    }
+  }
+}
+
+void RTSUartInterface::on_command_done_(RTS::CommandHandle handle, RTS::CommandResult result) {
+  for (size_t i = 0; i < this->tracked_commands_.size(); i++) {
+    TrackedCommand tracked = this->tracked_commands_[i];
+    if (tracked.handle != handle) {
+      continue;
+    }
+
+    this->tracked_commands_[i] = this->tracked_commands_.back();
+    this->tracked_commands_.pop_back();
+    this->send_command_done_(tracked.sequence, tracked.index, result);
+    return;
+  }
+}
+
+void RTSUartInterface::send_frame_(FrameType type, const uint8_t *payload, size_t size) {
+  uint8_t frame[3 + max_reply_size + 1];
+  frame[0] = frame_start;
+  frame[1] = type;
+  frame[2] = size;
+  std::copy(payload, payload + size, frame + 3);
+  frame[3 + size] = crc8(frame + 1, 2 + size);
+  this->write_array(frame, 3 + size + 1);
+}
+
+void RTSUartInterface::send_command_done_(uint8_t sequence, uint8_t index, uint8_t result) {
+  uint8_t done[] = {sequence, index, result, saturate_(this->rts_parent_->num_pending_commands())};
+  this->send_frame_(FRAME_COMMAND_DONE, done, sizeof(done));
+}
+
+void RTSUartInterface::send_error_(FrameError error) {
+  uint8_t payload[] = {error};
+  this->send_frame_(FRAME_ERROR, payload, sizeof(payload));
+}
+
+}  // namespace rts
+}  // namespace esphome
+
+#endif  // USE_RTS_UART
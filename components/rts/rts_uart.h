@@ -0,0 +1,123 @@
+#pragma once
+
+#include "esphome/core/defines.h"
+
+#ifdef USE_RTS_UART
+
+#include <array>
+#include <vector>
+
+#include "esphome/components/uart/uart.h"
+#include "esphome/core/component.h"
+#include "rts.h"
+#include "rts_channel.h"
+
+namespace esphome {
+namespace rts {
+
+// Binary command interface for external controllers, which feeds batches of commands straight into
+// the RTS transmission queues without going through covers.
+//
+// Frames in both directions are the start byte, a frame type, the payload length, the payload, and
+// the CRC-8 of the type, length and payload. Multi-byte values are little endian.
+class RTSUartInterface : public Component, public uart::UARTDevice {
+ public:
+  static constexpr uint8_t frame_start = 0xa5;
+
+  enum FrameType : uint8_t {
+    // From the controller: a sequence number, then for each command the channel id (3 bytes), the
+    // control code, and the maximum number of repetitions, or 0 for command_repetitions.
+    FRAME_COMMAND_BATCH = 0x01,
+    // From the controller, without payload.
+    FRAME_STATUS_REQUEST = 0x02,
+    // Acknowledges a batch: its sequence number, the number of commands that were scheduled, the
+    // number of pending commands and the queue capacity of each transmitter.
+    FRAME_BATCH_ACK = 0x81,
+    // Reports the result of one command: the batch's sequence number, the command's index in the
+    // batch, an RTS::CommandResult or one of the CommandError values, and the number of pending
+    // commands.
+    FRAME_COMMAND_DONE = 0x82,
+    // Answers a status request: the number of pending commands, the queue capacity of each
+    // transmitter, and the number of further commands whose results can be tracked.
+    FRAME_STATUS = 0x83,
+    // Reports a frame that was discarded, with one of the FrameError values.
+    FRAME_ERROR = 0x8f,
+  };
+
+  // Results of commands that were not scheduled because they are invalid.
+  enum CommandError : uint8_t {
+    COMMAND_UNKNOWN_CHANNEL = 0x80,
+    COMMAND_INVALID_CONTROL_CODE = 0x81,
+  };
+
+  enum FrameError : uint8_t {
+    ERROR_CHECKSUM = 0x01,
+    ERROR_LENGTH = 0x02,
+    ERROR_UNKNOWN_TYPE = 0x03,
+    ERROR_TIMEOUT = 0x04,
+  };
+
+  // Each command of a batch is a channel id, control code and maximum number of repetitions.
+  static constexpr size_t command_size = 5;
+  static constexpr size_t max_batch_commands = 50;
+  static constexpr size_t max_payload_size = 1 + max_batch_commands * command_size;
+  static constexpr size_t max_reply_size = 4;
+
+  // A frame whose remaining bytes do not arrive within this time is discarded.
+  static constexpr uint32_t frame_timeout_millis = 100;
+
+  void setup() override;
+  void loop() override;
+  void dump_config() override;
+
+  void set_rts_parent(RTS *rts_parent) {
+    this->rts_parent_ = rts_parent;
+    this->channel_.set_registry(&rts_parent->channel_registry());
+  }
+
+  // Number of commands whose results get reported at the same time. Commands beyond it are
+  // rejected right away.
+  void set_max_pending_commands(size_t max_pending_commands) {
+    this->max_pending_commands_ = max_pending_commands;
+    this->tracked_commands_.reserve(max_pending_commands);
+  }
+
+ protected:
+  // A scheduled command whose result has not been reported to the controller yet.
+  struct TrackedCommand {
+    RTS::CommandHandle handle;
+    uint8_t sequence;
+    uint8_t index;
+  };
+
+  void receive_byte_(uint8_t byte);
+  void handle_frame_(uint8_t type, const uint8_t *payload, size_t size);
+  void handle_batch_(const uint8_t *payload, size_t size);
+  void on_command_done_(RTS::CommandHandle handle, RTS::CommandResult result);
+
+  void send_frame_(FrameType type, const uint8_t *payload, size_t size);
+  void send_command_done_(uint8_t sequence, uint8_t index, uint8_t result);
+  void send_error_(FrameError error);
+
+  // Counts are reported in one byte each, and saturate.
+  static uint8_t saturate_(size_t count) { return count < UINT8_MAX ? count : UINT8_MAX; }
+
+  RTS *rts_parent_;
+
+  // Handle that gets attached to each command's channel in turn.
+  RTSChannel channel_;
+
+  size_t max_pending_commands_{64};
+  std::vector<TrackedCommand> tracked_commands_;
+
+  // Bytes of the frame being received after its start byte.
+  std::array<uint8_t, 2 + max_payload_size + 1> rx_buffer_{};
+  size_t rx_size_{0};
+  bool in_frame_{false};
+  uint32_t last_byte_millis_{0};
+};
+
+}  // namespace rts
+}  // namespace esphome
+
+#endif  // USE_RTS_UART
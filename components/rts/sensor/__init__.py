@@ -1,40 +1,155 @@
 import esphome.codegen as cg
 import esphome.config_validation as cv
 from esphome.components import sensor
-from esphome.const import CONF_ID
+from esphome.const import (
+    CONF_ID,
+    DEVICE_CLASS_DURATION,
+    STATE_CLASS_MEASUREMENT,
+    STATE_CLASS_TOTAL_INCREASING,
+    UNIT_MILLISECOND,
+)
 
-from .. import rts_ns
+from .. import RTS, rts_ns
 from .. import cover as rtscover
 
 DEPENDENCIES = ["rts"]
 
 CONF_CHANNEL_ID = "channel_id"
 CONF_ROLLING_CODE = "rolling_code"
+CONF_FLASH_WRITES_AVOIDED = "flash_writes_avoided"
 CONF_RTS_COVER_ID = "rts_cover_id"
+CONF_RTS_ID = "rts_id"
+CONF_COALESCED_COMMANDS = "coalesced_commands"
+CONF_URGENT_LATENCY = "urgent_latency"
+CONF_QUEUE_OVERFLOWS = "queue_overflows"
+CONF_COMMAND_LATENCY_P50 = "command_latency_p50"
+CONF_COMMAND_LATENCY_P99 = "command_latency_p99"
+CONF_COMMAND_AIRTIME = "command_airtime"
+CONF_QUEUE_DEPTH = "queue_depth"
+CONF_WAKEUPS_SENT = "wakeups_sent"
+CONF_WAKEUPS_SKIPPED = "wakeups_skipped"
+CONF_CANCELLED_COMMANDS = "cancelled_commands"
+CONF_PUBLISH_INTERVAL = "publish_interval"
+CONF_PREWAKE_LATENCY_SAVED = "prewake_latency_saved"
 
 ICON_REMOTE_TV = "mdi:remote-tv"
 ICON_PAPER_ROLL = "mdi:paper-roll"
+ICON_CHIP = "mdi:chip"
+ICON_CALL_MERGE = "mdi:call-merge"
+ICON_TIMER_ALERT = "mdi:timer-alert-outline"
+ICON_TRAY_FULL = "mdi:tray-full"
+ICON_TIMER_SAND = "mdi:timer-sand"
+ICON_RADIO_TOWER = "mdi:radio-tower"
+ICON_TRAY = "mdi:tray"
+ICON_ALARM = "mdi:alarm"
+ICON_ALARM_SNOOZE = "mdi:alarm-snooze"
+ICON_CANCEL = "mdi:cancel"
+ICON_TIMER_CHECK = "mdi:timer-check-outline"
 
 RTSChannelSensor = rts_ns.class_("RTSChannelSensor", cg.Component)
+RTSSensor = rts_ns.class_("RTSSensor", cg.PollingComponent)
 
-CONFIG_SCHEMA = cv.All(
+CHANNEL_SENSOR_SCHEMA = cv.All(
     cv.Schema(
         {
             cv.GenerateID(): cv.declare_id(RTSChannelSensor),
             cv.Required(CONF_RTS_COVER_ID): cv.use_id(rtscover.RTSCover),
             cv.Optional(CONF_CHANNEL_ID): sensor.sensor_schema(icon=ICON_REMOTE_TV),
             cv.Optional(CONF_ROLLING_CODE): sensor.sensor_schema(icon=ICON_PAPER_ROLL),
+            cv.Optional(CONF_FLASH_WRITES_AVOIDED): sensor.sensor_schema(icon=ICON_CHIP),
+            cv.Optional(CONF_PUBLISH_INTERVAL, default="5s"): cv.positive_time_period_milliseconds,
         }
     ).extend(cv.COMPONENT_SCHEMA),
-    cv.has_at_least_one_key(CONF_CHANNEL_ID, CONF_ROLLING_CODE),
+    cv.has_at_least_one_key(CONF_CHANNEL_ID, CONF_ROLLING_CODE, CONF_FLASH_WRITES_AVOIDED),
+)
+
+def _duration_sensor_schema(icon):
+    return sensor.sensor_schema(
+        unit_of_measurement=UNIT_MILLISECOND,
+        icon=icon,
+        accuracy_decimals=0,
+        device_class=DEVICE_CLASS_DURATION,
+        state_class=STATE_CLASS_MEASUREMENT,
+    )
+
+# Statistics for the RTS component itself, rather than for one cover's channel.
+RTS_SENSOR_KEYS = [
+    CONF_COALESCED_COMMANDS,
+    CONF_URGENT_LATENCY,
+    CONF_QUEUE_OVERFLOWS,
+    CONF_COMMAND_LATENCY_P50,
+    CONF_COMMAND_LATENCY_P99,
+    CONF_COMMAND_AIRTIME,
+    CONF_QUEUE_DEPTH,
+    CONF_WAKEUPS_SENT,
+    CONF_WAKEUPS_SKIPPED,
+    CONF_CANCELLED_COMMANDS,
+    CONF_PREWAKE_LATENCY_SAVED,
+]
+
+RTS_SENSOR_SCHEMA = cv.All(
+    cv.Schema(
+        {
+            cv.GenerateID(): cv.declare_id(RTSSensor),
+            cv.GenerateID(CONF_RTS_ID): cv.use_id(RTS),
+            cv.Optional(CONF_COALESCED_COMMANDS): sensor.sensor_schema(
+                icon=ICON_CALL_MERGE, accuracy_decimals=0, state_class=STATE_CLASS_TOTAL_INCREASING
+            ),
+            cv.Optional(CONF_URGENT_LATENCY): sensor.sensor_schema(
+                unit_of_measurement=UNIT_MILLISECOND,
+                icon=ICON_TIMER_ALERT,
+                accuracy_decimals=0,
+                device_class=DEVICE_CLASS_DURATION,
+                state_class=STATE_CLASS_MEASUREMENT,
+            ),
+            cv.Optional(CONF_QUEUE_OVERFLOWS): sensor.sensor_schema(
+                icon=ICON_TRAY_FULL, accuracy_decimals=0, state_class=STATE_CLASS_TOTAL_INCREASING
+            ),
+            cv.Optional(CONF_COMMAND_LATENCY_P50): _duration_sensor_schema(ICON_TIMER_SAND),
+            cv.Optional(CONF_COMMAND_LATENCY_P99): _duration_sensor_schema(ICON_TIMER_SAND),
+            cv.Optional(CONF_COMMAND_AIRTIME): _duration_sensor_schema(ICON_RADIO_TOWER),
+            cv.Optional(CONF_QUEUE_DEPTH): sensor.sensor_schema(
+                icon=ICON_TRAY, accuracy_decimals=0, state_class=STATE_CLASS_MEASUREMENT
+            ),
+            cv.Optional(CONF_WAKEUPS_SENT): sensor.sensor_schema(
+                icon=ICON_ALARM, accuracy_decimals=0, state_class=STATE_CLASS_TOTAL_INCREASING
+            ),
+            cv.Optional(CONF_WAKEUPS_SKIPPED): sensor.sensor_schema(
+                icon=ICON_ALARM_SNOOZE, accuracy_decimals=0, state_class=STATE_CLASS_TOTAL_INCREASING
+            ),
+            cv.Optional(CONF_CANCELLED_COMMANDS): sensor.sensor_schema(
+                icon=ICON_CANCEL, accuracy_decimals=0, state_class=STATE_CLASS_TOTAL_INCREASING
+            ),
+            cv.Optional(CONF_PREWAKE_LATENCY_SAVED): sensor.sensor_schema(
+                unit_of_measurement=UNIT_MILLISECOND,
+                icon=ICON_TIMER_CHECK,
+                accuracy_decimals=0,
+                device_class=DEVICE_CLASS_DURATION,
+                state_class=STATE_CLASS_TOTAL_INCREASING,
+            ),
+        }
+    ).extend(cv.polling_component_schema("60s")),
+    cv.has_at_least_one_key(*RTS_SENSOR_KEYS),
 )
 
+def _validate_sensor(config):
+    if CONF_RTS_COVER_ID in config:
+        return CHANNEL_SENSOR_SCHEMA(config)
+    return RTS_SENSOR_SCHEMA(config)
+
+CONFIG_SCHEMA = _validate_sensor
+
 async def to_code(config):
+    if CONF_RTS_COVER_ID not in config:
+        await rts_sensor_to_code(config)
+        return
+
     var = cg.new_Pvariable(config[CONF_ID])
     await cg.register_component(var, config)
 
     paren = await cg.get_variable(config[CONF_RTS_COVER_ID])
     cg.add(var.set_rts_cover(paren))
+    cg.add(var.set_publish_interval(config[CONF_PUBLISH_INTERVAL].total_milliseconds))
 
     if CONF_CHANNEL_ID in config:
         sens = await sensor.new_sensor(config[CONF_CHANNEL_ID])
@@ -42,3 +157,18 @@ async def to_code(config):
     if CONF_ROLLING_CODE in config:
         sens = await sensor.new_sensor(config[CONF_ROLLING_CODE])
         cg.add(var.set_rolling_code_sensor(sens))
+    if CONF_FLASH_WRITES_AVOIDED in config:
+        sens = await sensor.new_sensor(config[CONF_FLASH_WRITES_AVOIDED])
+        cg.add(var.set_flash_writes_avoided_sensor(sens))
+
+async def rts_sensor_to_code(config):
+    var = cg.new_Pvariable(config[CONF_ID])
+    await cg.register_component(var, config)
+
+    paren = await cg.get_variable(config[CONF_RTS_ID])
+    cg.add(var.set_rts_parent(paren))
+
+    for key in RTS_SENSOR_KEYS:
+        if key in config:
+            sens = await sensor.new_sensor(config[key])
+            cg.add(getattr(var, f"set_{key}_sensor")(sens))
@@ -1,4 +1,5 @@
 #include "rts_channel_sensor.h"
+#include "esphome/core/hal.h"
 #include "esphome/core/log.h"
 
 namespace esphome {
@@ -9,20 +10,63 @@ static const char *const TAG = "rts.sensor";
 void RTSChannelSensor::setup() {
   ESP_LOGCONFIG(TAG, "Setting up RTS channel sensor for cover '%s'...", this->rts_cover_->get_name().c_str());
 
-  this->rts_cover_->rts_channel().add_on_channel_update_callback([this](uint32_t channel_id, uint16_t rolling_code) {
-    if (this->channel_id_sensor_ != nullptr) {
-      this->channel_id_sensor_->publish_state(channel_id);
-    }
-    if (this->rolling_code_sensor_ != nullptr) {
-      this->rolling_code_sensor_->publish_state(rolling_code);
-    }
-  });
+  this->rts_cover_->rts_channel().add_on_channel_update_callback(
+      [this](uint32_t channel_id, uint16_t rolling_code, bool configured) {
+        this->on_channel_update_(channel_id, rolling_code, configured);
+      });
 }
 
 void RTSChannelSensor::dump_config() {
   ESP_LOGCONFIG(TAG, "RTS Channel Sensor");
+  ESP_LOGCONFIG(TAG, "  Publish interval: %ums", this->publish_interval_millis_);
   LOG_SENSOR("  ", "Channel id sensor", this->channel_id_sensor_);
   LOG_SENSOR("  ", "Rolling code sensor", this->rolling_code_sensor_);
+  LOG_SENSOR("  ", "Flash writes avoided sensor", this->flash_writes_avoided_sensor_);
+}
+
+void RTSChannelSensor::on_shutdown() {
+  // The backup in Home Assistant must not miss the last rolling code values that were used.
+  if (this->has_pending_) {
+    this->publish_pending_();
+  }
+}
+
+void RTSChannelSensor::on_channel_update_(uint32_t channel_id, uint16_t rolling_code, bool configured) {
+  this->pending_channel_id_ = channel_id;
+  this->pending_rolling_code_ = rolling_code;
+  this->has_pending_ = true;
+
+  uint32_t since_publish_millis = millis() - this->last_publish_millis_;
+  if (configured || !this->has_published_ || since_publish_millis >= this->publish_interval_millis_) {
+    // The first update after a quiet period goes out right away, so that an isolated command is
+    // backed up without delay.
+    this->publish_pending_();
+  } else if (!this->is_publish_scheduled_) {
+    this->is_publish_scheduled_ = true;
+    this->set_timeout("publish", this->publish_interval_millis_ - since_publish_millis,
+                      [this]() { this->publish_pending_(); });
+  }
+}
+
+void RTSChannelSensor::publish_pending_() {
+  if (this->is_publish_scheduled_) {
+    this->cancel_timeout("publish");
+    this->is_publish_scheduled_ = false;
+  }
+  this->has_pending_ = false;
+  this->has_published_ = true;
+  this->last_publish_millis_ = millis();
+
+  publish_if_changed_(this->channel_id_sensor_, this->pending_channel_id_);
+  publish_if_changed_(this->rolling_code_sensor_, this->pending_rolling_code_);
+  publish_if_changed_(this->flash_writes_avoided_sensor_, this->rts_cover_->rts_channel().flash_writes_avoided());
+}
+
+void RTSChannelSensor::publish_if_changed_(sensor::Sensor *sensor, float value) {
+  // The raw state is what was last published, before any filters.
+  if (sensor != nullptr && (!sensor->has_state() || sensor->raw_state != value)) {
+    sensor->publish_state(value);
+  }
 }
 
 }  // namespace rts
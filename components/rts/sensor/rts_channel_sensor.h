@@ -12,15 +12,36 @@ namespace rts {
 class RTSChannelSensor : public Component {
   SUB_SENSOR(channel_id)
   SUB_SENSOR(rolling_code)
+  SUB_SENSOR(flash_writes_avoided)
 
  public:
   void setup() override final;
   void dump_config() override final;
+  void on_shutdown() override final;
 
   void set_rts_cover(RTSCover *rts_cover) { this->rts_cover_ = rts_cover; }
 
+  // Channel updates that follow each other within publish_interval_millis are published together at
+  // the end of the interval. Updates from config changes are published right away.
+  void set_publish_interval(uint32_t publish_interval_millis) {
+    this->publish_interval_millis_ = publish_interval_millis;
+  }
+
  protected:
+  void on_channel_update_(uint32_t channel_id, uint16_t rolling_code, bool configured);
+
+  // Publishes the latest channel state, skipping sensors whose value did not change.
+  void publish_pending_();
+  static void publish_if_changed_(sensor::Sensor *sensor, float value);
+
   RTSCover *rts_cover_;
+  uint32_t publish_interval_millis_{5000};
+  uint32_t last_publish_millis_{0};
+  bool has_published_{false};
+  bool has_pending_{false};
+  bool is_publish_scheduled_{false};
+  uint32_t pending_channel_id_{0};
+  uint16_t pending_rolling_code_{0};
 };
 
 }  // namespace rts
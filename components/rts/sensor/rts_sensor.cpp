@@ -0,0 +1,62 @@
+#include "rts_sensor.h"
+#include "esphome/core/log.h"
+
+namespace esphome {
+namespace rts {
+
+static const char *const TAG = "rts.sensor";
+
+void RTSSensor::update() {
+  if (this->coalesced_commands_sensor_ != nullptr) {
+    this->coalesced_commands_sensor_->publish_state(this->rts_parent_->coalesced_command_count());
+  }
+  if (this->urgent_latency_sensor_ != nullptr) {
+    this->urgent_latency_sensor_->publish_state(this->rts_parent_->last_urgent_latency_millis());
+  }
+  if (this->queue_overflows_sensor_ != nullptr) {
+    this->queue_overflows_sensor_->publish_state(this->rts_parent_->queue_overflow_count());
+  }
+  if (this->command_latency_p50_sensor_ != nullptr) {
+    this->command_latency_p50_sensor_->publish_state(this->rts_parent_->command_latency_millis(50));
+  }
+  if (this->command_latency_p99_sensor_ != nullptr) {
+    this->command_latency_p99_sensor_->publish_state(this->rts_parent_->command_latency_millis(99));
+  }
+  if (this->command_airtime_sensor_ != nullptr) {
+    this->command_airtime_sensor_->publish_state(this->rts_parent_->command_airtime_micros() / 1000.0f);
+  }
+  if (this->queue_depth_sensor_ != nullptr) {
+    this->queue_depth_sensor_->publish_state(this->rts_parent_->peak_queue_depth());
+  }
+  if (this->wakeups_sent_sensor_ != nullptr) {
+    this->wakeups_sent_sensor_->publish_state(this->rts_parent_->wakeups_sent());
+  }
+  if (this->wakeups_skipped_sensor_ != nullptr) {
+    this->wakeups_skipped_sensor_->publish_state(this->rts_parent_->wakeups_skipped());
+  }
+  if (this->cancelled_commands_sensor_ != nullptr) {
+    this->cancelled_commands_sensor_->publish_state(this->rts_parent_->cancelled_command_count());
+  }
+  if (this->prewake_latency_saved_sensor_ != nullptr) {
+    this->prewake_latency_saved_sensor_->publish_state(this->rts_parent_->prewake_latency_saved_millis());
+  }
+}
+
+void RTSSensor::dump_config() {
+  ESP_LOGCONFIG(TAG, "RTS Sensor");
+  LOG_UPDATE_INTERVAL(this);
+  LOG_SENSOR("  ", "Coalesced commands sensor", this->coalesced_commands_sensor_);
+  LOG_SENSOR("  ", "Urgent command latency sensor", this->urgent_latency_sensor_);
+  LOG_SENSOR("  ", "Queue overflows sensor", this->queue_overflows_sensor_);
+  LOG_SENSOR("  ", "Command latency p50 sensor", this->command_latency_p50_sensor_);
+  LOG_SENSOR("  ", "Command latency p99 sensor", this->command_latency_p99_sensor_);
+  LOG_SENSOR("  ", "Command airtime sensor", this->command_airtime_sensor_);
+  LOG_SENSOR("  ", "Queue depth sensor", this->queue_depth_sensor_);
+  LOG_SENSOR("  ", "Wakeups sent sensor", this->wakeups_sent_sensor_);
+  LOG_SENSOR("  ", "Wakeups skipped sensor", this->wakeups_skipped_sensor_);
+  LOG_SENSOR("  ", "Cancelled commands sensor", this->cancelled_commands_sensor_);
+  LOG_SENSOR("  ", "Prewake latency saved sensor", this->prewake_latency_saved_sensor_);
+}
+
+}  // namespace rts
+}  // namespace esphome
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "esphome/components/sensor/sensor.h"
+#include "esphome/core/component.h"
+#include "esphome/core/helpers.h"
+#include "../rts.h"
+
+namespace esphome {
+namespace rts {
+
+// Periodically publishes statistics about the RTS transmission queue.
+class RTSSensor : public PollingComponent {
+  SUB_SENSOR(coalesced_commands)
+  SUB_SENSOR(urgent_latency)
+  SUB_SENSOR(queue_overflows)
+  SUB_SENSOR(command_latency_p50)
+  SUB_SENSOR(command_latency_p99)
+  SUB_SENSOR(command_airtime)
+  SUB_SENSOR(queue_depth)
+  SUB_SENSOR(wakeups_sent)
+  SUB_SENSOR(wakeups_skipped)
+  SUB_SENSOR(cancelled_commands)
+  SUB_SENSOR(prewake_latency_saved)
+
+ public:
+  void update() override;
+  void dump_config() override final;
+
+  void set_rts_parent(RTS *rts_parent) { this->rts_parent_ = rts_parent; }
+
+ protected:
+  RTS *rts_parent_;
+};
+
+}  // namespace rts
+}  // namespace esphome
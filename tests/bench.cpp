@@ -0,0 +1,284 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iterator>
+
+#include "rts_fixtures.h"
+#include "rts_test_util.h"
+#include "rts_uart.h"
+#include "uart_pty.h"
+
+using namespace rts_test;
+using esphome::rts::RTSUartInterface;
+
+// Scheduler scenarios run on the virtual clock, so their latencies, airtime and drain times are
+// exact and the same on every run. The other benchmarks measure the host CPU time of code that
+// runs on the device, which is only comparable between runs on the same machine.
+namespace {
+
+bool quick = false;
+
+class Stopwatch {
+ public:
+  Stopwatch() : start_(std::chrono::steady_clock::now()) {}
+  double elapsed_nanos() const {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - this->start_).count();
+  }
+
+ protected:
+  std::chrono::steady_clock::time_point start_;
+};
+
+uint32_t percentile(std::vector<uint32_t> values, uint8_t percent) {
+  if (values.empty()) {
+    return 0;
+  }
+  std::sort(values.begin(), values.end());
+  return values[(values.size() - 1) * percent / 100];
+}
+
+// Reports how long each channel waited from scheduling until its first frame started, the total
+// airtime, and the time until the last frame ended.
+void report_scenario(const char *name, Installation &installation, const std::function<void()> &schedule) {
+  uint64_t start_micros = esphome::host::now_micros();
+  Stopwatch stopwatch;
+  schedule();
+  esphome::host::run_until_idle();
+  double cpu_millis = stopwatch.elapsed_nanos() / 1e6;
+
+  std::vector<uint32_t> latencies;
+  std::vector<bool> seen(installation.channels.size(), false);
+  for (const auto &frame : installation.frames()) {
+    size_t index = frame.channel_id - Installation::first_channel_id;
+    if (index < seen.size() && !seen[index]) {
+      seen[index] = true;
+      latencies.push_back((frame.start_micros - start_micros) / 1000);
+    }
+  }
+
+  // Silences inside a transmission count as airtime, since they keep the transmitter busy.
+  uint64_t airtime = 0;
+  uint64_t end_micros = start_micros;
+  for (const auto &transmission : installation.transmitter.transmissions()) {
+    uint32_t transmission_airtime = airtime_micros(transmission.timings);
+    airtime += transmission_airtime;
+    end_micros = std::max(end_micros, transmission.start_micros + transmission_airtime);
+  }
+
+  std::printf("%-44s %4zu %7u %7u %7u %9.1f %9.1f %3zu %8.2f\n", name, latencies.size(), percentile(latencies, 50),
+              percentile(latencies, 95), percentile(latencies, 100), airtime / 1000.0,
+              (end_micros - start_micros) / 1000.0, installation.wakeups(), cpu_millis);
+}
+
+void close_covers_one_by_one(Installation &installation, size_t num_covers) {
+  for (size_t i = 0; i < num_covers; i++) {
+    installation.rts.schedule_rts_command(RTS::CLOSE, installation.channel(i));
+  }
+}
+
+void run_scheduler_scenarios() {
+  std::printf("\nScheduler scenarios (virtual time; latencies in ms from scheduling to the first frame)\n");
+  std::printf("%-44s %4s %7s %7s %7s %9s %9s %3s %8s\n", "scenario", "cmds", "p50", "p95", "max", "airtime", "drain",
+              "wk", "cpu ms");
+
+  {
+    esphome::host::reset();
+    Installation installation(1);
+    report_scenario("1 cover", installation, [&]() { close_covers_one_by_one(installation, 1); });
+  }
+  {
+    esphome::host::reset();
+    Installation installation(30, 32);
+    std::vector<RTSChannel *> channels;
+    for (size_t i = 0; i < 30; i++) {
+      channels.push_back(installation.channel(i));
+    }
+    report_scenario("30 covers closed by one scene (group)", installation,
+                    [&]() { installation.rts.schedule_group_command(RTS::CLOSE, channels); });
+  }
+  {
+    esphome::host::reset();
+    Installation installation(30, 32);
+    report_scenario("30 covers closed one by one", installation,
+                    [&]() { close_covers_one_by_one(installation, 30); });
+  }
+  {
+    esphome::host::reset();
+    Installation installation(40, 40);
+    report_scenario("40 covers closed one by one", installation,
+                    [&]() { close_covers_one_by_one(installation, 40); });
+  }
+  {
+    esphome::host::reset();
+    Installation installation(40, 40);
+    installation.rts.set_min_command_repetitions(1);
+    installation.rts.set_max_command_repetitions(4);
+    report_scenario("40 covers, adaptive repetitions 1-4", installation,
+                    [&]() { close_covers_one_by_one(installation, 40); });
+  }
+  {
+    esphome::host::reset();
+    Installation installation(40, 40);
+    installation.rts.set_burst_transmit(true);
+    report_scenario("40 covers, burst transmit", installation, [&]() { close_covers_one_by_one(installation, 40); });
+  }
+  {
+    // A STOP for a cover whose OPEN is going out, while 9 more OPENs wait behind it.
+    esphome::host::reset();
+    Installation installation(10);
+    installation.use_fixed_repetitions(8);
+    for (size_t i = 0; i < 10; i++) {
+      installation.rts.schedule_rts_command(RTS::OPEN, installation.channel(i));
+    }
+    esphome::host::run_for(600);
+    uint64_t stop_micros = esphome::host::now_micros();
+    installation.rts.schedule_rts_command(RTS::STOP, installation.channel(0));
+    esphome::host::run_until_idle();
+    uint64_t stop_start = 0;
+    for (const auto &frame : installation.frames()) {
+      if (frame.control_code == RTS::STOP) {
+        stop_start = frame.start_micros;
+        break;
+      }
+    }
+    std::printf("%-44s %4d %7.1f\n", "STOP during a burst of 10 OPENs", 1, (stop_start - stop_micros) / 1000.0);
+  }
+}
+
+// Compares replaying a frame that was encoded once with building the packet and its timings again
+// for every repetition, as transmit_command did before frames were cached, and with encoding it
+// from the timing tables.
+void run_encoding_benchmark() {
+  const int num_frames = quick ? 2000 : 200000;
+  RemoteTransmitterComponent transmitter;
+  uint64_t checksum = 0;
+
+  Stopwatch encode_stopwatch;
+  for (int i = 0; i < num_frames; i++) {
+    auto call = transmitter.transmit();
+    auto *data = call.get_data();
+    data->reserve(130);
+    for (int j = 0; j < 2; j++) {
+      data->item(spec::hardware_sync_high_micros, spec::hardware_sync_low_micros);
+    }
+    data->item(spec::software_sync_high_micros, spec::software_sync_low_micros);
+    for (uint8_t byte : reference_payload(RTS::CLOSE, 0x123456, 4242)) {
+      for (int bit = 0; bit < 8; bit++) {
+        if ((byte & 0x80) == 0) {
+          data->mark(spec::half_symbol_micros);
+          data->space(spec::half_symbol_micros);
+        } else {
+          data->space(spec::half_symbol_micros);
+          data->mark(spec::half_symbol_micros);
+        }
+        byte <<= 1;
+      }
+    }
+    checksum += data->get_data().size();
+  }
+  double encode_nanos = encode_stopwatch.elapsed_nanos() / num_frames;
+
+  // The same frame built from the precomputed sync preambles of the timing tables.
+  auto payload = reference_payload(RTS::CLOSE, 0x123456, 4242);
+  Stopwatch tables_stopwatch;
+  for (int i = 0; i < num_frames; i++) {
+    auto call = transmitter.transmit();
+    RawTimings timings;
+    timings.reserve(130);
+    TestRTS::Timing::encode_frame(payload, true, 0, &timings);
+    call.get_data()->set_data(timings);
+    checksum += call.get_data()->get_data().size();
+  }
+  double tables_nanos = tables_stopwatch.elapsed_nanos() / num_frames;
+
+  TestRTS rts;
+  rts.encode_frame(reference_payload(RTS::CLOSE, 0x123456, 4242), true);
+  Stopwatch replay_stopwatch;
+  for (int i = 0; i < num_frames; i++) {
+    auto call = transmitter.transmit();
+    call.get_data()->set_data(rts.frame_timings());
+    checksum += call.get_data()->get_data().size();
+  }
+  double replay_nanos = replay_stopwatch.elapsed_nanos() / num_frames;
+
+  std::printf("\nFrame encoding (%d frames, %zu timings each)\n", num_frames, rts.frame_timings().size());
+  std::printf("  encode every repetition: %8.1f ns/frame\n", encode_nanos);
+  std::printf("  encode from tables:      %8.1f ns/frame (%.1fx)\n", tables_nanos, encode_nanos / tables_nanos);
+  std::printf("  replay cached frame:     %8.1f ns/frame (%.1fx)\n", replay_nanos, encode_nanos / replay_nanos);
+  if (checksum == 0) {
+    std::printf("unexpected empty frames\n");
+  }
+}
+
+void run_decoding_benchmark() {
+  const int num_rounds = quick ? 200 : 50000;
+  RawTimings buffers[] = {
+      RawTimings(std::begin(fixtures::OPEN_FULL_SYNC), std::end(fixtures::OPEN_FULL_SYNC)),
+      RawTimings(std::begin(fixtures::STOP_REPEATED), std::end(fixtures::STOP_REPEATED)),
+      RawTimings(std::begin(fixtures::CLOSE_THEN_PROGRAM), std::end(fixtures::CLOSE_THEN_PROGRAM)),
+  };
+  size_t num_items = 0;
+  for (const auto &buffer : buffers) {
+    num_items += buffer.size();
+  }
+
+  size_t num_frames = 0;
+  Stopwatch stopwatch;
+  for (int round = 0; round < num_rounds; round++) {
+    for (const auto &buffer : buffers) {
+      size_t index = 0;
+      RTS::ReceivedFrame frame;
+      while (TestRTS::decode_frame(buffer, &index, &frame)) {
+        num_frames++;
+      }
+    }
+  }
+  double nanos = stopwatch.elapsed_nanos();
+
+  std::printf("\nDecoding (%zu frames from %zu receive buffers)\n", num_frames, num_rounds * std::size(buffers));
+  std::printf("  %8.1f ns/frame, %8.1f ns/timing, %.0f frames/s\n", nanos / num_frames,
+              nanos / (double(num_items) * num_rounds), num_frames / (nanos / 1e9));
+}
+
+void run_uart_benchmark() {
+  const int num_batches = quick ? 20 : 2000;
+  esphome::host::reset();
+  Installation installation(1);
+  UartPty pty;
+  RTSUartInterface interface;
+  interface.set_uart_parent(pty.device());
+  interface.set_rts_parent(&installation.rts);
+  interface.setup();
+
+  std::vector<uint8_t> batch{0};
+  for (int i = 0; i < 50; i++) {
+    uint8_t command[] = {0x55, 0x55, 0x55, RTS::OPEN, 0};
+    batch.insert(batch.end(), std::begin(command), std::end(command));
+  }
+
+  size_t num_replies = 0;
+  Stopwatch stopwatch;
+  for (int i = 0; i < num_batches; i++) {
+    batch[0] = i;
+    pty.send_frame(RTSUartInterface::FRAME_COMMAND_BATCH, batch);
+    interface.loop();
+    num_replies += pty.receive_frames().size();
+  }
+  double seconds = stopwatch.elapsed_nanos() / 1e9;
+
+  std::printf("\nUART command ingestion over a pseudo-terminal (%d batches of 50 commands)\n", num_batches);
+  std::printf("  %.0f commands/s, %zu reply frames\n", num_batches * 50 / seconds, num_replies);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  quick = argc > 1 && std::strcmp(argv[1], "--quick") == 0;
+  run_scheduler_scenarios();
+  run_encoding_benchmark();
+  run_decoding_benchmark();
+  run_uart_benchmark();
+  return 0;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "esphome/components/remote_base/remote_base.h"
+#include "esphome/core/component.h"
+
+namespace esphome {
+namespace remote_transmitter {
+
+// Fake transmitter that records every transmission along with the virtual time at which it started.
+// Like a transmitter that waits for the hardware to finish, it blocks for the airtime of the
+// timings it sends, which advances the virtual clock.
+class RemoteTransmitterComponent : public remote_base::RemoteTransmitterBase, public Component {
+ public:
+  struct Transmission {
+    uint64_t start_micros;
+    remote_base::RawTimings timings;
+    // Number of preference saves before the transmission started.
+    uint32_t preference_saves;
+  };
+
+  const std::vector<Transmission> &transmissions() const { return this->transmissions_; }
+  void clear_transmissions() { this->transmissions_.clear(); }
+
+  // Makes the next transmissions fail before anything gets sent.
+  void fail_next_transmissions(uint32_t count) { this->failing_transmissions_ = count; }
+
+  // Stops recording timings, for benchmarks that only care about the time spent in RTS.
+  void set_recording(bool recording) { this->recording_ = recording; }
+
+ protected:
+  void send_internal(uint32_t send_times, uint32_t send_wait) override;
+
+  std::vector<Transmission> transmissions_;
+  bool recording_{true};
+};
+
+}  // namespace remote_transmitter
+}  // namespace esphome
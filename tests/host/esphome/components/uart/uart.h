@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace uart {
+
+// Serial port backed by a file descriptor, such as one side of a pseudo-terminal.
+class UARTComponent {
+ public:
+  explicit UARTComponent(int fd) : fd_(fd) {}
+  int fd() const { return this->fd_; }
+
+ protected:
+  int fd_;
+};
+
+class UARTDevice {
+ public:
+  UARTDevice() = default;
+  explicit UARTDevice(UARTComponent *parent) : parent_(parent) {}
+  void set_uart_parent(UARTComponent *parent) { this->parent_ = parent; }
+
+  void write_array(const uint8_t *data, size_t len);
+  bool read_array(uint8_t *data, size_t len);
+  int available();
+
+ protected:
+  UARTComponent *parent_{nullptr};
+};
+
+}  // namespace uart
+}  // namespace esphome
@@ -0,0 +1,3 @@
+#pragma once
+
+// The host build enables optional features with compile definitions instead.
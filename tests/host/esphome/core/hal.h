@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+
+namespace esphome {
+
+// Read the virtual clock of the host harness, which only moves when the harness advances it.
+uint32_t millis();
+uint32_t micros();
+
+// Advance the virtual clock without running scheduled callbacks, like a busy wait on the device.
+// Threads other than the main thread block until the harness advances the clock instead.
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+}  // namespace esphome
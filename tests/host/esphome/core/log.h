@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cinttypes>
+
+namespace esphome {
+
+enum HostLogLevel {
+  HOST_LOG_LEVEL_NONE,
+  HOST_LOG_LEVEL_ERROR,
+  HOST_LOG_LEVEL_WARN,
+  HOST_LOG_LEVEL_INFO,
+  HOST_LOG_LEVEL_CONFIG,
+  HOST_LOG_LEVEL_DEBUG,
+  HOST_LOG_LEVEL_VERBOSE,
+};
+
+// Prints the message if the level is enabled by the RTS_HOST_LOG_LEVEL environment variable, which
+// defaults to errors only.
+void host_log(HostLogLevel level, const char *tag, const char *format, ...) __attribute__((format(printf, 3, 4)));
+
+}  // namespace esphome
+
+#define ESP_LOGE(tag, ...) ::esphome::host_log(::esphome::HOST_LOG_LEVEL_ERROR, tag, __VA_ARGS__)
+#define ESP_LOGW(tag, ...) ::esphome::host_log(::esphome::HOST_LOG_LEVEL_WARN, tag, __VA_ARGS__)
+#define ESP_LOGI(tag, ...) ::esphome::host_log(::esphome::HOST_LOG_LEVEL_INFO, tag, __VA_ARGS__)
+#define ESP_LOGCONFIG(tag, ...) ::esphome::host_log(::esphome::HOST_LOG_LEVEL_CONFIG, tag, __VA_ARGS__)
+#define ESP_LOGD(tag, ...) ::esphome::host_log(::esphome::HOST_LOG_LEVEL_DEBUG, tag, __VA_ARGS__)
+#define ESP_LOGV(tag, ...) ::esphome::host_log(::esphome::HOST_LOG_LEVEL_VERBOSE, tag, __VA_ARGS__)
+#define ESP_LOGVV(tag, ...) ::esphome::host_log(::esphome::HOST_LOG_LEVEL_VERBOSE, tag, __VA_ARGS__)
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <thread>
+#include <vector>
+
+#include "esphome/core/helpers.h"
+
+namespace esphome {
+
+// Records live in memory for as long as the process runs, so that a test can restart components
+// on top of what earlier instances saved.
+class ESPPreferenceObject {
+ public:
+  ESPPreferenceObject() = default;
+  explicit ESPPreferenceObject(uint32_t type) : type_(type), valid_(true) {}
+
+  template<typename T> bool save(const T *src) {
+    if (!this->valid_) {
+      return false;
+    }
+    if (write_micros() != 0) {
+      std::this_thread::sleep_for(std::chrono::microseconds(write_micros()));
+    }
+    const auto *bytes = reinterpret_cast<const uint8_t *>(src);
+    records()[this->type_].assign(bytes, bytes + sizeof(T));
+    save_counter()++;
+    return true;
+  }
+
+  template<typename T> bool load(T *dest) {
+    if (!this->valid_) {
+      return false;
+    }
+    auto it = records().find(this->type_);
+    if (it == records().end() || it->second.size() != sizeof(T)) {
+      return false;
+    }
+    std::memcpy(dest, it->second.data(), sizeof(T));
+    return true;
+  }
+
+  static std::map<uint32_t, std::vector<uint8_t>> &records() {
+    static std::map<uint32_t, std::vector<uint8_t>> records;
+    return records;
+  }
+  // Transmit task threads read the number of saves along with their transmissions.
+  static std::atomic<uint32_t> &save_counter() {
+    static std::atomic<uint32_t> save_counter{0};
+    return save_counter;
+  }
+  static uint32_t saves() { return save_counter(); }
+  // Real time that each save blocks for, like a flash write, which gives other threads the chance to
+  // run meanwhile.
+  static uint32_t &write_micros() {
+    static uint32_t write_micros = 0;
+    return write_micros;
+  }
+
+ protected:
+  uint32_t type_{0};
+  bool valid_{false};
+};
+
+class ESPPreferences {
+ public:
+  template<typename T> ESPPreferenceObject make_preference(uint32_t type, bool in_flash) {
+    return ESPPreferenceObject(type);
+  }
+  template<typename T> ESPPreferenceObject make_preference(uint32_t type) { return ESPPreferenceObject(type); }
+  bool sync() { return true; }
+};
+
+extern ESPPreferences *global_preferences;
+
+}  // namespace esphome
@@ -0,0 +1,366 @@
+#include "host.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include "esphome/components/remote_transmitter/remote_transmitter.h"
+#include "esphome/components/uart/uart.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/log.h"
+#include "esphome/core/preferences.h"
+
+namespace esphome {
+
+namespace {
+
+struct Callback {
+  uint64_t due_micros = 0;
+  uint64_t sequence;
+  Component *component;
+  // Empty for callbacks without a name, which cannot be cancelled.
+  std::string name;
+  std::function<void()> f;
+};
+
+struct HostState {
+  // Read by every thread, advanced by the main thread, or by any thread when none else runs.
+  std::atomic<uint64_t> now_micros{1000000};
+  uint64_t next_sequence{0};
+  uint32_t random_state{0x12345678};
+  std::vector<Callback> callbacks;
+  std::vector<Component *> loop_components;
+  std::thread::id main_thread{std::this_thread::get_id()};
+
+  // Threads other than the main thread that wait for the clock to reach their deadline.
+  std::mutex mutex;
+  std::condition_variable clock_advanced;
+  std::vector<uint64_t> sleeper_deadlines;
+  bool is_stopping{false};
+  std::function<bool()> idle_check;
+};
+
+HostState &state() {
+  static HostState state;
+  return state;
+}
+
+bool is_main_thread() { return std::this_thread::get_id() == state().main_thread; }
+
+void advance_clock_to(uint64_t micros) {
+  auto &host = state();
+  {
+    std::lock_guard<std::mutex> lock(host.mutex);
+    if (micros <= host.now_micros) {
+      return;
+    }
+    host.now_micros = micros;
+  }
+  host.clock_advanced.notify_all();
+}
+
+// Blocks a thread other than the main thread until the main thread advances the clock past the
+// deadline, the way delay() blocks a task on the device while others run.
+void sleep_until(uint64_t deadline_micros) {
+  auto &host = state();
+  std::unique_lock<std::mutex> lock(host.mutex);
+  host.sleeper_deadlines.push_back(deadline_micros);
+  host.clock_advanced.wait(lock, [&]() { return host.now_micros >= deadline_micros || host.is_stopping; });
+  host.sleeper_deadlines.erase(
+      std::find(host.sleeper_deadlines.begin(), host.sleeper_deadlines.end(), deadline_micros));
+}
+
+void wait_micros(uint64_t micros) {
+  if (is_main_thread()) {
+    advance_clock_to(state().now_micros + micros);
+  } else {
+    sleep_until(state().now_micros + micros);
+  }
+}
+
+// Waits until every other thread is blocked, so that the clock only moves when they are done with
+// the current moment.
+void wait_for_threads() {
+  auto &host = state();
+  while (host.idle_check && !host.idle_check()) {
+    std::this_thread::yield();
+  }
+}
+
+// Earliest time at which a callback or a sleeping thread is due, if any is.
+bool next_event_micros(uint64_t *due_micros) {
+  auto &host = state();
+  bool found = false;
+  for (const auto &callback : host.callbacks) {
+    if (!found || callback.due_micros < *due_micros) {
+      *due_micros = callback.due_micros;
+      found = true;
+    }
+  }
+  std::lock_guard<std::mutex> lock(host.mutex);
+  for (uint64_t deadline : host.sleeper_deadlines) {
+    if (!found || deadline < *due_micros) {
+      *due_micros = deadline;
+      found = true;
+    }
+  }
+  return found;
+}
+
+void add_callback(Component *component, const std::string &name, uint64_t delay_micros, std::function<void()> &&f) {
+  auto &host = state();
+  if (!name.empty()) {
+    auto it = std::remove_if(host.callbacks.begin(), host.callbacks.end(), [&](const Callback &callback) {
+      return callback.component == component && callback.name == name;
+    });
+    host.callbacks.erase(it, host.callbacks.end());
+  }
+  host.callbacks.push_back({host.now_micros + delay_micros, host.next_sequence++, component, name, std::move(f)});
+}
+
+// Runs every callback that is due, then loop() of the loop components. Callbacks that get added
+// for the current time run in the next iteration, like deferred calls on the device. Threads that
+// sleep until the next due time get woken, and finish before the callbacks run.
+bool run_iteration(uint64_t until_micros) {
+  auto &host = state();
+  wait_for_threads();
+  uint64_t due_micros = 0;
+  if (!next_event_micros(&due_micros) || due_micros > until_micros) {
+    return false;
+  }
+  advance_clock_to(due_micros);
+  wait_for_threads();
+
+  std::vector<Callback> due;
+  uint64_t last_sequence = host.next_sequence;
+  for (auto it = host.callbacks.begin(); it != host.callbacks.end();) {
+    if (it->due_micros <= host.now_micros && it->sequence < last_sequence) {
+      due.push_back(std::move(*it));
+      it = host.callbacks.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  std::sort(due.begin(), due.end(), [](const Callback &a, const Callback &b) { return a.sequence < b.sequence; });
+  for (auto &callback : due) {
+    callback.f();
+  }
+
+  for (auto *component : host.loop_components) {
+    if (component->is_loop_enabled()) {
+      component->loop();
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+namespace host {
+
+uint64_t now_micros() { return state().now_micros; }
+
+void reset() {
+  auto &host = state();
+  {
+    std::lock_guard<std::mutex> lock(host.mutex);
+    host.is_stopping = false;
+    host.idle_check = nullptr;
+  }
+  host.now_micros = 1000000;
+  host.next_sequence = 0;
+  host.random_state = 0x12345678;
+  host.callbacks.clear();
+  host.loop_components.clear();
+  ESPPreferenceObject::records().clear();
+  ESPPreferenceObject::save_counter() = 0;
+  ESPPreferenceObject::write_micros() = 0;
+}
+
+void add_loop_component(Component *component) { state().loop_components.push_back(component); }
+
+uint32_t run_for(uint32_t millis) {
+  auto &host = state();
+  uint64_t until_micros = host.now_micros + uint64_t(millis) * 1000;
+  uint32_t num_iterations = 0;
+  while (run_iteration(until_micros)) {
+    num_iterations++;
+  }
+  advance_clock_to(until_micros);
+  wait_for_threads();
+  return num_iterations;
+}
+
+uint32_t run_until_idle(uint32_t max_millis) {
+  auto &host = state();
+  uint64_t start_micros = host.now_micros;
+  uint64_t until_micros = start_micros + uint64_t(max_millis) * 1000;
+  while (run_iteration(until_micros)) {
+  }
+  return (host.now_micros - start_micros) / 1000;
+}
+
+size_t num_pending_callbacks() { return state().callbacks.size(); }
+
+void set_idle_check(std::function<bool()> idle_check) { state().idle_check = std::move(idle_check); }
+
+size_t num_sleeping_threads() {
+  auto &host = state();
+  std::lock_guard<std::mutex> lock(host.mutex);
+  return host.sleeper_deadlines.size();
+}
+
+void stop_threads() {
+  auto &host = state();
+  {
+    std::lock_guard<std::mutex> lock(host.mutex);
+    host.is_stopping = true;
+    host.idle_check = nullptr;
+  }
+  host.clock_advanced.notify_all();
+}
+
+}  // namespace host
+
+uint32_t millis() { return state().now_micros / 1000; }
+uint32_t micros() { return state().now_micros; }
+void delay(uint32_t ms) { wait_micros(uint64_t(ms) * 1000); }
+void delayMicroseconds(uint32_t us) { wait_micros(us); }
+
+uint32_t random_uint32() {
+  // xorshift32, seeded by host::reset(), so that random channel ids repeat from run to run.
+  uint32_t &x = state().random_state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return x;
+}
+
+uint32_t fnv1_hash(const std::string &str) {
+  uint32_t hash = 2166136261UL;
+  for (char c : str) {
+    hash *= 16777619UL;
+    hash ^= c;
+  }
+  return hash;
+}
+
+uint8_t crc8(const uint8_t *data, uint8_t len) {
+  uint8_t crc = 0;
+  while ((len--) != 0u) {
+    uint8_t inbyte = *data++;
+    for (uint8_t i = 8; i != 0u; i--) {
+      bool mix = (crc ^ inbyte) & 0x01;
+      crc >>= 1;
+      if (mix) {
+        crc ^= 0x8C;
+      }
+      inbyte >>= 1;
+    }
+  }
+  return crc;
+}
+
+void host_log(HostLogLevel level, const char *tag, const char *format, ...) {
+  static const int max_level = [] {
+    const char *env = std::getenv("RTS_HOST_LOG_LEVEL");
+    return env != nullptr ? std::atoi(env) : static_cast<int>(HOST_LOG_LEVEL_ERROR);
+  }();
+  if (level > max_level) {
+    return;
+  }
+
+  static const char *const LEVELS = "?EWICDV";
+  std::printf("[%8.3f][%c][%s] ", state().now_micros.load() / 1000.0, LEVELS[level], tag);
+  va_list args;
+  va_start(args, format);
+  std::vprintf(format, args);
+  va_end(args);
+  std::printf("\n");
+}
+
+static ESPPreferences host_preferences;
+ESPPreferences *global_preferences = &host_preferences;
+
+void Component::defer(std::function<void()> &&f) { add_callback(this, "", 0, std::move(f)); }
+void Component::defer(const std::string &name, std::function<void()> &&f) {
+  add_callback(this, name, 0, std::move(f));
+}
+void Component::set_timeout(uint32_t timeout, std::function<void()> &&f) {
+  add_callback(this, "", uint64_t(timeout) * 1000, std::move(f));
+}
+void Component::set_timeout(const std::string &name, uint32_t timeout, std::function<void()> &&f) {
+  add_callback(this, name, uint64_t(timeout) * 1000, std::move(f));
+}
+bool Component::cancel_timeout(const std::string &name) {
+  auto &callbacks = state().callbacks;
+  auto it = std::remove_if(callbacks.begin(), callbacks.end(), [&](const Callback &callback) {
+    return callback.component == this && callback.name == name;
+  });
+  bool cancelled = it != callbacks.end();
+  callbacks.erase(it, callbacks.end());
+  return cancelled;
+}
+
+namespace remote_transmitter {
+
+void RemoteTransmitterComponent::send_internal(uint32_t send_times, uint32_t send_wait) {
+  uint64_t airtime_micros = 0;
+  for (int32_t item : this->temp_.get_data()) {
+    airtime_micros += item < 0 ? -item : item;
+  }
+  if (this->recording_) {
+    this->transmissions_.push_back({state().now_micros, this->temp_.get_data(), ESPPreferenceObject::saves()});
+  }
+  wait_micros(airtime_micros);
+}
+
+}  // namespace remote_transmitter
+
+namespace uart {
+
+void UARTDevice::write_array(const uint8_t *data, size_t len) {
+  while (len > 0) {
+    ssize_t written = ::write(this->parent_->fd(), data, len);
+    if (written <= 0) {
+      return;
+    }
+    data += written;
+    len -= written;
+  }
+}
+
+bool UARTDevice::read_array(uint8_t *data, size_t len) {
+  while (len > 0) {
+    ssize_t size = ::read(this->parent_->fd(), data, len);
+    if (size <= 0) {
+      return false;
+    }
+    data += size;
+    len -= size;
+  }
+  return true;
+}
+
+int UARTDevice::available() {
+  int available = 0;
+  if (::ioctl(this->parent_->fd(), FIONREAD, &available) != 0) {
+    return 0;
+  }
+  return available;
+}
+
+}  // namespace uart
+
+}  // namespace esphome
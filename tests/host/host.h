@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+#include "esphome/core/component.h"
+
+namespace esphome {
+namespace host {
+
+// Virtual clock of the harness. It starts at 1 second, so that timestamps of 0 keep meaning
+// "never", and only moves when the harness runs or a component waits.
+uint64_t now_micros();
+
+// Clears all callbacks, loop components and saved preferences, and resets the clock and the random
+// number generator, so that every test starts from the same state.
+void reset();
+
+// loop() of these components runs after every batch of callbacks, like the main loop does.
+void add_loop_component(Component *component);
+
+// Runs callbacks in the order of their due times until the clock reaches the given duration from
+// now. Returns the number of main loop iterations that ran callbacks.
+uint32_t run_for(uint32_t millis);
+
+// Runs callbacks until none are left, or until max_millis pass. Returns the virtual time that
+// passed in milliseconds.
+uint32_t run_until_idle(uint32_t max_millis = 600000);
+
+// Number of callbacks that are waiting to run.
+size_t num_pending_callbacks();
+
+// Threads other than the main thread, such as transmit tasks, block in delay() and in transmissions
+// until the harness advances the clock past their end. The harness only advances it while the
+// check returns true, which it should once every such thread is blocked, either sleeping or
+// waiting for work.
+void set_idle_check(std::function<bool()> idle_check);
+size_t num_sleeping_threads();
+
+// Wakes every sleeping thread for good, so that threads can be stopped and joined. Lasts until the
+// next reset().
+void stop_threads();
+
+}  // namespace host
+}  // namespace esphome
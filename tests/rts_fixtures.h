@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+
+// Raw receive timings for the decoder tests and benchmark, in the format that remote_receiver
+// hands to its listeners. They were synthesized from the encoder's spec timings, then given what a
+// receiver records on top of the clean waveform: short noise pulses before the first frame, every
+// duration off by a random amount of up to the given percentage, and inter-frame gaps.
+namespace rts_test {
+namespace fixtures {
+
+// OPEN on channel 0x1a2b3c with rolling code 1234, with full sync and up to 8% jitter.
+static const int32_t OPEN_FULL_SYNC[] = {
+    143, -574, 168, -830, 327, -1469, 237, -2016, 245, -1444, 2416, -2344,
+    2512, -2368, 2585, -2464, 2416, -2223, 2392, -2392, 2392, -2368, 2344, -2512,
+    4323, -1244, 1136, -1112, 1184, -592, 616, -1256, 562, -586, 580, -598,
+    634, -634, 1280, -562, 640, -646, 610, -1220, 598, -592, 586, -598,
+    1148, -1268, 1232, -592, 610, -592, 652, -1304, 1148, -1136, 1160, -562,
+    628, -1148, 1244, -1220, 574, -580, 1244, -568, 568, -610, 634, -562,
+    616, -1280, 610, -610, 1160, -610, 598, -1160, 1208, -622, 598, -580,
+    592, -1160, 1232, -598, 574, -1196, 562, -622, 598, -628, 562, -652,
+    1280, -1220, 1112, -1196, 1196, -1160, 1268, -1232, 622, -31327,
+};
+
+// STOP on channel 0x00f00d with rolling code 42, sent three times like a held button, with up to 10%
+// jitter.
+static const int32_t STOP_REPEATED[] = {
+    219, -756, 259, -1270, 188, -1014, 291, -1632, 418, -1862, 2223, -2272,
+    2296, -2512, 2223, -2633, 2199, -2464, 2536, -2609, 2560, -2392, 2488, -2392,
+    4550, -1268, 1280, -1124, 1148, -610, 550, -1316, 574, -664, 604, -610,
+    628, -568, 1100, -1208, 616, -634, 1232, -664, 646, -574, 580, -1160,
+    610, -574, 1160, -1196, 628, -604, 1208, -586, 550, -550, 586, -1136,
+    646, -652, 1196, -604, 628, -1100, 574, -592, 1304, -1148, 628, -664,
+    580, -568, 1100, -580, 610, -1160, 1124, -1136, 562, -592, 1328, -544,
+    544, -1268, 646, -598, 1100, -664, 610, -1256, 568, -652, 1088, -604,
+    550, -1280, 562, -652, 1136, -562, 568, -1160, 586, -652, 1244, -31371,
+    2272, -2368, 2272, -2609, 4914, -1124, 1208, -1100, 1172, -598, 592, -1244,
+    658, -610, 598, -658, 574, -646, 1280, -1208, 550, -562, 1292, -550,
+    568, -550, 652, -1244, 652, -574, 1316, -1220, 616, -568, 1136, -658,
+    658, -556, 604, -1172, 610, -592, 1232, -616, 622, -1316, 586, -622,
+    1100, -1220, 568, -574, 622, -646, 1112, -634, 580, -1232, 1292, -1160,
+    562, -640, 1220, -574, 616, -1172, 568, -658, 1268, -628, 574, -1304,
+    604, -544, 1184, -628, 664, -1232, 598, -556, 1280, -604, 664, -1244,
+    562, -598, 1124, -31269, 2175, -2223, 2512, -2175, 4141, -1220, 1268, -1220,
+    1268, -550, 568, -1160, 664, -586, 556, -634, 568, -544, 1160, -1172,
+    616, -556, 1268, -640, 544, -562, 604, -1268, 610, -604, 1100, -1292,
+    664, -580, 1304, -592, 610, -652, 544, -1136, 646, -616, 1124, -628,
+    550, -1124, 646, -598, 1112, -1292, 640, -580, 652, -616, 1208, -610,
+    652, -1148, 1172, -1232, 550, -580, 1100, -640, 562, -1316, 658, -556,
+    1268, -544, 652, -1184, 628, -592, 1268, -664, 604, -1088, 658, -568,
+    1220, -646, 574, -1268, 658, -652, 1208, -31311,
+};
+
+// CLOSE on channel 0x123456 with rolling code 65000, then PROGRAM on channel 0xabcdef with rolling
+// code 7 and abbreviated sync, with up to 12% jitter.
+static const int32_t CLOSE_THEN_PROGRAM[] = {
+    152, -574, 255, -1000, 288, -1391, 210, -1392, 442, -2451, 2512, -2464,
+    2392, -2223, 2681, -2151, 2199, -2681, 2344, -2344, 2609, -2416, 2488, -2320,
+    4004, -1268, 1112, -1160, 1076, -592, 544, -1100, 676, -592, 592, -676,
+    574, -610, 622, -646, 616, -616, 1232, -1208, 640, -538, 1172, -1352,
+    1208, -616, 652, -568, 580, -1136, 1316, -568, 556, -538, 550, -658,
+    676, -1148, 574, -676, 604, -598, 532, -652, 580, -652, 1124, -622,
+    664, -646, 550, -1268, 1304, -1352, 1304, -1352, 598, -610, 616, -550,
+    1088, -1208, 1100, -568, 628, -1160, 628, -574, 1196, -1160, 1064, -1172,
+    1184, -664, 538, -568, 532, -1340, 1292, -664, 670, -556, 586, -31693,
+    2127, -2175, 2633, -2512, 4141, -1124, 1196, -1244, 1268, -556, 664, -1160,
+    634, -580, 532, -568, 1088, -610, 544, -1064, 1160, -574, 604, -1340,
+    1064, -568, 556, -622, 628, -562, 610, -1136, 1100, -646, 592, -1124,
+    1220, -664, 616, -580, 646, -676, 544, -1328, 1088, -550, 538, -592,
+    676, -1292, 616, -670, 580, -616, 568, -622, 1088, -676, 664, -1304,
+    610, -670, 1244, -556, 580, -622, 538, -598, 580, -658, 568, -532,
+    652, -562, 616, -634, 640, -670, 574, -1196, 616, -544, 1148, -1244,
+    1148, -1172, 1244, -1328, 1172, -31609,
+};
+
+}  // namespace fixtures
+}  // namespace rts_test
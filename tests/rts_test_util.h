@@ -0,0 +1,330 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "esphome/components/remote_transmitter/remote_transmitter.h"
+#include "host/host.h"
+#include "rts.h"
+#include "rts_channel.h"
+
+namespace rts_test {
+
+using esphome::remote_base::RawTimings;
+using esphome::remote_transmitter::RemoteTransmitterComponent;
+using esphome::rts::RTS;
+using esphome::rts::RTSChannel;
+
+using Payload = std::array<uint8_t, 7>;
+
+// Durations from the protocol description at https://pushstack.wordpress.com/somfy-rts-protocol/,
+// kept apart from the constants of the component, so that the two can be checked against each other.
+namespace spec {
+static constexpr uint32_t wakeup_high_micros = 9415;
+static constexpr uint32_t wakeup_low_micros = 89565;
+static constexpr uint32_t symbol_micros = 1208;
+static constexpr uint32_t half_symbol_micros = symbol_micros / 2;
+static constexpr uint32_t hardware_sync_high_micros = 2 * symbol_micros;
+static constexpr uint32_t hardware_sync_low_micros = 2 * symbol_micros;
+static constexpr uint32_t software_sync_high_micros = 4550;
+static constexpr uint32_t software_sync_low_micros = half_symbol_micros;
+static constexpr uint32_t inter_frame_gap_micros = 30415;
+}  // namespace spec
+
+inline uint32_t duration_micros(int32_t item) { return item < 0 ? -item : item; }
+
+inline uint32_t airtime_micros(const RawTimings &timings) {
+  uint32_t total = 0;
+  for (int32_t item : timings) {
+    total += duration_micros(item);
+  }
+  return total;
+}
+
+inline bool is_near(int32_t item, uint32_t expected) {
+  uint32_t duration = duration_micros(item);
+  return duration * 4 >= expected * 3 && duration * 4 <= expected * 5;
+}
+
+// Merges adjacent items at the same level, the way they appear on air.
+inline RawTimings merged(const RawTimings &timings) {
+  RawTimings on_air;
+  for (int32_t item : timings) {
+    if (!on_air.empty() && (on_air.back() > 0) == (item > 0)) {
+      on_air.back() += item;
+    } else {
+      on_air.push_back(item);
+    }
+  }
+  return on_air;
+}
+
+// A transmitter as it would be measured: every mark lasts overhead_micros longer than requested,
+// at the expense of the following space.
+inline RawTimings apply_mark_overhead(const RawTimings &timings, int32_t overhead_micros) {
+  RawTimings on_air = timings;
+  for (auto &item : on_air) {
+    item += overhead_micros;
+  }
+  return on_air;
+}
+
+// The obfuscated payload of a frame: the key byte 0xa7, the control code and checksum, the
+// big-endian rolling code and the little-endian channel id, with every byte XORed with the previous
+// obfuscated byte.
+inline Payload reference_payload(RTS::RTSControlCode control_code, uint32_t channel_id, uint16_t rolling_code) {
+  Payload clear{0xa7,
+                static_cast<uint8_t>(control_code << 4),
+                static_cast<uint8_t>(rolling_code >> 8),
+                static_cast<uint8_t>(rolling_code),
+                static_cast<uint8_t>(channel_id),
+                static_cast<uint8_t>(channel_id >> 8),
+                static_cast<uint8_t>(channel_id >> 16)};
+  uint8_t checksum = 0;
+  for (uint8_t byte : clear) {
+    checksum ^= byte ^ (byte >> 4);
+  }
+  clear[1] |= checksum & 0xf;
+
+  Payload obfuscated;
+  for (size_t i = 0; i < clear.size(); i++) {
+    obfuscated[i] = clear[i] ^ (i > 0 ? obfuscated[i - 1] : 0);
+  }
+  return obfuscated;
+}
+
+// Builds the frame that the protocol describes, one Manchester half-bit at a time.
+inline RawTimings reference_frame(const Payload &payload, bool abbreviated_sync) {
+  RawTimings timings;
+  for (int i = 0; i < (abbreviated_sync ? 2 : 7); i++) {
+    timings.push_back(spec::hardware_sync_high_micros);
+    timings.push_back(-static_cast<int32_t>(spec::hardware_sync_low_micros));
+  }
+  timings.push_back(spec::software_sync_high_micros);
+  timings.push_back(-static_cast<int32_t>(spec::software_sync_low_micros));
+
+  const int32_t half = spec::half_symbol_micros;
+  for (uint8_t byte : payload) {
+    for (int bit = 7; bit >= 0; bit--) {
+      // A 0 bit is a falling edge, a 1 bit a rising edge.
+      bool one = ((byte >> bit) & 1) != 0;
+      timings.push_back(one ? -half : half);
+      timings.push_back(one ? half : -half);
+    }
+  }
+  return merged(timings);
+}
+
+// A frame that went out, decoded from transmitted timings.
+struct Frame {
+  uint64_t start_micros;
+  uint32_t channel_id;
+  RTS::RTSControlCode control_code;
+  uint16_t rolling_code;
+  int num_hardware_syncs;
+};
+
+// Reads the 56 data bits that follow the software sync mark at on_air[index].
+inline bool read_payload(const RawTimings &on_air, size_t index, Payload *payload) {
+  std::vector<bool> halves;
+  // The software sync ends with half a symbol of silence, which can merge with the first data half.
+  bool skip_sync_low = true;
+  for (size_t i = index + 1; i < on_air.size() && halves.size() < 112; i++) {
+    uint32_t num_halves = (duration_micros(on_air[i]) + spec::half_symbol_micros / 2) / spec::half_symbol_micros;
+    if (skip_sync_low) {
+      skip_sync_low = false;
+      num_halves--;
+    }
+    for (uint32_t j = 0; j < num_halves && halves.size() < 112; j++) {
+      halves.push_back(on_air[i] > 0);
+    }
+  }
+  if (halves.size() < 112) {
+    return false;
+  }
+
+  payload->fill(0);
+  for (size_t bit = 0; bit < 56; bit++) {
+    bool first = halves[2 * bit];
+    bool second = halves[2 * bit + 1];
+    if (first == second) {
+      return false;
+    }
+    (*payload)[bit / 8] |= (second ? 1 : 0) << (7 - bit % 8);
+  }
+  return true;
+}
+
+// Decodes every frame of a transmission that started at start_micros.
+inline void decode_frames(const RawTimings &timings, uint64_t start_micros, std::vector<Frame> *frames) {
+  RawTimings on_air = merged(timings);
+  uint64_t offset_micros = 0;
+  for (size_t i = 0; i < on_air.size(); offset_micros += duration_micros(on_air[i]), i++) {
+    Payload payload;
+    if (on_air[i] <= 0 || !is_near(on_air[i], spec::software_sync_high_micros) ||
+        !read_payload(on_air, i, &payload)) {
+      continue;
+    }
+
+    Payload clear;
+    uint8_t checksum = 0;
+    for (size_t j = 0; j < clear.size(); j++) {
+      clear[j] = payload[j] ^ (j > 0 ? payload[j - 1] : 0);
+      checksum ^= clear[j] ^ (clear[j] >> 4);
+    }
+    if ((checksum & 0xf) != 0) {
+      continue;
+    }
+
+    size_t first_sync = i;
+    uint64_t sync_micros = 0;
+    while (first_sync >= 2 && on_air[first_sync - 2] > 0 &&
+           is_near(on_air[first_sync - 2], spec::hardware_sync_high_micros) &&
+           is_near(on_air[first_sync - 1], spec::hardware_sync_low_micros)) {
+      first_sync -= 2;
+      sync_micros += duration_micros(on_air[first_sync]) + duration_micros(on_air[first_sync + 1]);
+    }
+    frames->push_back({start_micros + offset_micros - sync_micros,
+                       static_cast<uint32_t>(clear[4] | clear[5] << 8 | clear[6] << 16),
+                       static_cast<RTS::RTSControlCode>(clear[1] >> 4),
+                       static_cast<uint16_t>(clear[2] << 8 | clear[3]), static_cast<int>(i - first_sync) / 2});
+  }
+}
+
+// Counts the wakeup marks among transmitted timings.
+inline size_t count_wakeups(const RawTimings &timings) {
+  size_t count = 0;
+  for (int32_t item : timings) {
+    count += item > 0 && is_near(item, spec::wakeup_high_micros) ? 1 : 0;
+  }
+  return count;
+}
+
+// Exposes the frame encoding and decoding of RTS to the tests.
+class TestRTS : public RTS {
+ public:
+  using RTS::decode_frame;
+  using RTS::decode_payload;
+  using RTS::encode_payload;
+  using RTS::Timing;
+  using RTS::TimingProfile;
+
+  // Encodes a frame the way a transmitter does before it replays the frame for each repetition.
+  void encode_frame(const Payload &payload, bool abbreviated_sync) {
+    RTS::encode_frame(this->encoder_, payload, abbreviated_sync);
+  }
+  const RawTimings &frame_timings() const { return this->encoder_.frame_timings; }
+
+  const esphome::rts::RTSTraceBuffer &trace(size_t transmitter) const {
+    return this->transmitters_[transmitter]->trace;
+  }
+
+#ifdef USE_RTS_TRANSMIT_TASK
+  // Whether every transmit task is blocked, either waiting for work that nobody notified it of yet,
+  // or sleeping until the clock reaches the end of a delay or a transmission.
+  bool are_transmit_tasks_blocked() {
+    size_t num_waiting = 0;
+    for (auto &tx : this->transmitters_) {
+      std::lock_guard<std::mutex> lock(tx->task_mutex);
+      num_waiting += tx->task_waiting && !tx->task_notified ? 1 : 0;
+    }
+    return num_waiting + esphome::host::num_sleeping_threads() == this->transmitters_.size();
+  }
+#endif
+
+ protected:
+  Transmitter encoder_;
+};
+
+// One RTS component with a fake transmitter and a number of channels with known ids, whose command
+// results get recorded.
+struct Installation {
+  struct Result {
+    RTS::CommandHandle handle;
+    uint32_t channel_id;
+    RTS::RTSControlCode control_code;
+    RTS::CommandResult result;
+    uint32_t done_millis;
+  };
+
+  // Channel ids get configured through a 16-bit value.
+  static constexpr uint32_t first_channel_id = 0x1000;
+
+  explicit Installation(size_t num_channels, size_t queue_capacity = 16, bool channel_table = false) {
+    this->rts.set_queue_capacity(queue_capacity);
+    if (channel_table) {
+      this->rts.enable_channel_table();
+    }
+    this->rts.add_transmitter(&this->transmitter);
+    // Channels keep a pointer to their name.
+    this->names.reserve(num_channels);
+    this->rts.reserve_channels(num_channels);
+    for (size_t i = 0; i < num_channels; i++) {
+      this->names.push_back("cover " + std::to_string(i));
+      std::unique_ptr<RTSChannel> channel(new RTSChannel());
+      channel->set_registry(&this->rts.channel_registry());
+      channel->init(i + 1, this->names.back().c_str());
+      channel->config_channel(first_channel_id + i, 100);
+      this->channels.push_back(std::move(channel));
+    }
+    this->rts.add_on_command_done_callback([this](RTS::CommandHandle handle, uint32_t channel_id,
+                                                  RTS::RTSControlCode control_code, RTS::CommandResult result) {
+      this->results.push_back({handle, channel_id, control_code, result, esphome::millis()});
+    });
+    this->rts.setup();
+#ifdef USE_RTS_TRANSMIT_TASK
+    esphome::host::set_idle_check([this]() { return this->rts.are_transmit_tasks_blocked(); });
+#endif
+    esphome::host::add_loop_component(&this->rts);
+  }
+  // Transmit tasks keep running until the component gets destroyed, and must not wait for the clock
+  // meanwhile.
+  ~Installation() { esphome::host::stop_threads(); }
+
+  RTSChannel *channel(size_t index) { return this->channels[index].get(); }
+
+  // Sets the repetitions the way the codegen does when neither min_command_repetitions nor
+  // max_command_repetitions are configured.
+  void use_fixed_repetitions(int repetitions) {
+    this->rts.set_command_repetitions(repetitions);
+    this->rts.set_min_command_repetitions(repetitions);
+    this->rts.set_max_command_repetitions(repetitions);
+  }
+
+  // Decodes every transmitted frame.
+  std::vector<Frame> frames() const {
+    std::vector<Frame> frames;
+    for (const auto &transmission : this->transmitter.transmissions()) {
+      decode_frames(transmission.timings, transmission.start_micros, &frames);
+    }
+    return frames;
+  }
+
+  size_t wakeups() const {
+    size_t count = 0;
+    for (const auto &transmission : this->transmitter.transmissions()) {
+      count += count_wakeups(transmission.timings);
+    }
+    return count;
+  }
+
+  const Result *result_for(RTS::CommandHandle handle) const {
+    for (const auto &result : this->results) {
+      if (result.handle == handle) {
+        return &result;
+      }
+    }
+    return nullptr;
+  }
+
+  // Declared first, so that it outlives the transmit tasks of the component.
+  RemoteTransmitterComponent transmitter;
+  TestRTS rts;
+  std::vector<std::string> names;
+  std::vector<std::unique_ptr<RTSChannel>> channels;
+  std::vector<Result> results;
+};
+
+}  // namespace rts_test
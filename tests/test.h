@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Minimal test registry, so that the host tests build with nothing but a compiler.
+namespace rts_test {
+
+struct TestCase {
+  const char *name;
+  void (*run)();
+};
+
+std::vector<TestCase> &test_cases();
+int &num_failures();
+
+struct Registration {
+  Registration(const char *name, void (*run)()) { test_cases().push_back({name, run}); }
+};
+
+inline void report_failure(const char *file, int line, const char *expression) {
+  std::printf("%s:%d: check failed: %s\n", file, line, expression);
+  num_failures()++;
+}
+
+template<typename A, typename B>
+inline void report_mismatch(const char *file, int line, const char *a_expression, const char *b_expression, A a,
+                            B b) {
+  std::printf("%s:%d: check failed: %s == %s (%lld vs %lld)\n", file, line, a_expression, b_expression,
+              static_cast<long long>(a), static_cast<long long>(b));
+  num_failures()++;
+}
+
+}  // namespace rts_test
+
+#define RTS_TEST(name) \
+  static void name(); \
+  static ::rts_test::Registration name##_registration(#name, name); \
+  static void name()
+
+#define CHECK(expression) \
+  do { \
+    if (!(expression)) { \
+      ::rts_test::report_failure(__FILE__, __LINE__, #expression); \
+    } \
+  } while (false)
+
+#define CHECK_EQ(a, b) \
+  do { \
+    auto a_value = (a); \
+    auto b_value = (b); \
+    if (!(a_value == b_value)) { \
+      ::rts_test::report_mismatch(__FILE__, __LINE__, #a, #b, a_value, b_value); \
+    } \
+  } while (false)
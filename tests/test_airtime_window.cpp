@@ -0,0 +1,48 @@
+#include "rts_airtime_window.h"
+#include "test.h"
+
+using esphome::rts::RTSAirtimeWindow;
+
+RTS_TEST(airtime_window_expires_one_bucket_at_a_time) {
+  RTSAirtimeWindow window;
+  window.set_window_millis(16000);
+  CHECK_EQ(window.window_millis(), 16000u);
+
+  window.add(500, 100000);
+  window.add(1500, 200000);
+  CHECK_EQ(window.used_micros(1500), 300000u);
+
+  // The first bucket expires a full window after it started.
+  CHECK_EQ(window.used_micros(15999), 300000u);
+  CHECK_EQ(window.used_micros(16000), 200000u);
+  CHECK_EQ(window.used_micros(17000), 0u);
+}
+
+RTS_TEST(airtime_window_reports_time_until_next_bucket) {
+  RTSAirtimeWindow window;
+  window.set_window_millis(1600);
+  window.add(0, 1000);
+  CHECK_EQ(window.millis_until_next_bucket(30), 70u);
+  CHECK_EQ(window.millis_until_next_bucket(100), 100u);
+}
+
+RTS_TEST(airtime_window_clears_after_long_idle) {
+  RTSAirtimeWindow window;
+  window.set_window_millis(1600);
+  for (uint32_t now = 0; now < 1600; now += 100) {
+    window.add(now, 1000);
+  }
+  CHECK_EQ(window.used_micros(1599), 16000u);
+  CHECK_EQ(window.used_micros(1000000), 0u);
+}
+
+RTS_TEST(airtime_window_survives_millis_wraparound) {
+  RTSAirtimeWindow window;
+  window.set_window_millis(1600);
+  uint32_t start = UINT32_MAX - 150;
+  window.add(0, 0);
+  window.add(start, 0);
+  window.add(start, 5000);
+  CHECK_EQ(window.used_micros(start + 200), 5000u);
+  CHECK_EQ(window.used_micros(start + 1700), 0u);
+}
@@ -0,0 +1,235 @@
+#include "rts_test_util.h"
+#include "test.h"
+
+using namespace rts_test;
+using esphome::ESPPreferenceObject;
+using esphome::rts::RTSChannelRegistry;
+
+namespace {
+
+// Adds a channel to the registry, the way a cover does during setup.
+void add_channel(RTSChannelRegistry *registry, RTSChannel *channel, uint32_t preference_id) {
+  channel->set_registry(registry);
+  channel->init(preference_id, "cover");
+}
+
+}  // namespace
+
+RTS_TEST(lease_saves_once_per_lease) {
+  RTSChannelRegistry registry;
+  registry.set_rolling_code_lease_size(10);
+  RTSChannel channel;
+  add_channel(&registry, &channel, 1);
+  channel.config_channel(0x1000, 100);
+
+  uint32_t saves_before = ESPPreferenceObject::saves();
+  for (uint16_t code = 100; code < 125; code++) {
+    CHECK_EQ(channel.consume_rolling_code_value(), code);
+  }
+  // New leases start at 100, 110 and 120.
+  CHECK_EQ(ESPPreferenceObject::saves() - saves_before, 3u);
+  CHECK_EQ(channel.flash_writes_avoided(), 22u);
+}
+
+RTS_TEST(unclean_restart_resumes_after_lease) {
+  RTSChannelRegistry registry;
+  registry.set_rolling_code_lease_size(10);
+  RTSChannel channel;
+  add_channel(&registry, &channel, 1);
+  channel.config_channel(0x1000, 100);
+  for (int i = 0; i < 3; i++) {
+    channel.consume_rolling_code_value();
+  }
+
+  RTSChannelRegistry restarted_registry;
+  restarted_registry.set_rolling_code_lease_size(10);
+  RTSChannel restarted;
+  add_channel(&restarted_registry, &restarted, 1);
+  CHECK_EQ(restarted.id(), 0x1000u);
+  CHECK_EQ(restarted.rolling_code(), 110);
+}
+
+RTS_TEST(released_lease_keeps_next_code) {
+  RTSChannelRegistry registry;
+  registry.set_rolling_code_lease_size(10);
+  RTSChannel channel;
+  add_channel(&registry, &channel, 1);
+  channel.config_channel(0x1000, 100);
+  for (int i = 0; i < 3; i++) {
+    channel.consume_rolling_code_value();
+  }
+  channel.release_rolling_code_lease();
+
+  RTSChannelRegistry restarted_registry;
+  RTSChannel restarted;
+  add_channel(&restarted_registry, &restarted, 1);
+  CHECK_EQ(restarted.rolling_code(), 103);
+}
+
+RTS_TEST(channel_table_saves_all_channels_in_one_block) {
+  RTSChannelRegistry registry;
+  registry.enable_channel_table();
+  RTSChannel channels[10];
+  for (uint32_t i = 0; i < 10; i++) {
+    add_channel(&registry, &channels[i], i + 1);
+    channels[i].config_channel(0x1000 + i, 100);
+  }
+  // The table is the only store, so nothing gets saved until it is flushed.
+  CHECK(ESPPreferenceObject::records().empty());
+  registry.flush_channel_table();
+  CHECK_EQ(ESPPreferenceObject::saves(), 1u);
+  CHECK_EQ(ESPPreferenceObject::records().size(), 1u);
+  CHECK_EQ(registry.channel_table_blocks(), 1u);
+
+  RTSChannelRegistry restarted_registry;
+  restarted_registry.enable_channel_table();
+  RTSChannel restarted;
+  add_channel(&restarted_registry, &restarted, 4);
+  CHECK_EQ(restarted.id(), 0x1003u);
+  CHECK_EQ(restarted.rolling_code(), 100);
+}
+
+RTS_TEST(channel_moves_from_its_own_record_into_the_table) {
+  {
+    RTSChannelRegistry registry;
+    RTSChannel channel;
+    add_channel(&registry, &channel, 1);
+    channel.config_channel(0x1000, 200);
+  }
+
+  RTSChannelRegistry registry;
+  registry.enable_channel_table();
+  RTSChannel channel;
+  add_channel(&registry, &channel, 1);
+  CHECK_EQ(channel.id(), 0x1000u);
+  CHECK_EQ(channel.rolling_code(), 200);
+  registry.flush_channel_table();
+
+  RTSChannelRegistry restarted_registry;
+  restarted_registry.enable_channel_table();
+  RTSChannel restarted;
+  add_channel(&restarted_registry, &restarted, 1);
+  CHECK_EQ(restarted.rolling_code(), 200);
+}
+
+RTS_TEST(corrupt_table_block_falls_back_to_its_other_copy) {
+  RTSChannelRegistry registry;
+  registry.enable_channel_table();
+  RTSChannel channel;
+  add_channel(&registry, &channel, 1);
+  channel.config_channel(0x1000, 100);
+  registry.flush_channel_table();
+  channel.consume_rolling_code_value();
+  registry.flush_channel_table();
+
+  // Saves alternate between the two copies of the block.
+  uint32_t first_copy = esphome::fnv1_hash("rts_channel_table");
+  uint32_t second_copy = first_copy + esphome::rts::RTSChannelTable::max_blocks;
+  auto &records = ESPPreferenceObject::records();
+  CHECK_EQ(records.count(first_copy), 1u);
+  CHECK_EQ(records.count(second_copy), 1u);
+
+  {
+    RTSChannelRegistry restarted_registry;
+    restarted_registry.enable_channel_table();
+    RTSChannel restarted;
+    add_channel(&restarted_registry, &restarted, 1);
+    CHECK_EQ(restarted.rolling_code(), 101);
+  }
+
+  // A save that got cut short leaves the copy before it, which is the state from before the command
+  // that the save was for went out.
+  records[second_copy].back() ^= 0xff;
+  RTSChannelRegistry restarted_registry;
+  restarted_registry.enable_channel_table();
+  RTSChannel restarted;
+  add_channel(&restarted_registry, &restarted, 1);
+  CHECK_EQ(restarted.id(), 0x1000u);
+  CHECK_EQ(restarted.rolling_code(), 100);
+
+  // The next save overwrites the corrupt copy.
+  restarted.consume_rolling_code_value();
+  restarted_registry.flush_channel_table();
+  RTSChannelRegistry second_registry;
+  second_registry.enable_channel_table();
+  RTSChannel second;
+  add_channel(&second_registry, &second, 1);
+  CHECK_EQ(second.rolling_code(), 101);
+}
+
+RTS_TEST(saved_table_ignores_stale_own_records) {
+  {
+    RTSChannelRegistry registry;
+    RTSChannel channels[2];
+    for (uint32_t i = 0; i < 2; i++) {
+      add_channel(&registry, &channels[i], i + 1);
+      channels[i].config_channel(0x1000 + i, 200);
+    }
+  }
+  {
+    RTSChannelRegistry registry;
+    registry.enable_channel_table();
+    RTSChannel channel;
+    add_channel(&registry, &channel, 1);
+    registry.flush_channel_table();
+  }
+
+  // The second cover joins a table that was already saved, so its own record is not trusted.
+  RTSChannelRegistry registry;
+  registry.enable_channel_table();
+  RTSChannel channels[2];
+  for (uint32_t i = 0; i < 2; i++) {
+    add_channel(&registry, &channels[i], i + 1);
+  }
+  CHECK_EQ(channels[0].rolling_code(), 200);
+  CHECK(channels[1].id() != 0x1001u);
+}
+
+RTS_TEST(registry_keeps_channel_state_compact) {
+  RTSChannelRegistry registry;
+  RTSChannel channels[3];
+  registry.reserve_channels(3);
+  for (uint32_t i = 0; i < 3; i++) {
+    add_channel(&registry, &channels[i], i + 1);
+    channels[i].config_channel(0x1000 + i, 100);
+  }
+  CHECK_EQ(registry.size(), 3u);
+  CHECK_EQ(channels[2].id(), 0x1002u);
+  CHECK(sizeof(RTSChannel) <= 2 * sizeof(void *));
+  CHECK(RTSChannelRegistry::bytes_per_channel() <= 32);
+}
+
+RTS_TEST(update_callback_sees_its_channel_and_the_cause) {
+  RTSChannelRegistry registry;
+  RTSChannel channels[2];
+  struct Update {
+    uint32_t channel_id;
+    uint16_t rolling_code;
+    bool configured;
+  };
+  std::vector<Update> updates;
+  for (uint32_t i = 0; i < 2; i++) {
+    channels[i].set_registry(&registry);
+  }
+  channels[1].add_on_channel_update_callback([&](uint32_t channel_id, uint16_t rolling_code, bool configured) {
+    updates.push_back({channel_id, rolling_code, configured});
+  });
+  for (uint32_t i = 0; i < 2; i++) {
+    channels[i].init(i + 1, "cover");
+    channels[i].config_channel(0x1000 + i, 100);
+  }
+  // A callback added once the channel exists gets bound right away.
+  size_t first_channel_updates = 0;
+  channels[0].add_on_channel_update_callback([&](uint32_t, uint16_t, bool) { first_channel_updates++; });
+  channels[0].consume_rolling_code_value();
+  channels[1].consume_rolling_code_value();
+
+  CHECK_EQ(first_channel_updates, 1u);
+  CHECK_EQ(updates.size(), 2u);
+  if (updates.size() == 2) {
+    CHECK_EQ(updates[0].channel_id, 0x1001u);
+    CHECK(updates[0].configured);
+    CHECK_EQ(updates[1].rolling_code, 101);
+    CHECK(!updates[1].configured);
+  }
+}
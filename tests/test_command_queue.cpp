@@ -0,0 +1,71 @@
+#include "rts_command_queue.h"
+#include "test.h"
+
+using esphome::rts::RTSCommandQueue;
+
+RTS_TEST(command_queue_keeps_order_across_wraparound) {
+  RTSCommandQueue<int> queue;
+  queue.init(4);
+  CHECK(queue.empty());
+
+  int next_in = 0;
+  int next_out = 0;
+  for (int round = 0; round < 10; round++) {
+    while (!queue.full()) {
+      queue.push_back(next_in++);
+    }
+    CHECK_EQ(queue.size(), 4u);
+    queue.pop_front();
+    queue.pop_front();
+    next_out += 2;
+    CHECK_EQ(queue.front(), next_out);
+    CHECK_EQ(queue[1], next_out + 1);
+  }
+}
+
+RTS_TEST(command_queue_inserts_and_erases_in_the_middle) {
+  RTSCommandQueue<int> queue;
+  queue.init(5);
+  queue.push_back(1);
+  queue.push_back(2);
+  queue.pop_front();
+  queue.push_back(3);
+  queue.push_back(4);
+
+  // 2 3 4, starting in the middle of the buffer.
+  queue.insert(0, 10);
+  queue.insert(2, 20);
+  CHECK_EQ(queue.size(), 5u);
+  int expected[] = {10, 2, 20, 3, 4};
+  for (size_t i = 0; i < 5; i++) {
+    CHECK_EQ(queue[i], expected[i]);
+  }
+
+  queue.erase(2);
+  queue.erase(0);
+  CHECK_EQ(queue.size(), 3u);
+  CHECK_EQ(queue[0], 2);
+  CHECK_EQ(queue[1], 3);
+  CHECK_EQ(queue[2], 4);
+}
+
+RTS_TEST(command_queue_rotates_front_behind_group) {
+  RTSCommandQueue<int> queue;
+  queue.init(4);
+  for (int i = 0; i < 4; i++) {
+    queue.push_back(i);
+  }
+
+  queue.rotate_front(3);
+  CHECK_EQ(queue[0], 1);
+  CHECK_EQ(queue[1], 2);
+  CHECK_EQ(queue[2], 0);
+  CHECK_EQ(queue[3], 3);
+
+  // Rotating a single element leaves the queue unchanged.
+  queue.rotate_front(1);
+  CHECK_EQ(queue[0], 1);
+
+  queue.clear();
+  CHECK(queue.empty());
+}
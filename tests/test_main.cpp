@@ -0,0 +1,36 @@
+#include <cstring>
+
+#include "host/host.h"
+#include "test.h"
+
+namespace rts_test {
+
+std::vector<TestCase> &test_cases() {
+  static std::vector<TestCase> test_cases;
+  return test_cases;
+}
+
+int &num_failures() {
+  static int num_failures = 0;
+  return num_failures;
+}
+
+}  // namespace rts_test
+
+// Runs every test, or only those whose names contain the first argument.
+int main(int argc, char **argv) {
+  const char *filter = argc > 1 ? argv[1] : "";
+  int num_run = 0;
+  for (const auto &test_case : rts_test::test_cases()) {
+    if (std::strstr(test_case.name, filter) == nullptr) {
+      continue;
+    }
+    int failures_before = rts_test::num_failures();
+    esphome::host::reset();
+    test_case.run();
+    std::printf("%s %s\n", rts_test::num_failures() == failures_before ? "PASS" : "FAIL", test_case.name);
+    num_run++;
+  }
+  std::printf("%d tests, %d failed checks\n", num_run, rts_test::num_failures());
+  return num_run > 0 && rts_test::num_failures() == 0 ? 0 : 1;
+}
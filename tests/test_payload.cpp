@@ -0,0 +1,184 @@
+#include <iterator>
+
+#include "rts_fixtures.h"
+#include "rts_test_util.h"
+#include "test.h"
+
+using namespace rts_test;
+
+namespace {
+
+// Payloads that cover runs of equal bits, alternating bits, and both edges at byte boundaries.
+const Payload PAYLOADS[] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, {0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff},
+    {0xaa, 0x55, 0xaa, 0x55, 0xaa, 0x55, 0xaa}, {0xa7, 0x1f, 0x80, 0x01, 0x7e, 0x81, 0x3c},
+};
+
+RawTimings fixture(const int32_t *begin, const int32_t *end) { return RawTimings(begin, end); }
+
+std::vector<RTS::ReceivedFrame> decode_all(const RawTimings &timings) {
+  std::vector<RTS::ReceivedFrame> frames;
+  size_t index = 0;
+  RTS::ReceivedFrame frame;
+  while (TestRTS::decode_frame(timings, &index, &frame)) {
+    frames.push_back(frame);
+  }
+  return frames;
+}
+
+}  // namespace
+
+// Payloads worked out by hand from the protocol description, which pin down the reference encoder
+// that the other tests compare against.
+RTS_TEST(reference_payload_matches_worked_examples) {
+  CHECK((reference_payload(RTS::OPEN, 0x1a2b3c, 1234) == Payload{0xa7, 0x8e, 0x8a, 0x58, 0x64, 0x4f, 0x55}));
+  CHECK((reference_payload(RTS::STOP, 0x00f00d, 42) == Payload{0xa7, 0xb1, 0xb1, 0x9b, 0x96, 0x66, 0x66}));
+  CHECK((reference_payload(RTS::CLOSE, 0x123456, 65000) == Payload{0xa7, 0xed, 0x10, 0xf8, 0xae, 0x9a, 0x88}));
+  CHECK((reference_payload(RTS::PROGRAM, 0xabcdef, 7) == Payload{0xa7, 0x24, 0x24, 0x23, 0xcc, 0x01, 0xaa}));
+}
+
+RTS_TEST(payload_encoding_matches_reference) {
+  for (auto control_code : {RTS::STOP, RTS::OPEN, RTS::CLOSE, RTS::PROGRAM}) {
+    for (uint32_t channel_id : {0x000001u, 0x1a2b3cu, 0xffffffu}) {
+      for (uint16_t rolling_code : {1, 0x7fff, 0xffff}) {
+        CHECK(TestRTS::encode_payload(control_code, channel_id, rolling_code) ==
+              reference_payload(control_code, channel_id, rolling_code));
+      }
+    }
+  }
+}
+
+RTS_TEST(encoded_frames_match_protocol_description) {
+  TestRTS rts;
+  for (const auto &payload : PAYLOADS) {
+    for (bool abbreviated_sync : {false, true}) {
+      rts.encode_frame(payload, abbreviated_sync);
+      CHECK(merged(rts.frame_timings()) == reference_frame(payload, abbreviated_sync));
+    }
+  }
+}
+
+RTS_TEST(repetitions_replay_the_first_frame) {
+  Installation installation(2);
+  installation.use_fixed_repetitions(3);
+
+  installation.rts.schedule_rts_command(RTS::OPEN, installation.channel(0));
+  installation.rts.schedule_rts_command(RTS::CLOSE, installation.channel(1));
+  esphome::host::run_until_idle();
+
+  // A wakeup, then 3 identical frames for each command.
+  const auto &transmissions = installation.transmitter.transmissions();
+  CHECK_EQ(transmissions.size(), 7u);
+  if (transmissions.size() == 7) {
+    CHECK(transmissions[2].timings == transmissions[1].timings);
+    CHECK(transmissions[3].timings == transmissions[1].timings);
+    CHECK(transmissions[4].timings != transmissions[3].timings);
+    CHECK(transmissions[6].timings == transmissions[4].timings);
+  }
+}
+
+RTS_TEST(payload_decoding_reverses_encoding) {
+  for (auto control_code : {RTS::STOP, RTS::OPEN, RTS::CLOSE, RTS::PROGRAM}) {
+    for (uint32_t channel_id : {0x000001u, 0x1a2b3cu, 0xffffffu}) {
+      for (uint16_t rolling_code : {1, 0x7fff, 0xffff}) {
+        RTS::ReceivedFrame frame;
+        CHECK(TestRTS::decode_payload(TestRTS::encode_payload(control_code, channel_id, rolling_code), &frame));
+        CHECK_EQ(frame.control_code, control_code);
+        CHECK_EQ(frame.channel_id, channel_id);
+        CHECK_EQ(frame.rolling_code, rolling_code);
+      }
+    }
+  }
+}
+
+RTS_TEST(payload_decoding_rejects_bad_checksum) {
+  // Flipping a bit of the last byte changes only the last byte of the deobfuscated packet. Earlier
+  // bytes also change the byte after them.
+  auto payload = TestRTS::encode_payload(RTS::OPEN, 0x1a2b3c, 1234);
+  RTS::ReceivedFrame frame;
+  for (int bit = 0; bit < 8; bit++) {
+    auto corrupted = payload;
+    corrupted.back() ^= 1 << bit;
+    CHECK(!TestRTS::decode_payload(corrupted, &frame));
+  }
+}
+
+RTS_TEST(decoder_reads_fixture_with_noise_and_jitter) {
+  auto frames = decode_all(fixture(std::begin(fixtures::OPEN_FULL_SYNC), std::end(fixtures::OPEN_FULL_SYNC)));
+  CHECK_EQ(frames.size(), 1u);
+  if (frames.size() == 1) {
+    CHECK_EQ(frames[0].control_code, RTS::OPEN);
+    CHECK_EQ(frames[0].channel_id, 0x1a2b3cu);
+    CHECK_EQ(frames[0].rolling_code, 1234);
+  }
+}
+
+RTS_TEST(decoder_reads_every_frame_of_a_buffer) {
+  auto frames =
+      decode_all(fixture(std::begin(fixtures::CLOSE_THEN_PROGRAM), std::end(fixtures::CLOSE_THEN_PROGRAM)));
+  CHECK_EQ(frames.size(), 2u);
+  if (frames.size() == 2) {
+    CHECK_EQ(frames[0].control_code, RTS::CLOSE);
+    CHECK_EQ(frames[0].channel_id, 0x123456u);
+    CHECK_EQ(frames[0].rolling_code, 65000);
+    CHECK_EQ(frames[1].control_code, RTS::PROGRAM);
+    CHECK_EQ(frames[1].channel_id, 0xabcdefu);
+    CHECK_EQ(frames[1].rolling_code, 7);
+  }
+}
+
+RTS_TEST(decoder_skips_damaged_frames) {
+  auto timings = fixture(std::begin(fixtures::OPEN_FULL_SYNC), std::end(fixtures::OPEN_FULL_SYNC));
+
+  // A frame that breaks off in the middle of its data.
+  RawTimings truncated(timings.begin(), timings.begin() + timings.size() / 2);
+  CHECK(decode_all(truncated).empty());
+
+  // A data edge that moves by a whole half symbol changes the bits, and the checksum with them.
+  auto damaged = timings;
+  for (size_t i = 40; i + 1 < damaged.size(); i++) {
+    if (damaged[i] > 0 && damaged[i] < 900 && damaged[i + 1] < 0 && -damaged[i + 1] > 900) {
+      damaged[i] += 604;
+      damaged[i + 1] += 604;
+      break;
+    }
+  }
+  CHECK(decode_all(damaged).empty());
+}
+
+RTS_TEST(receiver_reports_held_button_once) {
+  TestRTS rts;
+  esphome::remote_base::RemoteReceiverBase receiver;
+  rts.set_receiver(&receiver);
+  std::vector<RTS::ReceivedFrame> received;
+  rts.add_on_frame_received_callback([&received](const RTS::ReceivedFrame &frame) { received.push_back(frame); });
+
+  receiver.receive(fixture(std::begin(fixtures::STOP_REPEATED), std::end(fixtures::STOP_REPEATED)));
+  CHECK_EQ(received.size(), 1u);
+  if (received.size() == 1) {
+    CHECK_EQ(received[0].control_code, RTS::STOP);
+    CHECK_EQ(received[0].channel_id, 0x00f00du);
+    CHECK_EQ(received[0].rolling_code, 42);
+  }
+
+  // The next press has the next rolling code, and gets reported.
+  receiver.receive(fixture(std::begin(fixtures::OPEN_FULL_SYNC), std::end(fixtures::OPEN_FULL_SYNC)));
+  receiver.receive(fixture(std::begin(fixtures::OPEN_FULL_SYNC), std::end(fixtures::OPEN_FULL_SYNC)));
+  CHECK_EQ(received.size(), 2u);
+}
+
+RTS_TEST(decoder_reads_what_the_encoder_sends) {
+  TestRTS rts;
+  for (uint16_t rolling_code = 1; rolling_code < 2000; rolling_code += 37) {
+    for (bool abbreviated_sync : {false, true}) {
+      auto payload = TestRTS::encode_payload(RTS::CLOSE, 0x0b0c0d + rolling_code, rolling_code);
+      rts.encode_frame(payload, abbreviated_sync);
+      auto frames = decode_all(rts.frame_timings());
+      CHECK_EQ(frames.size(), 1u);
+      if (frames.size() == 1) {
+        CHECK_EQ(frames[0].channel_id, 0x0b0c0du + rolling_code);
+        CHECK_EQ(frames[0].rolling_code, rolling_code);
+      }
+    }
+  }
+}
@@ -0,0 +1,791 @@
+#include "rts_test_util.h"
+#include "test.h"
+
+using namespace rts_test;
+using esphome::host::run_for;
+using esphome::host::run_until_idle;
+
+RTS_TEST(command_goes_out_after_wakeup_with_every_repetition) {
+  Installation installation(1);
+  installation.use_fixed_repetitions(4);
+
+  auto handle = installation.rts.schedule_rts_command(RTS::CLOSE, installation.channel(0));
+  CHECK(handle != 0);
+  run_until_idle();
+
+  auto frames = installation.frames();
+  CHECK_EQ(installation.wakeups(), 1u);
+  CHECK_EQ(frames.size(), 4u);
+  for (const auto &frame : frames) {
+    CHECK_EQ(frame.channel_id, Installation::first_channel_id);
+    CHECK_EQ(frame.control_code, RTS::CLOSE);
+    CHECK_EQ(frame.rolling_code, 100);
+    CHECK_EQ(frame.num_hardware_syncs, 2);
+  }
+  CHECK_EQ(installation.channel(0)->rolling_code(), 101);
+
+  auto *result = installation.result_for(handle);
+  CHECK(result != nullptr);
+  if (result != nullptr) {
+    CHECK_EQ(result->result, RTS::COMMAND_TRANSMITTED);
+    CHECK_EQ(result->channel_id, Installation::first_channel_id);
+    CHECK_EQ(result->control_code, RTS::CLOSE);
+  }
+}
+
+RTS_TEST(reported_start_time_is_first_frame) {
+  Installation installation(1);
+  installation.use_fixed_repetitions(2);
+
+  struct Done {
+    bool done;
+    RTS::CommandResult result;
+    uint32_t start_millis;
+  } done{false, RTS::COMMAND_REJECTED, 0};
+  auto on_done = [](void *context, RTS::CommandHandle handle, RTS::CommandResult result, uint32_t start_millis) {
+    auto *done = static_cast<Done *>(context);
+    done->done = true;
+    done->result = result;
+    done->start_millis = start_millis;
+  };
+  uint32_t schedule_millis = esphome::millis();
+  auto handle = installation.rts.schedule_rts_command(RTS::OPEN, installation.channel(0));
+  CHECK(installation.rts.on_command_done(handle, on_done, &done));
+  // Results are reported from the main loop, after scheduling returned.
+  CHECK(!done.done);
+  run_until_idle();
+
+  CHECK(done.done);
+  CHECK_EQ(done.result, RTS::COMMAND_TRANSMITTED);
+  auto frames = installation.frames();
+  CHECK(!frames.empty());
+  if (!frames.empty()) {
+    CHECK_EQ(done.start_millis, frames[0].start_micros / 1000);
+  }
+  // The first frame waits for the wakeup signal and its silence.
+  CHECK(done.start_millis - schedule_millis >= (spec::wakeup_high_micros + spec::wakeup_low_micros) / 1000);
+
+  // Once reported, a handle takes no more callbacks.
+  CHECK(!installation.rts.on_command_done(handle, on_done, &done));
+}
+
+RTS_TEST(pending_command_pool_is_bounded) {
+  // One transmitter with a queue of 2 tracks at most 4 commands whose results were not reported.
+  Installation installation(8, 2);
+  installation.use_fixed_repetitions(2);
+
+  size_t accepted = 0;
+  for (size_t i = 0; i < 8; i++) {
+    accepted += installation.rts.schedule_rts_command(RTS::OPEN, installation.channel(i)) != 0 ? 1 : 0;
+  }
+  CHECK_EQ(accepted, 4u);
+  CHECK_EQ(installation.rts.num_pending_commands(), 4u);
+
+  run_until_idle();
+  CHECK_EQ(installation.rts.num_pending_commands(), 0u);
+  CHECK(installation.rts.schedule_rts_command(RTS::CLOSE, installation.channel(0)) != 0);
+}
+
+RTS_TEST(transmitted_frames_match_protocol_description) {
+  Installation installation(1);
+  installation.use_fixed_repetitions(2);
+
+  installation.rts.schedule_rts_command(RTS::OPEN, installation.channel(0));
+  run_until_idle();
+
+  auto expected = reference_frame(reference_payload(RTS::OPEN, Installation::first_channel_id, 100), true);
+  size_t num_frames = 0;
+  for (const auto &transmission : installation.transmitter.transmissions()) {
+    if (count_wakeups(transmission.timings) == 0) {
+      CHECK(merged(transmission.timings) == expected);
+      num_frames++;
+    }
+  }
+  CHECK_EQ(num_frames, 2u);
+}
+
+RTS_TEST(frames_wait_for_wakeup_silence_and_each_other) {
+  Installation installation(1);
+  installation.use_fixed_repetitions(3);
+
+  installation.rts.schedule_rts_command(RTS::OPEN, installation.channel(0));
+  run_until_idle();
+
+  const auto &transmissions = installation.transmitter.transmissions();
+  CHECK_EQ(transmissions.size(), 4u);
+  for (size_t i = 1; i < transmissions.size(); i++) {
+    uint64_t previous_end = transmissions[i - 1].start_micros + airtime_micros(transmissions[i - 1].timings);
+    uint64_t silence = transmissions[i].start_micros - previous_end;
+    CHECK(silence >= (i == 1 ? 89000u : 30000u));
+    CHECK(silence <= (i == 1 ? 91000u : 32000u));
+  }
+}
+
+RTS_TEST(wakeup_is_skipped_during_cooldown) {
+  Installation installation(2);
+  installation.use_fixed_repetitions(2);
+
+  installation.rts.schedule_rts_command(RTS::OPEN, installation.channel(0));
+  run_for(2000);
+  installation.rts.schedule_rts_command(RTS::OPEN, installation.channel(1));
+  run_for(2000);
+  CHECK_EQ(installation.wakeups(), 1u);
+  CHECK_EQ(installation.rts.wakeups_sent(), 1u);
+  CHECK_EQ(installation.rts.wakeups_skipped(), 1u);
+
+  // Without a wakeup right before it, the first frame needs the full sync.
+  auto frames = installation.frames();
+  CHECK_EQ(frames.size(), 4u);
+  if (frames.size() == 4) {
+    CHECK_EQ(frames[2].num_hardware_syncs, 7);
+    CHECK_EQ(frames[3].num_hardware_syncs, 2);
+  }
+
+  run_for(10000);
+  installation.rts.schedule_rts_command(RTS::OPEN, installation.channel(1));
+  run_until_idle();
+  CHECK_EQ(installation.wakeups(), 2u);
+}
+
+RTS_TEST(queued_commands_go_out_in_order) {
+  Installation installation(3);
+  installation.use_fixed_repetitions(2);
+
+  for (size_t i = 0; i < 3; i++) {
+    installation.rts.schedule_rts_command(RTS::CLOSE, installation.channel(i));
+  }
+  run_until_idle();
+
+  auto frames = installation.frames();
+  CHECK_EQ(installation.wakeups(), 1u);
+  CHECK_EQ(frames.size(), 6u);
+  for (size_t i = 0; i < frames.size(); i++) {
+    CHECK_EQ(frames[i].channel_id, Installation::first_channel_id + i / 2);
+  }
+}
+
+RTS_TEST(newer_command_supersedes_one_that_has_not_started) {
+  Installation installation(1);
+  installation.use_fixed_repetitions(2);
+
+  auto open = installation.rts.schedule_rts_command(RTS::OPEN, installation.channel(0));
+  auto close = installation.rts.schedule_rts_command(RTS::CLOSE, installation.channel(0));
+  run_until_idle();
+
+  // The CLOSE takes the place and the rolling code of the OPEN.
+  auto frames = installation.frames();
+  CHECK_EQ(frames.size(), 2u);
+  for (const auto &frame : frames) {
+    CHECK_EQ(frame.control_code, RTS::CLOSE);
+    CHECK_EQ(frame.rolling_code, 100);
+  }
+  CHECK_EQ(installation.channel(0)->rolling_code(), 101);
+  CHECK_EQ(installation.rts.coalesced_command_count(), 1u);
+
+  auto *open_result = installation.result_for(open);
+  auto *close_result = installation.result_for(close);
+  CHECK(open_result != nullptr && close_result != nullptr);
+  if (open_result != nullptr && close_result != nullptr) {
+    CHECK_EQ(open_result->result, RTS::COMMAND_SUPERSEDED);
+    CHECK_EQ(close_result->result, RTS::COMMAND_TRANSMITTED);
+  }
+}
+
+RTS_TEST(command_that_started_is_not_superseded) {
+  Installation installation(1);
+  installation.use_fixed_repetitions(4);
+
+  installation.rts.schedule_rts_command(RTS::OPEN, installation.channel(0));
+  // The wakeup, its silence and the first frame.
+  run_for(200);
+  installation.rts.schedule_rts_command(RTS::CLOSE, installation.channel(0));
+  run_until_idle();
+
+  auto frames = installation.frames();
+  CHECK_EQ(frames.size(), 8u);
+  if (frames.size() == 8) {
+    CHECK_EQ(frames[3].control_code, RTS::OPEN);
+    CHECK_EQ(frames[4].control_code, RTS::CLOSE);
+    CHECK_EQ(frames[4].rolling_code, 101);
+  }
+  CHECK_EQ(installation.rts.coalesced_command_count(), 0u);
+}
+
+RTS_TEST(stop_cancels_command_that_has_not_started) {
+  Installation installation(1);
+  installation.use_fixed_repetitions(2);
+
+  auto open = installation.rts.schedule_rts_command(RTS::OPEN, installation.channel(0));
+  auto stop = installation.rts.schedule_rts_command(RTS::STOP, installation.channel(0));
+  run_until_idle();
+
+  // The cover never started moving, so neither command goes out, and no rolling code is used up.
+  CHECK(installation.frames().empty());
+  CHECK_EQ(installation.channel(0)->rolling_code(), 101);
+  CHECK_EQ(installation.rts.coalesced_command_count(), 1u);
+
+  auto *open_result = installation.result_for(open);
+  auto *stop_result = installation.result_for(stop);
+  CHECK(open_result != nullptr && stop_result != nullptr);
+  if (open_result != nullptr && stop_result != nullptr) {
+    CHECK_EQ(open_result->result, RTS::COMMAND_SUPERSEDED);
+    CHECK_EQ(stop_result->result, RTS::COMMAND_TRANSMITTED);
+  }
+
+  // Otherwise a STOP is never coalesced: one that is queued does not get rewritten, and one that
+  // follows it goes out too.
+  installation.rts.schedule_rts_command(RTS::STOP, installation.channel(0));
+  installation.rts.schedule_rts_command(RTS::STOP, installation.channel(0));
+  installation.rts.schedule_rts_command(RTS::CLOSE, installation.channel(0));
+  run_until_idle();
+  auto frames = installation.frames();
+  CHECK_EQ(frames.size(), 6u);
+  if (frames.size() == 6) {
+    CHECK_EQ(frames[0].control_code, RTS::STOP);
+    CHECK_EQ(frames[2].control_code, RTS::STOP);
+    CHECK_EQ(frames[4].control_code, RTS::CLOSE);
+  }
+  CHECK_EQ(installation.rts.coalesced_command_count(), 1u);
+}
+
+RTS_TEST(program_commands_are_never_coalesced) {
+  Installation installation(1);
+  installation.use_fixed_repetitions(2);
+
+  installation.rts.schedule_rts_command(RTS::PROGRAM, installation.channel(0));
+  installation.rts.schedule_rts_command(RTS::OPEN, installation.channel(0));
+  installation.rts.schedule_rts_command(RTS::PROGRAM, installation.channel(0));
+  run_until_idle();
+
+  auto frames = installation.frames();
+  CHECK_EQ(frames.size(), 6u);
+  CHECK_EQ(installation.rts.coalesced_command_count(), 0u);
+}
+
+RTS_TEST(stop_preempts_queued_commands_at_next_frame) {
+  Installation installation(10);
+  installation.use_fixed_repetitions(8);
+
+  for (size_t i = 0; i < 10; i++) {
+    installation.rts.schedule_rts_command(RTS::OPEN, installation.channel(i));
+  }
+  // The STOP goes to the channel whose OPEN is going out. One for a channel whose command has not
+  // started would take that command's place instead.
+  run_for(600);
+  uint64_t stop_micros = esphome::host::now_micros();
+  installation.rts.schedule_rts_command(RTS::STOP, installation.channel(0));
+  run_until_idle();
+
+  auto frames = installation.frames();
+  CHECK_EQ(frames.size(), 88u);
+  size_t stop_index = 0;
+  while (stop_index < frames.size() && frames[stop_index].control_code != RTS::STOP) {
+    stop_index++;
+  }
+  CHECK(stop_index < frames.size());
+  if (stop_index + 8 < frames.size()) {
+    // At most the frame that was on air and one inter-frame gap stand between the STOP and the
+    // radio.
+    uint64_t latency_micros = frames[stop_index].start_micros - stop_micros;
+    uint32_t full_frame_micros = airtime_micros(reference_frame(Payload{}, false));
+    CHECK(latency_micros <= 2 * (full_frame_micros + spec::inter_frame_gap_micros));
+
+    // The preempted OPEN resumes with its remaining repetitions before the other channels.
+    for (size_t i = stop_index; i < stop_index + 8; i++) {
+      CHECK_EQ(frames[i].control_code, RTS::STOP);
+    }
+    CHECK_EQ(frames[stop_index + 8].channel_id, Installation::first_channel_id);
+    CHECK_EQ(frames[stop_index + 8].control_code, RTS::OPEN);
+  }
+  CHECK(installation.rts.last_urgent_latency_millis() < 200);
+}
+
+RTS_TEST(urgent_commands_keep_their_order) {
+  Installation installation(3);
+  installation.use_fixed_repetitions(2);
+
+  installation.rts.schedule_rts_command(RTS::OPEN, installation.channel(0));
+  installation.rts.schedule_rts_command(RTS::STOP, installation.channel(1));
+  installation.rts.schedule_rts_command(RTS::STOP, installation.channel(2));
+  run_until_idle();
+
+  auto frames = installation.frames();
+  CHECK_EQ(frames.size(), 6u);
+  if (frames.size() == 6) {
+    CHECK_EQ(frames[0].channel_id, Installation::first_channel_id + 1);
+    CHECK_EQ(frames[2].channel_id, Installation::first_channel_id + 2);
+    CHECK_EQ(frames[4].channel_id, Installation::first_channel_id);
+  }
+}
+
+RTS_TEST(scene_of_thirty_covers_reaches_every_device_first) {
+  const size_t num_covers = 30;
+  Installation installation(num_covers, 32);
+  installation.use_fixed_repetitions(2);
+
+  std::vector<RTSChannel *> channels;
+  for (size_t i = 0; i < num_covers; i++) {
+    channels.push_back(installation.channel(i));
+  }
+  installation.rts.schedule_group_command(RTS::CLOSE, channels);
+  run_until_idle();
+
+  CHECK_EQ(installation.wakeups(), 1u);
+  auto frames = installation.frames();
+  CHECK_EQ(frames.size(), num_covers * 2);
+
+  // Every device gets its first frame before any device gets a repetition, each with its own
+  // rolling code.
+  std::vector<bool> seen(num_covers, false);
+  for (size_t i = 0; i < frames.size() && i < num_covers; i++) {
+    size_t index = frames[i].channel_id - Installation::first_channel_id;
+    CHECK(index < num_covers && !seen[index]);
+    if (index < num_covers) {
+      seen[index] = true;
+    }
+    CHECK_EQ(frames[i].rolling_code, 100);
+    CHECK_EQ(frames[i].num_hardware_syncs, 2);
+  }
+
+  // Every command of the group reports its own result.
+  CHECK_EQ(installation.results.size(), num_covers);
+  for (const auto &result : installation.results) {
+    CHECK_EQ(result.result, RTS::COMMAND_TRANSMITTED);
+  }
+}
+
+RTS_TEST(failed_transmission_is_retried_then_given_up) {
+  Installation installation(2);
+  installation.use_fixed_repetitions(2);
+  installation.rts.set_max_command_retries(2);
+
+  installation.transmitter.fail_next_transmissions(1);
+  auto retried = installation.rts.schedule_rts_command(RTS::OPEN, installation.channel(0));
+  run_until_idle();
+  auto *retried_result = installation.result_for(retried);
+  CHECK(retried_result != nullptr);
+  if (retried_result != nullptr) {
+    CHECK_EQ(retried_result->result, RTS::COMMAND_TRANSMITTED);
+  }
+  // The retry reuses the rolling code value.
+  for (const auto &frame : installation.frames()) {
+    CHECK_EQ(frame.rolling_code, 100);
+  }
+
+  installation.transmitter.fail_next_transmissions(100);
+  auto cancelled = installation.rts.schedule_rts_command(RTS::OPEN, installation.channel(1));
+  run_until_idle();
+  auto *cancelled_result = installation.result_for(cancelled);
+  CHECK(cancelled_result != nullptr);
+  if (cancelled_result != nullptr) {
+    CHECK_EQ(cancelled_result->result, RTS::COMMAND_CANCELLED);
+  }
+  CHECK_EQ(installation.rts.cancelled_command_count(), 1u);
+}
+
+RTS_TEST(retry_waits_behind_commands_for_other_channels) {
+  Installation installation(2);
+  installation.use_fixed_repetitions(2);
+  installation.rts.set_retry_backoff(1000);
+
+  // The wakeup fails, which sends the first command behind the second.
+  installation.transmitter.fail_next_transmissions(1);
+  auto first = installation.rts.schedule_rts_command(RTS::OPEN, installation.channel(0));
+  auto second = installation.rts.schedule_rts_command(RTS::OPEN, installation.channel(1));
+  run_until_idle();
+
+  auto frames = installation.frames();
+  CHECK_EQ(frames.size(), 4u);
+  if (frames.size() == 4) {
+    CHECK_EQ(frames[0].channel_id, Installation::first_channel_id + 1);
+    CHECK_EQ(frames[3].channel_id, Installation::first_channel_id);
+  }
+  auto *first_result = installation.result_for(first);
+  auto *second_result = installation.result_for(second);
+  CHECK(first_result != nullptr && second_result != nullptr);
+  if (first_result != nullptr && second_result != nullptr) {
+    CHECK_EQ(first_result->result, RTS::COMMAND_TRANSMITTED);
+    CHECK_EQ(second_result->result, RTS::COMMAND_TRANSMITTED);
+    CHECK(first_result->done_millis > second_result->done_millis);
+  }
+}
+
+RTS_TEST(group_without_wakeup_starts_with_full_sync) {
+  Installation installation(3);
+  installation.use_fixed_repetitions(1);
+
+  installation.rts.schedule_rts_command(RTS::OPEN, installation.channel(0));
+  run_for(2000);
+  installation.transmitter.clear_transmissions();
+
+  // Devices are still awake, so no wakeup precedes the group.
+  installation.rts.schedule_group_command(RTS::CLOSE, {installation.channel(0), installation.channel(1),
+                                                       installation.channel(2)});
+  run_for(2000);
+  auto frames = installation.frames();
+  CHECK_EQ(installation.wakeups(), 0u);
+  CHECK_EQ(frames.size(), 3u);
+  for (size_t i = 0; i < frames.size(); i++) {
+    CHECK_EQ(frames[i].num_hardware_syncs, i == 0 ? 7 : 2);
+  }
+}
+
+RTS_TEST(frame_after_retry_wait_gets_full_sync) {
+  Installation installation(1);
+  installation.use_fixed_repetitions(2);
+
+  // The wakeup and the first frame go out, the second frame fails, and its retry follows a wait
+  // rather than a frame.
+  installation.rts.schedule_rts_command(RTS::OPEN, installation.channel(0));
+  run_for(100);
+  installation.transmitter.fail_next_transmissions(1);
+  run_until_idle();
+
+  auto frames = installation.frames();
+  CHECK_EQ(frames.size(), 2u);
+  if (frames.size() == 2) {
+    CHECK_EQ(frames[0].num_hardware_syncs, 2);
+    CHECK_EQ(frames[1].num_hardware_syncs, 7);
+  }
+}
+
+RTS_TEST(full_queue_rejects_new_commands) {
+  Installation installation(6, 4);
+  installation.use_fixed_repetitions(2);
+
+  std::vector<RTS::CommandHandle> handles;
+  for (size_t i = 0; i < 6; i++) {
+    handles.push_back(installation.rts.schedule_rts_command(RTS::OPEN, installation.channel(i)));
+  }
+  run_until_idle();
+
+  auto frames = installation.frames();
+  CHECK_EQ(frames.size(), 8u);
+  for (const auto &frame : frames) {
+    CHECK(frame.channel_id < Installation::first_channel_id + 4);
+  }
+  CHECK_EQ(installation.rts.queue_overflow_count(), 2u);
+  for (size_t i = 0; i < handles.size(); i++) {
+    auto *result = installation.result_for(handles[i]);
+    CHECK(result != nullptr);
+    if (result != nullptr) {
+      CHECK_EQ(result->result, i < 4 ? RTS::COMMAND_TRANSMITTED : RTS::COMMAND_REJECTED);
+    }
+  }
+  // Rejected commands burn no rolling code.
+  CHECK_EQ(installation.channel(5)->rolling_code(), 100);
+}
+
+RTS_TEST(full_queue_drops_oldest_for_new_commands) {
+  Installation installation(6, 4);
+  installation.use_fixed_repetitions(2);
+  installation.rts.set_queue_overflow_policy(RTS::OVERFLOW_DROP_OLDEST);
+
+  std::vector<RTS::CommandHandle> handles;
+  for (size_t i = 0; i < 6; i++) {
+    handles.push_back(installation.rts.schedule_rts_command(RTS::OPEN, installation.channel(i)));
+  }
+  run_until_idle();
+
+  auto frames = installation.frames();
+  CHECK_EQ(frames.size(), 8u);
+  for (const auto &frame : frames) {
+    CHECK(frame.channel_id >= Installation::first_channel_id + 2);
+  }
+  CHECK_EQ(installation.rts.queue_overflow_count(), 2u);
+  for (size_t i = 0; i < handles.size(); i++) {
+    auto *result = installation.result_for(handles[i]);
+    CHECK(result != nullptr);
+    if (result != nullptr) {
+      CHECK_EQ(result->result, i < 2 ? RTS::COMMAND_DROPPED : RTS::COMMAND_TRANSMITTED);
+    }
+  }
+}
+
+RTS_TEST(urgent_command_displaces_queued_command_from_full_queue) {
+  Installation installation(5, 4);
+  installation.use_fixed_repetitions(2);
+
+  for (size_t i = 0; i < 4; i++) {
+    installation.rts.schedule_rts_command(RTS::OPEN, installation.channel(i));
+  }
+  installation.rts.schedule_rts_command(RTS::STOP, installation.channel(4));
+  run_until_idle();
+
+  auto frames = installation.frames();
+  CHECK_EQ(frames.size(), 8u);
+  if (!frames.empty()) {
+    CHECK_EQ(frames[0].control_code, RTS::STOP);
+  }
+  CHECK_EQ(installation.rts.queue_overflow_count(), 1u);
+}
+
+RTS_TEST(burst_sends_wakeup_and_repetitions_in_one_transmission) {
+  Installation installation(2);
+  installation.use_fixed_repetitions(3);
+  installation.rts.set_burst_transmit(true);
+
+  installation.rts.schedule_rts_command(RTS::OPEN, installation.channel(0));
+  installation.rts.schedule_rts_command(RTS::CLOSE, installation.channel(1));
+  run_until_idle();
+
+  // The second command directly follows the first, so it needs no wakeup or full sync of its own.
+  const auto &transmissions = installation.transmitter.transmissions();
+  CHECK_EQ(transmissions.size(), 2u);
+  CHECK_EQ(installation.wakeups(), 1u);
+  auto frames = installation.frames();
+  CHECK_EQ(frames.size(), 6u);
+  for (size_t i = 0; i < frames.size(); i++) {
+    CHECK_EQ(frames[i].control_code, i < 3 ? RTS::OPEN : RTS::CLOSE);
+    CHECK_EQ(frames[i].num_hardware_syncs, 2);
+  }
+
+  // Frames of a burst are spaced by the inter-frame gap.
+  uint32_t frame_micros = airtime_micros(reference_frame(Payload{}, true));
+  for (size_t i = 1; i < 3 && i < frames.size(); i++) {
+    uint64_t gap = frames[i].start_micros - frames[i - 1].start_micros - frame_micros;
+    CHECK(gap >= 30000 && gap <= 31000);
+  }
+}
+
+RTS_TEST(statistics_follow_transmitted_frames) {
+  Installation installation(3);
+  installation.use_fixed_repetitions(2);
+
+  uint64_t schedule_micros = esphome::host::now_micros();
+  for (size_t i = 0; i < 3; i++) {
+    installation.rts.schedule_rts_command(RTS::OPEN, installation.channel(i));
+  }
+  run_until_idle();
+
+  auto frames = installation.frames();
+  CHECK_EQ(frames.size(), 6u);
+  if (frames.size() == 6) {
+    CHECK_EQ(installation.rts.command_latency_millis(50), (frames[2].start_micros - schedule_micros) / 1000);
+    CHECK_EQ(installation.rts.command_latency_millis(100), (frames[4].start_micros - schedule_micros) / 1000);
+  }
+  CHECK_EQ(installation.rts.command_airtime_micros(), 2 * airtime_micros(reference_frame(Payload{}, true)));
+  CHECK_EQ(installation.rts.wakeups_sent(), 1u);
+  // The first command's frames went out with all three commands queued.
+  CHECK_EQ(installation.rts.peak_queue_depth(), 3u);
+}
+
+RTS_TEST(repetitions_adapt_to_queue_length) {
+  Installation installation(5);
+  installation.rts.set_command_repetitions(3);
+  installation.rts.set_min_command_repetitions(1);
+  installation.rts.set_max_command_repetitions(5);
+
+  // An idle transmitter gives the first command the maximum, each further command loses one
+  // repetition per command ahead of it, and an urgent command keeps command_repetitions.
+  for (size_t i = 0; i < 4; i++) {
+    installation.rts.schedule_rts_command(RTS::CLOSE, installation.channel(i));
+  }
+  installation.rts.schedule_rts_command(RTS::STOP, installation.channel(4));
+  run_until_idle();
+
+  size_t counts[5] = {};
+  for (const auto &frame : installation.frames()) {
+    counts[frame.channel_id - Installation::first_channel_id]++;
+  }
+  CHECK_EQ(counts[0], 5u);
+  CHECK_EQ(counts[1], 2u);
+  CHECK_EQ(counts[2], 1u);
+  CHECK_EQ(counts[3], 1u);
+  CHECK_EQ(counts[4], 3u);
+}
+
+RTS_TEST(adapted_repetitions_stay_within_callers_limit) {
+  Installation installation(1);
+  installation.rts.set_command_repetitions(2);
+  installation.rts.set_min_command_repetitions(1);
+  installation.rts.set_max_command_repetitions(5);
+
+  // An idle transmitter would raise the command to 5 repetitions, but its caller allows 3.
+  installation.rts.schedule_rts_command(RTS::CLOSE, installation.channel(0), 3);
+  run_until_idle();
+  CHECK_EQ(installation.frames().size(), 3u);
+}
+
+RTS_TEST(airtime_budget_limits_transmissions_per_window) {
+  Installation installation(20, 32);
+  installation.use_fixed_repetitions(2);
+  installation.rts.set_airtime_budget(5, 16000);
+
+  for (size_t i = 0; i < 20; i++) {
+    installation.rts.schedule_rts_command(RTS::CLOSE, installation.channel(i));
+  }
+  run_for(16000);
+  uint32_t first_window_micros = 0;
+  for (const auto &transmission : installation.transmitter.transmissions()) {
+    first_window_micros += airtime_micros(transmission.timings);
+  }
+  // The last transmission that the budget allowed may end a little beyond it.
+  uint32_t full_frame_micros = airtime_micros(reference_frame(Payload{}, false));
+  CHECK(first_window_micros <= 800000 + full_frame_micros);
+  CHECK(installation.frames().size() < 40);
+
+  run_until_idle();
+  CHECK_EQ(installation.frames().size(), 40u);
+}
+
+RTS_TEST(urgent_command_cuts_short_an_airtime_budget_wait) {
+  Installation installation(20, 32);
+  installation.use_fixed_repetitions(2);
+  installation.rts.set_airtime_budget(5, 16000);
+
+  for (size_t i = 0; i < 19; i++) {
+    installation.rts.schedule_rts_command(RTS::CLOSE, installation.channel(i));
+  }
+  run_for(1500);
+  size_t num_frames = installation.frames().size();
+  CHECK(num_frames < 38);
+
+  // The budget is used up until its oldest bucket expires, but a STOP goes out right away.
+  uint64_t stop_micros = esphome::host::now_micros();
+  installation.rts.schedule_rts_command(RTS::STOP, installation.channel(19));
+  run_for(500);
+  auto frames = installation.frames();
+  CHECK(frames.size() > num_frames);
+  CHECK(frames.size() > num_frames && frames[num_frames].control_code == RTS::STOP);
+  CHECK(frames.size() > num_frames && frames[num_frames].start_micros - stop_micros < 200000);
+
+  run_until_idle();
+  CHECK_EQ(installation.frames().size(), 40u);
+}
+
+RTS_TEST(every_transmitter_sends_with_the_same_rolling_code) {
+  Installation installation(2);
+  installation.use_fixed_repetitions(2);
+  RemoteTransmitterComponent second;
+  installation.rts.add_transmitter(&second);
+  installation.channel(1)->set_transmitter_mask(installation.rts.transmitter_mask({&second}));
+
+  installation.rts.schedule_rts_command(RTS::OPEN, installation.channel(0));
+  installation.rts.schedule_rts_command(RTS::CLOSE, installation.channel(1));
+  run_until_idle();
+
+  std::vector<Frame> second_frames;
+  for (const auto &transmission : second.transmissions()) {
+    decode_frames(transmission.timings, transmission.start_micros, &second_frames);
+  }
+  auto frames = installation.frames();
+  CHECK_EQ(frames.size(), 2u);
+  CHECK_EQ(second_frames.size(), 4u);
+  for (const auto &frame : frames) {
+    CHECK_EQ(frame.control_code, RTS::OPEN);
+    CHECK_EQ(frame.rolling_code, 100);
+  }
+  if (second_frames.size() == 4) {
+    CHECK_EQ(second_frames[0].control_code, RTS::OPEN);
+    CHECK_EQ(second_frames[0].rolling_code, 100);
+    CHECK_EQ(second_frames[2].control_code, RTS::CLOSE);
+  }
+  CHECK_EQ(installation.channel(0)->rolling_code(), 101);
+}
+
+RTS_TEST(boot_restore_sends_rate_limited_batches) {
+  Installation installation(20, 32);
+  installation.use_fixed_repetitions(1);
+  uint64_t boot_micros = esphome::host::now_micros();
+  for (size_t i = 0; i < 20; i++) {
+    installation.rts.queue_boot_restore(i % 2 == 0 ? RTS::OPEN : RTS::CLOSE, installation.channel(i));
+  }
+
+  // Nothing goes out, and no rolling code gets used, before the delay.
+  run_for(4900);
+  CHECK(installation.transmitter.transmissions().empty());
+  CHECK_EQ(installation.channel(0)->rolling_code(), 100);
+
+  run_until_idle();
+  auto frames = installation.frames();
+  CHECK_EQ(frames.size(), 20u);
+  for (size_t i = 0; i < frames.size(); i++) {
+    size_t index = frames[i].channel_id - Installation::first_channel_id;
+    CHECK_EQ(frames[i].control_code, index % 2 == 0 ? RTS::OPEN : RTS::CLOSE);
+    CHECK_EQ(frames[i].rolling_code, 100);
+    // Batches of 8 channels start 5 s after boot, then every 2 s.
+    uint64_t batch_micros = boot_micros + 5000000 + i / 8 * 2000000;
+    CHECK(frames[i].start_micros >= batch_micros);
+    CHECK(frames[i].start_micros < batch_micros + 2000000);
+  }
+}
+
+RTS_TEST(prewake_spares_commands_the_wakeup_delay) {
+  Installation installation(1);
+  installation.use_fixed_repetitions(2);
+
+  installation.rts.prewake();
+  run_for(1000);
+  CHECK_EQ(installation.wakeups(), 1u);
+  CHECK_EQ(installation.rts.prewakes_sent(), 1u);
+
+  uint32_t schedule_millis = esphome::millis();
+  installation.rts.schedule_rts_command(RTS::OPEN, installation.channel(0));
+  run_for(1000);
+
+  // The command goes out right away, without a wakeup of its own.
+  auto frames = installation.frames();
+  CHECK_EQ(frames.size(), 2u);
+  CHECK_EQ(installation.wakeups(), 1u);
+  if (!frames.empty()) {
+    CHECK(frames[0].start_micros / 1000 - schedule_millis < 10);
+  }
+  CHECK(installation.rts.prewake_latency_saved_millis() >= (spec::wakeup_high_micros + spec::wakeup_low_micros) / 1000);
+
+  // Only the first command after a prewake counts as sparing a wakeup.
+  uint32_t saved_millis = installation.rts.prewake_latency_saved_millis();
+  installation.rts.schedule_rts_command(RTS::CLOSE, installation.channel(0));
+  run_for(1000);
+  CHECK_EQ(installation.rts.prewake_latency_saved_millis(), saved_millis);
+
+  // The prewake gets renewed until the hold ends, and no longer.
+  run_for(60000);
+  CHECK_EQ(installation.rts.prewakes_sent(), 4u);
+  run_for(60000);
+  CHECK_EQ(installation.rts.prewakes_sent(), 4u);
+}
+
+RTS_TEST(hold_command_streams_frames_with_one_rolling_code) {
+  Installation installation(2);
+  installation.use_fixed_repetitions(2);
+
+  uint64_t start_micros = esphome::host::now_micros();
+  installation.rts.schedule_hold_command(RTS::OPEN, installation.channel(0), 6);
+  // Nothing goes out between the parts of the stream, not even an urgent command for another cover.
+  run_for(200);
+  installation.rts.schedule_rts_command(RTS::STOP, installation.channel(1));
+  run_until_idle();
+
+  auto frames = installation.frames();
+  CHECK_EQ(frames.size(), 8u);
+  for (size_t i = 0; i < frames.size() && i < 6; i++) {
+    CHECK_EQ(frames[i].channel_id, Installation::first_channel_id);
+    CHECK_EQ(frames[i].rolling_code, 100);
+    // Only the first frame gets full sync, even right after the wakeup.
+    CHECK_EQ(frames[i].num_hardware_syncs, i == 0 ? 7 : 2);
+  }
+
+  // Frames follow each other at the hold period, whether or not they share a transmission. The
+  // component rounds the inter-frame gap to whole milliseconds.
+  auto payload = reference_payload(RTS::OPEN, Installation::first_channel_id, 100);
+  uint32_t first_period = airtime_micros(reference_frame(payload, false)) + spec::inter_frame_gap_micros;
+  uint32_t period = airtime_micros(reference_frame(payload, true)) + spec::inter_frame_gap_micros;
+  for (size_t i = 1; i < frames.size() && i < 6; i++) {
+    uint32_t spacing = frames[i].start_micros - frames[i - 1].start_micros;
+    uint32_t expected = i == 1 ? first_period : period;
+    CHECK(spacing + 1000 >= expected);
+    CHECK(spacing <= expected + 1000);
+  }
+
+  // The stream lasts as long as the component reports, from its first frame until the end of the
+  // gap after its last one, which is when the STOP goes out.
+  if (frames.size() == 8) {
+    uint32_t duration_millis = (frames[6].start_micros - frames[0].start_micros) / 1000;
+    CHECK(duration_millis >= RTS::hold_duration_millis(6));
+    CHECK(duration_millis <= RTS::hold_duration_millis(6) + 3);
+    CHECK(frames[0].start_micros - start_micros < 200000);
+  }
+  CHECK_EQ(RTS::hold_frames_for(RTS::hold_duration_millis(6)), 6);
+  CHECK_EQ(RTS::hold_frames_for(RTS::hold_duration_millis(1)), 1);
+}
@@ -0,0 +1,63 @@
+#include <thread>
+
+#include "rts_spsc_queue.h"
+#include "test.h"
+
+using esphome::rts::RTSSpscQueue;
+
+RTS_TEST(spsc_queue_keeps_order_and_reports_full) {
+  RTSSpscQueue<int> queue;
+  queue.init(3);
+  int value = -1;
+  CHECK(!queue.pop(value));
+
+  // The slots get reused as the queue wraps around.
+  int next_push = 0;
+  int next_pop = 0;
+  for (int round = 0; round < 4; round++) {
+    while (queue.push(next_push)) {
+      next_push++;
+    }
+    CHECK_EQ(next_push - next_pop, 3);
+    CHECK(queue.pop(value));
+    CHECK_EQ(value, next_pop++);
+    CHECK(queue.pop(value));
+    CHECK_EQ(value, next_pop++);
+  }
+  while (queue.pop(value)) {
+    CHECK_EQ(value, next_pop++);
+  }
+  CHECK_EQ(next_pop, next_push);
+}
+
+RTS_TEST(spsc_queue_hands_every_element_across_threads_in_order) {
+  static constexpr int num_elements = 200000;
+  RTSSpscQueue<int> queue;
+  queue.init(16);
+
+  std::thread producer([&queue]() {
+    for (int i = 0; i < num_elements;) {
+      if (queue.push(i)) {
+        i++;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  int expected = 0;
+  int num_out_of_order = 0;
+  while (expected < num_elements) {
+    int value = -1;
+    if (!queue.pop(value)) {
+      std::this_thread::yield();
+      continue;
+    }
+    num_out_of_order += value != expected ? 1 : 0;
+    expected++;
+  }
+  producer.join();
+  CHECK_EQ(num_out_of_order, 0);
+  int value = -1;
+  CHECK(!queue.pop(value));
+}
@@ -0,0 +1,151 @@
+#include <cstdio>
+
+#include "rts_test_util.h"
+#include "rts_timing.h"
+#include "test.h"
+
+using namespace rts_test;
+using esphome::rts::compensated_mark_micros;
+using esphome::rts::compensated_space_micros;
+using esphome::rts::RTSRoundedTiming;
+using esphome::rts::RTSSpecTiming;
+using esphome::rts::RTSTimingTables;
+
+namespace {
+
+// Payloads that cover runs of equal bits, alternating bits, and both edges at byte boundaries.
+const Payload PAYLOADS[] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, {0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff},
+    {0xaa, 0x55, 0xaa, 0x55, 0xaa, 0x55, 0xaa}, {0xa7, 0x1f, 0x80, 0x01, 0x7e, 0x81, 0x3c},
+};
+
+// Every item of an encoded frame, as the transmitter puts it on air, must be within the tolerance
+// of the item that the protocol description gives at the same position.
+template<typename Profile> void check_frames_within_spec(int32_t mark_overhead_micros) {
+  using Tables = RTSTimingTables<Profile>;
+  for (const auto &payload : PAYLOADS) {
+    for (bool abbreviated_sync : {false, true}) {
+      RawTimings encoded;
+      Tables::encode_frame(payload, abbreviated_sync, mark_overhead_micros, &encoded);
+      RawTimings on_air = apply_mark_overhead(encoded, mark_overhead_micros);
+      RawTimings expected = reference_frame(payload, abbreviated_sync);
+
+      CHECK_EQ(on_air.size(), expected.size());
+      for (size_t i = 0; i < on_air.size() && i < expected.size(); i++) {
+        CHECK((on_air[i] > 0) == (expected[i] > 0));
+        if (!Tables::within_spec(duration_micros(on_air[i]), duration_micros(expected[i]))) {
+          std::printf("item %zu: %u us, spec %u us\n", i, duration_micros(on_air[i]), duration_micros(expected[i]));
+          CHECK(Tables::within_spec(duration_micros(on_air[i]), duration_micros(expected[i])));
+        }
+      }
+    }
+  }
+}
+
+}  // namespace
+
+RTS_TEST(spec_profile_matches_protocol_description) {
+  CHECK_EQ(RTSSpecTiming::wakeup_high_micros, spec::wakeup_high_micros);
+  CHECK_EQ(RTSSpecTiming::wakeup_low_micros, spec::wakeup_low_micros);
+  CHECK_EQ(RTSSpecTiming::inter_frame_gap_micros, spec::inter_frame_gap_micros);
+  for (const auto &payload : PAYLOADS) {
+    for (bool abbreviated_sync : {false, true}) {
+      RawTimings encoded;
+      RTSTimingTables<RTSSpecTiming>::encode_frame(payload, abbreviated_sync, 0, &encoded);
+      CHECK(encoded == reference_frame(payload, abbreviated_sync));
+    }
+  }
+}
+
+RTS_TEST(encoded_frames_alternate_marks_and_spaces) {
+  for (const auto &payload : PAYLOADS) {
+    RawTimings encoded;
+    RTSTimingTables<RTSSpecTiming>::encode_frame(payload, false, 0, &encoded);
+    CHECK(encoded.front() > 0);
+    for (size_t i = 1; i < encoded.size(); i++) {
+      CHECK((encoded[i] > 0) != (encoded[i - 1] > 0));
+    }
+  }
+}
+
+RTS_TEST(emitted_timings_stay_within_spec_tolerance) {
+  check_frames_within_spec<RTSSpecTiming>(0);
+  check_frames_within_spec<RTSRoundedTiming>(0);
+}
+
+RTS_TEST(compensated_timings_stay_within_spec_tolerance_on_air) {
+  for (int32_t overhead : {-60, -12, 25, 80, 150}) {
+    check_frames_within_spec<RTSSpecTiming>(overhead);
+    check_frames_within_spec<RTSRoundedTiming>(overhead);
+  }
+}
+
+RTS_TEST(compensation_never_reaches_zero) {
+  CHECK_EQ(compensated_mark_micros(100, 40), 60u);
+  CHECK_EQ(compensated_mark_micros(30, 40), 1u);
+  CHECK_EQ(compensated_space_micros(100, -40), 60u);
+  CHECK_EQ(compensated_space_micros(30, -40), 1u);
+  CHECK_EQ(compensated_mark_micros(100, -40), 140u);
+}
+
+RTS_TEST(frame_airtime_matches_encoded_frame) {
+  using Tables = RTSTimingTables<RTSSpecTiming>;
+  for (bool abbreviated_sync : {false, true}) {
+    RawTimings encoded;
+    Tables::encode_frame(PAYLOADS[3], abbreviated_sync, 0, &encoded);
+    CHECK_EQ(airtime_micros(encoded), Tables::frame_airtime_micros(abbreviated_sync ? 2 : 7, 7));
+  }
+}
+
+RTS_TEST(loop_delays_round_up_to_whole_milliseconds) {
+  using Tables = RTSTimingTables<RTSSpecTiming>;
+  CHECK_EQ(Tables::loop_delay_millis(RTSSpecTiming::wakeup_low_micros), 90u);
+  CHECK_EQ(Tables::loop_delay_millis(RTSSpecTiming::inter_frame_gap_micros), 31u);
+  CHECK_EQ(Tables::loop_delay_millis(RTSRoundedTiming::wakeup_low_micros), 90u);
+  CHECK_EQ(Tables::loop_delay_millis(RTSRoundedTiming::inter_frame_gap_micros), 30u);
+  CHECK_EQ(Tables::loop_delay_millis(1), 1u);
+  CHECK_EQ(Tables::loop_delay_millis(0), 0u);
+}
+
+// Transmits a command through the scheduler, on a transmitter calibrated for its mark overhead,
+// and checks what goes on air.
+RTS_TEST(scheduled_command_goes_on_air_within_spec) {
+  const int32_t overhead = 45;
+  Installation installation(1);
+  installation.use_fixed_repetitions(3);
+  installation.rts.set_mark_overhead(&installation.transmitter, overhead);
+
+  installation.rts.schedule_rts_command(RTS::OPEN, installation.channel(0));
+  esphome::host::run_until_idle();
+
+  const auto &transmissions = installation.transmitter.transmissions();
+  CHECK_EQ(transmissions.size(), 4u);
+  if (transmissions.size() != 4) {
+    return;
+  }
+
+  // The wakeup mark, then each frame followed by the inter-frame gap.
+  auto wakeup = apply_mark_overhead(transmissions[0].timings, overhead);
+  CHECK_EQ(wakeup.size(), 1u);
+  CHECK(TestRTS::Timing::within_spec(wakeup[0], spec::wakeup_high_micros));
+
+  auto payload = reference_payload(RTS::OPEN, Installation::first_channel_id, 100);
+  uint64_t previous_end = transmissions[0].start_micros + transmissions[0].timings[0];
+  for (size_t i = 1; i < transmissions.size(); i++) {
+    const auto &transmission = transmissions[i];
+    uint64_t silence = transmission.start_micros - previous_end;
+    // Silences never get shorter than the spec, since the loop rounds them up.
+    uint32_t spec_silence = i == 1 ? spec::wakeup_low_micros : spec::inter_frame_gap_micros;
+    CHECK(silence >= spec_silence);
+    CHECK(TestRTS::Timing::within_spec(silence, spec_silence));
+
+    // The wakeup and the previous frame each let the next frame use abbreviated sync.
+    auto on_air = apply_mark_overhead(transmission.timings, overhead);
+    auto expected = reference_frame(payload, true);
+    CHECK_EQ(on_air.size(), expected.size());
+    for (size_t j = 0; j < on_air.size() && j < expected.size(); j++) {
+      CHECK(TestRTS::Timing::within_spec(duration_micros(on_air[j]), duration_micros(expected[j])));
+    }
+    previous_end = transmission.start_micros + airtime_micros(transmission.timings);
+  }
+}
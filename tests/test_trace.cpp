@@ -0,0 +1,59 @@
+#include "rts_test_util.h"
+#include "rts_trace.h"
+#include "test.h"
+
+using namespace rts_test;
+using esphome::host::run_until_idle;
+using esphome::rts::RTSTraceBuffer;
+
+RTS_TEST(trace_keeps_the_most_recent_entries) {
+  RTSTraceBuffer trace;
+  trace.init(4);
+  for (uint16_t i = 0; i < 10; i++) {
+    RTSTraceBuffer::Entry entry{};
+    entry.rolling_code = i;
+    trace.record(entry);
+  }
+  CHECK_EQ(trace.num_recorded(), 10u);
+
+  std::vector<uint16_t> rolling_codes;
+  trace.for_each([&](const RTSTraceBuffer::Entry &entry) { rolling_codes.push_back(entry.rolling_code); });
+  CHECK(rolling_codes == std::vector<uint16_t>({6, 7, 8, 9}));
+}
+
+RTS_TEST(trace_without_storage_records_nothing) {
+  RTSTraceBuffer trace;
+  trace.init(0);
+  trace.record(RTSTraceBuffer::Entry{});
+  CHECK_EQ(trace.num_recorded(), 0u);
+}
+
+RTS_TEST(trace_records_every_transmitted_frame) {
+  Installation installation(2);
+  installation.use_fixed_repetitions(3);
+  installation.rts.set_trace_size(16);
+
+  installation.rts.schedule_rts_command(RTS::OPEN, installation.channel(0));
+  installation.rts.schedule_rts_command(RTS::CLOSE, installation.channel(1));
+  run_until_idle();
+
+  std::vector<RTSTraceBuffer::Entry> entries;
+  installation.rts.trace(0).for_each([&](const RTSTraceBuffer::Entry &entry) { entries.push_back(entry); });
+  auto frames = installation.frames();
+  // The wakeup, followed by every frame.
+  CHECK_EQ(entries.size(), frames.size() + 1);
+  if (entries.size() == frames.size() + 1) {
+    CHECK_EQ(entries[0].kind, RTSTraceBuffer::FRAME_WAKEUP);
+    for (size_t i = 0; i < frames.size(); i++) {
+      const auto &entry = entries[i + 1];
+      CHECK_EQ(entry.channel_id, frames[i].channel_id);
+      CHECK_EQ(entry.control_code, frames[i].control_code);
+      CHECK_EQ(entry.rolling_code, frames[i].rolling_code);
+      CHECK_EQ(entry.repetition, i % 3);
+      CHECK_EQ(entry.num_repetitions, 3);
+      CHECK_EQ(entry.millis, frames[i].start_micros / 1000);
+      CHECK_EQ(entry.kind, frames[i].num_hardware_syncs == 2 ? RTSTraceBuffer::FRAME_ABBREVIATED_SYNC
+                                                             : RTSTraceBuffer::FRAME_FULL_SYNC);
+    }
+  }
+}
@@ -0,0 +1,223 @@
+#include "rts_test_util.h"
+#include "test.h"
+
+// The same scheduling as in test_scheduler.cpp, with USE_RTS_TRANSMIT_TASK: commands get built on
+// the main loop and handed to a transmit task thread, which owns the queue, paces the frames with
+// delay() and hands the results back.
+using namespace rts_test;
+using esphome::ESPPreferenceObject;
+using esphome::host::run_for;
+using esphome::host::run_until_idle;
+
+RTS_TEST(task_sends_command_after_wakeup_and_reports_it) {
+  Installation installation(1);
+  installation.use_fixed_repetitions(4);
+
+  uint64_t schedule_micros = esphome::host::now_micros();
+  auto handle = installation.rts.schedule_rts_command(RTS::CLOSE, installation.channel(0));
+  CHECK(handle != 0);
+  run_until_idle();
+
+  auto frames = installation.frames();
+  CHECK_EQ(installation.wakeups(), 1u);
+  CHECK_EQ(frames.size(), 4u);
+  for (const auto &frame : frames) {
+    CHECK_EQ(frame.control_code, RTS::CLOSE);
+    CHECK_EQ(frame.rolling_code, 100);
+  }
+  if (!frames.empty()) {
+    CHECK(frames[0].start_micros - schedule_micros >= spec::wakeup_high_micros + spec::wakeup_low_micros);
+  }
+
+  // The task paces the frames itself, at least an inter-frame gap apart.
+  auto payload = reference_payload(RTS::CLOSE, Installation::first_channel_id, 100);
+  uint32_t period = airtime_micros(reference_frame(payload, true)) + spec::inter_frame_gap_micros;
+  for (size_t i = 1; i < frames.size(); i++) {
+    uint32_t spacing = frames[i].start_micros - frames[i - 1].start_micros;
+    CHECK(spacing >= period);
+    CHECK(spacing < period + 1000);
+  }
+
+  auto *result = installation.result_for(handle);
+  CHECK(result != nullptr);
+  if (result != nullptr) {
+    CHECK_EQ(result->result, RTS::COMMAND_TRANSMITTED);
+  }
+  CHECK_EQ(installation.rts.num_pending_commands(), 0u);
+}
+
+RTS_TEST(task_lets_stop_preempt_queued_commands) {
+  Installation installation(4);
+  installation.use_fixed_repetitions(8);
+
+  for (size_t i = 0; i < 4; i++) {
+    installation.rts.schedule_rts_command(RTS::OPEN, installation.channel(i));
+  }
+  run_for(600);
+  installation.rts.schedule_rts_command(RTS::STOP, installation.channel(0));
+  run_until_idle();
+
+  auto frames = installation.frames();
+  CHECK_EQ(frames.size(), 40u);
+  size_t stop_index = 0;
+  while (stop_index < frames.size() && frames[stop_index].control_code != RTS::STOP) {
+    stop_index++;
+  }
+  // The STOP goes out while the first OPEN is still repeating.
+  CHECK(stop_index < 8);
+  CHECK_EQ(installation.results.size(), 5u);
+}
+
+RTS_TEST(task_interleaves_group_command_frames) {
+  Installation installation(3);
+  installation.use_fixed_repetitions(2);
+
+  std::vector<RTSChannel *> channels{installation.channel(0), installation.channel(1), installation.channel(2)};
+  installation.rts.schedule_group_command(RTS::CLOSE, channels);
+  run_until_idle();
+
+  auto frames = installation.frames();
+  CHECK_EQ(installation.wakeups(), 1u);
+  CHECK_EQ(frames.size(), 6u);
+  // Every device gets its first frame before any repetition.
+  for (size_t i = 0; i < frames.size() && i < 3; i++) {
+    CHECK_EQ(frames[i].channel_id, Installation::first_channel_id + i);
+  }
+  CHECK_EQ(installation.results.size(), 3u);
+  for (const auto &result : installation.results) {
+    CHECK_EQ(result.result, RTS::COMMAND_TRANSMITTED);
+  }
+}
+
+RTS_TEST(task_stops_with_commands_left) {
+  Installation installation(2);
+  installation.use_fixed_repetitions(8);
+
+  installation.rts.schedule_rts_command(RTS::OPEN, installation.channel(0));
+  installation.rts.schedule_rts_command(RTS::OPEN, installation.channel(1));
+  run_for(300);
+  // The installation goes away while the task is in the middle of the queue.
+  CHECK(!installation.frames().empty());
+}
+
+RTS_TEST(task_command_takes_over_rolling_code_of_one_it_supersedes) {
+  Installation installation(1);
+  installation.use_fixed_repetitions(2);
+
+  auto open = installation.rts.schedule_rts_command(RTS::OPEN, installation.channel(0));
+  auto close = installation.rts.schedule_rts_command(RTS::CLOSE, installation.channel(0));
+  run_until_idle();
+
+  // The main loop withdraws the OPEN while it waits for the wakeup, so the CLOSE reuses its rolling
+  // code value instead of consuming another.
+  auto frames = installation.frames();
+  CHECK_EQ(frames.size(), 2u);
+  for (const auto &frame : frames) {
+    CHECK_EQ(frame.control_code, RTS::CLOSE);
+    CHECK_EQ(frame.rolling_code, 100);
+  }
+  CHECK_EQ(installation.channel(0)->rolling_code(), 101);
+  CHECK_EQ(installation.rts.coalesced_command_count(), 1u);
+
+  auto *open_result = installation.result_for(open);
+  auto *close_result = installation.result_for(close);
+  CHECK(open_result != nullptr && close_result != nullptr);
+  if (open_result != nullptr && close_result != nullptr) {
+    CHECK_EQ(open_result->result, RTS::COMMAND_SUPERSEDED);
+    CHECK_EQ(close_result->result, RTS::COMMAND_TRANSMITTED);
+  }
+}
+
+RTS_TEST(task_command_that_started_keeps_its_rolling_code) {
+  Installation installation(1);
+  installation.use_fixed_repetitions(4);
+
+  installation.rts.schedule_rts_command(RTS::OPEN, installation.channel(0));
+  // The wakeup, its silence and the first frame.
+  run_for(200);
+  installation.rts.schedule_rts_command(RTS::CLOSE, installation.channel(0));
+  run_until_idle();
+
+  auto frames = installation.frames();
+  CHECK_EQ(frames.size(), 8u);
+  if (frames.size() == 8) {
+    CHECK_EQ(frames[3].control_code, RTS::OPEN);
+    CHECK_EQ(frames[3].rolling_code, 100);
+    CHECK_EQ(frames[4].control_code, RTS::CLOSE);
+    CHECK_EQ(frames[4].rolling_code, 101);
+  }
+  CHECK_EQ(installation.rts.coalesced_command_count(), 0u);
+}
+
+RTS_TEST(task_stop_cancels_command_that_has_not_started) {
+  Installation installation(2);
+  installation.use_fixed_repetitions(2);
+
+  auto open = installation.rts.schedule_rts_command(RTS::OPEN, installation.channel(0));
+  installation.rts.schedule_rts_command(RTS::CLOSE, installation.channel(1));
+  auto stop = installation.rts.schedule_rts_command(RTS::STOP, installation.channel(0));
+  run_until_idle();
+
+  // The task drops the cancelled OPEN, and only the CLOSE goes out.
+  auto frames = installation.frames();
+  CHECK_EQ(frames.size(), 2u);
+  for (const auto &frame : frames) {
+    CHECK_EQ(frame.channel_id, Installation::first_channel_id + 1);
+  }
+  CHECK_EQ(installation.channel(0)->rolling_code(), 101);
+  CHECK_EQ(installation.rts.coalesced_command_count(), 1u);
+
+  auto *open_result = installation.result_for(open);
+  auto *stop_result = installation.result_for(stop);
+  CHECK(open_result != nullptr && stop_result != nullptr);
+  if (open_result != nullptr && stop_result != nullptr) {
+    CHECK_EQ(open_result->result, RTS::COMMAND_SUPERSEDED);
+    CHECK_EQ(stop_result->result, RTS::COMMAND_TRANSMITTED);
+  }
+  CHECK_EQ(installation.rts.num_pending_commands(), 0u);
+}
+
+RTS_TEST(task_streams_hold_in_one_burst) {
+  Installation installation(2);
+  installation.use_fixed_repetitions(2);
+
+  installation.rts.schedule_hold_command(RTS::CLOSE, installation.channel(0), 6);
+  run_for(200);
+  installation.rts.schedule_rts_command(RTS::STOP, installation.channel(1));
+  run_until_idle();
+
+  // The wakeup and the whole stream share one transmission, and the two frames of the STOP follow.
+  CHECK_EQ(installation.transmitter.transmissions().size(), 3u);
+  auto frames = installation.frames();
+  CHECK_EQ(frames.size(), 8u);
+  if (frames.size() == 8) {
+    CHECK_EQ(frames[5].control_code, RTS::CLOSE);
+    CHECK_EQ(frames[6].control_code, RTS::STOP);
+    uint32_t duration_millis = (frames[6].start_micros - frames[0].start_micros) / 1000;
+    CHECK(duration_millis >= RTS::hold_duration_millis(6));
+    CHECK(duration_millis <= RTS::hold_duration_millis(6) + 3);
+  }
+}
+
+RTS_TEST(task_sends_nothing_before_channel_table_is_saved) {
+  Installation installation(3, 16, true);
+  installation.use_fixed_repetitions(2);
+  // Slow saves give the task the time to send anything that it gets before the table is saved.
+  ESPPreferenceObject::write_micros() = 20000;
+
+  installation.rts.schedule_rts_command(RTS::OPEN, installation.channel(0));
+  run_until_idle();
+  CHECK(!installation.transmitter.transmissions().empty());
+  for (const auto &transmission : installation.transmitter.transmissions()) {
+    CHECK_EQ(transmission.preference_saves, 1u);
+  }
+
+  installation.transmitter.clear_transmissions();
+  std::vector<RTSChannel *> channels{installation.channel(1), installation.channel(2)};
+  installation.rts.schedule_group_command(RTS::CLOSE, channels);
+  run_until_idle();
+  CHECK(!installation.transmitter.transmissions().empty());
+  for (const auto &transmission : installation.transmitter.transmissions()) {
+    CHECK_EQ(transmission.preference_saves, 2u);
+  }
+}
@@ -0,0 +1,169 @@
+#include "rts_test_util.h"
+#include "rts_uart.h"
+#include "test.h"
+#include "uart_pty.h"
+
+using namespace rts_test;
+using esphome::rts::RTSUartInterface;
+
+namespace {
+
+// Appends one command to the payload of a batch frame.
+void add_command(std::vector<uint8_t> *batch, uint32_t channel_id, RTS::RTSControlCode control_code,
+                 uint8_t max_repetitions) {
+  batch->push_back(channel_id & 0xff);
+  batch->push_back((channel_id >> 8) & 0xff);
+  batch->push_back((channel_id >> 16) & 0xff);
+  batch->push_back(control_code);
+  batch->push_back(max_repetitions);
+}
+
+struct UartFixture {
+  explicit UartFixture(size_t num_channels) : installation(num_channels) {
+    this->installation.use_fixed_repetitions(2);
+    this->interface.set_uart_parent(this->pty.device());
+    this->interface.set_rts_parent(&this->installation.rts);
+    this->interface.set_max_pending_commands(4);
+    this->interface.setup();
+  }
+
+  Installation installation;
+  UartPty pty;
+  RTSUartInterface interface;
+};
+
+}  // namespace
+
+RTS_TEST(uart_batch_is_acknowledged_and_reported) {
+  UartFixture fixture(3);
+  CHECK(fixture.pty.is_open());
+
+  std::vector<uint8_t> batch{7};
+  add_command(&batch, Installation::first_channel_id, RTS::OPEN, 0);
+  add_command(&batch, Installation::first_channel_id + 1, RTS::CLOSE, 2);
+  add_command(&batch, 0x555555, RTS::STOP, 0);
+  add_command(&batch, Installation::first_channel_id + 2, static_cast<RTS::RTSControlCode>(0x3), 0);
+  fixture.pty.send_frame(RTSUartInterface::FRAME_COMMAND_BATCH, batch);
+  fixture.interface.loop();
+
+  // The acknowledgement, then the commands that could not be scheduled.
+  auto frames = fixture.pty.receive_frames();
+  CHECK_EQ(frames.size(), 3u);
+  if (frames.size() == 3) {
+    CHECK(frames[0].checksum_ok);
+    CHECK_EQ(frames[0].type, RTSUartInterface::FRAME_BATCH_ACK);
+    CHECK(frames[0].payload == std::vector<uint8_t>({7, 2, 2, 16}));
+    CHECK_EQ(frames[1].type, RTSUartInterface::FRAME_COMMAND_DONE);
+    CHECK(frames[1].payload == std::vector<uint8_t>({7, 2, RTSUartInterface::COMMAND_UNKNOWN_CHANNEL, 2}));
+    CHECK(frames[2].payload == std::vector<uint8_t>({7, 3, RTSUartInterface::COMMAND_INVALID_CONTROL_CODE, 2}));
+  }
+
+  esphome::host::run_until_idle();
+  frames = fixture.pty.receive_frames();
+  CHECK_EQ(frames.size(), 2u);
+  for (const auto &frame : frames) {
+    CHECK_EQ(frame.type, RTSUartInterface::FRAME_COMMAND_DONE);
+    CHECK_EQ(frame.payload.size(), 4u);
+    if (frame.payload.size() == 4) {
+      CHECK_EQ(frame.payload[0], 7);
+      CHECK(frame.payload[1] < 2);
+      CHECK_EQ(frame.payload[2], RTS::COMMAND_TRANSMITTED);
+    }
+  }
+  CHECK_EQ(fixture.installation.frames().size(), 4u);
+}
+
+RTS_TEST(uart_rejects_commands_beyond_tracking_limit) {
+  UartFixture fixture(6);
+
+  std::vector<uint8_t> batch{1};
+  for (uint32_t i = 0; i < 6; i++) {
+    add_command(&batch, Installation::first_channel_id + i, RTS::OPEN, 0);
+  }
+  fixture.pty.send_frame(RTSUartInterface::FRAME_COMMAND_BATCH, batch);
+  fixture.interface.loop();
+
+  auto frames = fixture.pty.receive_frames();
+  CHECK_EQ(frames.size(), 3u);
+  if (frames.size() == 3) {
+    CHECK_EQ(frames[0].payload[1], 4);
+    CHECK_EQ(frames[1].payload[2], RTS::COMMAND_REJECTED);
+    CHECK_EQ(frames[2].payload[2], RTS::COMMAND_REJECTED);
+  }
+
+  fixture.pty.send_frame(RTSUartInterface::FRAME_STATUS_REQUEST, {});
+  fixture.interface.loop();
+  frames = fixture.pty.receive_frames();
+  CHECK_EQ(frames.size(), 1u);
+  if (frames.size() == 1) {
+    CHECK_EQ(frames[0].type, RTSUartInterface::FRAME_STATUS);
+    CHECK(frames[0].payload == std::vector<uint8_t>({4, 16, 0}));
+  }
+}
+
+RTS_TEST(uart_reports_broken_frames) {
+  UartFixture fixture(1);
+
+  // Noise before a frame is skipped, a bad checksum and an unknown type are reported.
+  fixture.pty.send_raw({0x00, 0x13, 0xa5, RTSUartInterface::FRAME_STATUS_REQUEST, 0x00, 0x42});
+  fixture.pty.send_frame(0x33, {});
+  fixture.interface.loop();
+  auto frames = fixture.pty.receive_frames();
+  CHECK_EQ(frames.size(), 2u);
+  if (frames.size() == 2) {
+    CHECK_EQ(frames[0].type, RTSUartInterface::FRAME_ERROR);
+    CHECK_EQ(frames[0].payload[0], RTSUartInterface::ERROR_CHECKSUM);
+    CHECK_EQ(frames[1].payload[0], RTSUartInterface::ERROR_UNKNOWN_TYPE);
+  }
+
+  // A batch whose size is not a whole number of commands.
+  fixture.pty.send_frame(RTSUartInterface::FRAME_COMMAND_BATCH, {1, 2, 3});
+  fixture.interface.loop();
+  frames = fixture.pty.receive_frames();
+  CHECK_EQ(frames.size(), 1u);
+  if (frames.size() == 1) {
+    CHECK_EQ(frames[0].payload[0], RTSUartInterface::ERROR_LENGTH);
+  }
+
+  // A frame that stops arriving halfway.
+  fixture.pty.send_raw({0xa5, RTSUartInterface::FRAME_COMMAND_BATCH, 6, 1});
+  fixture.interface.loop();
+  esphome::host::run_for(RTSUartInterface::frame_timeout_millis + 1);
+  fixture.interface.loop();
+  frames = fixture.pty.receive_frames();
+  CHECK_EQ(frames.size(), 1u);
+  if (frames.size() == 1) {
+    CHECK_EQ(frames[0].payload[0], RTSUartInterface::ERROR_TIMEOUT);
+  }
+}
+
+RTS_TEST(uart_keeps_frame_whose_bytes_arrived_while_loop_was_busy) {
+  UartFixture fixture(1);
+
+  // The controller stalls halfway through a frame, and sends the rest in time, but the main loop
+  // only gets to it after the frame timeout.
+  const uint8_t header[] = {RTSUartInterface::FRAME_STATUS_REQUEST, 0x00};
+  fixture.pty.send_raw({0xa5, header[0]});
+  fixture.interface.loop();
+  esphome::host::run_for(RTSUartInterface::frame_timeout_millis / 2);
+  fixture.pty.send_raw({header[1], esphome::crc8(header, sizeof(header))});
+  esphome::host::run_for(RTSUartInterface::frame_timeout_millis);
+  fixture.interface.loop();
+
+  auto frames = fixture.pty.receive_frames();
+  CHECK_EQ(frames.size(), 1u);
+  if (frames.size() == 1) {
+    CHECK_EQ(frames[0].type, RTSUartInterface::FRAME_STATUS);
+  }
+
+  // Once the rest of a frame stops arriving, it still times out.
+  fixture.pty.send_raw({0xa5, RTSUartInterface::FRAME_STATUS_REQUEST});
+  fixture.interface.loop();
+  esphome::host::run_for(RTSUartInterface::frame_timeout_millis + 1);
+  fixture.interface.loop();
+  frames = fixture.pty.receive_frames();
+  CHECK_EQ(frames.size(), 1u);
+  if (frames.size() == 1) {
+    CHECK_EQ(frames[0].payload[0], RTSUartInterface::ERROR_TIMEOUT);
+  }
+}
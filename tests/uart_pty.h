@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <pty.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "esphome/components/uart/uart.h"
+#include "esphome/core/helpers.h"
+
+namespace rts_test {
+
+// Pseudo-terminal that stands in for the serial line to an external controller. RTS gets the
+// device side as its UART, and the test talks through the controller side.
+class UartPty {
+ public:
+  UartPty() {
+    ::openpty(&this->controller_fd_, &this->device_fd_, nullptr, nullptr, nullptr);
+    termios attributes;
+    ::tcgetattr(this->device_fd_, &attributes);
+    ::cfmakeraw(&attributes);
+    ::tcsetattr(this->device_fd_, TCSANOW, &attributes);
+    ::fcntl(this->controller_fd_, F_SETFL, ::fcntl(this->controller_fd_, F_GETFL) | O_NONBLOCK);
+    this->device_.reset(new esphome::uart::UARTComponent(this->device_fd_));
+  }
+  ~UartPty() {
+    ::close(this->controller_fd_);
+    ::close(this->device_fd_);
+  }
+
+  bool is_open() const { return this->controller_fd_ >= 0 && this->device_fd_ >= 0; }
+  esphome::uart::UARTComponent *device() { return this->device_.get(); }
+
+  // Sends a frame from the controller, with the start byte, length and checksum added.
+  void send_frame(uint8_t type, const std::vector<uint8_t> &payload) {
+    std::vector<uint8_t> frame{type, static_cast<uint8_t>(payload.size())};
+    frame.insert(frame.end(), payload.begin(), payload.end());
+    frame.push_back(esphome::crc8(frame.data(), frame.size()));
+    frame.insert(frame.begin(), 0xa5);
+    this->send_raw(frame);
+  }
+
+  void send_raw(const std::vector<uint8_t> &bytes) {
+    size_t expected_size = this->device_available_() + bytes.size();
+    size_t offset = 0;
+    while (offset < bytes.size()) {
+      ssize_t written = ::write(this->controller_fd_, bytes.data() + offset, bytes.size() - offset);
+      if (written < 0) {
+        pollfd poll_fd{this->controller_fd_, POLLOUT, 0};
+        ::poll(&poll_fd, 1, 100);
+        continue;
+      }
+      offset += written;
+    }
+    // Give the line discipline time to move all of the bytes to the device side, so that the next
+    // read there sees them together.
+    for (int i = 0; i < 100 && this->device_available_() < expected_size; i++) {
+      ::usleep(1000);
+    }
+  }
+
+  struct Frame {
+    uint8_t type;
+    std::vector<uint8_t> payload;
+    bool checksum_ok;
+  };
+
+  // Reads every frame that the device side has written so far.
+  std::vector<Frame> receive_frames() {
+    uint8_t buffer[256];
+    int timeout_millis = 20;
+    while (true) {
+      pollfd poll_fd{this->controller_fd_, POLLIN, 0};
+      if (::poll(&poll_fd, 1, timeout_millis) <= 0) {
+        break;
+      }
+      timeout_millis = 0;
+      ssize_t size = ::read(this->controller_fd_, buffer, sizeof(buffer));
+      if (size <= 0) {
+        break;
+      }
+      this->received_.insert(this->received_.end(), buffer, buffer + size);
+    }
+
+    std::vector<Frame> frames;
+    size_t offset = 0;
+    while (offset + 4 <= this->received_.size() && this->received_[offset] == 0xa5) {
+      size_t size = this->received_[offset + 2];
+      if (offset + 4 + size > this->received_.size()) {
+        break;
+      }
+      const uint8_t *frame = this->received_.data() + offset + 1;
+      frames.push_back({frame[0], std::vector<uint8_t>(frame + 2, frame + 2 + size),
+                        esphome::crc8(frame, 2 + size) == frame[2 + size]});
+      offset += 4 + size;
+    }
+    this->received_.erase(this->received_.begin(), this->received_.begin() + offset);
+    return frames;
+  }
+
+ protected:
+  size_t device_available_() const {
+    int available = 0;
+    return ::ioctl(this->device_fd_, FIONREAD, &available) == 0 ? available : 0;
+  }
+
+  int controller_fd_{-1};
+  int device_fd_{-1};
+  std::unique_ptr<esphome::uart::UARTComponent> device_;
+  std::vector<uint8_t> received_;
+};
+
+}  // namespace rts_test